@@ -0,0 +1,885 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *  @file MainBench.cpp
+ *  @brief cpp2cxx-bench, times the stages of the demacrofier one at a time
+ *  (lexer, span lexer, the slex lexer on both layouts of its dfa tables,
+ *  Parser::ParseMacros, CondParser, RlParser, Demacrofier::Translate
+ *  and DepAnalyzer) over the test inputs, over generated large inputs, over
+ *  generated macro heavy configuration headers and over generated headers
+ *  of many macros depending upon each other.
+ *  The results are written as JSON so that runs can be compared over time.
+ *
+ *  typical command line:
+ *  ./cpp2cxx-bench --input-directory=tests --generate-mb=16 --generate-header-mb=4 --generate-dep-macros=100000 -r 5 -o bench.json
+ */
+
+#include "cpp2cxx/CondParser.h"
+#include "cpp2cxx/DemacroficationScheme.h"
+#include "cpp2cxx/Demacrofier.h"
+#include "cpp2cxx/DepAnalyzer.h"
+#include "cpp2cxx/ExceptionHandler.h"
+#include "cpp2cxx/LexerBackend.h"
+#include "cpp2cxx/LexerScopeClassifier.h"
+#include "cpp2cxx/ParallelLexer.h"
+#include "cpp2cxx/Parser.h"
+#include "cpp2cxx/RlParser.h"
+#include "cpp2cxx/SourceBuffer.h"
+#include "cpp2cxx/SourceSpanScanner.h"
+#include "cpp2cxx/TokenArena.h"
+
+#include "general_utilities/process_memory.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace po = boost::program_options;
+
+namespace
+{
+
+/// the language options the Parser lexes the local macros with
+const auto benchLanguage = boost::wave::language_support(boost::wave::support_cpp
+                                                         | boost::wave::support_option_long_long
+                                                         | boost::wave::support_option_emit_contnewlines);
+
+/**
+ * @class DiscardBuffer
+ * @brief the log and stat output of the stages is formatted but not kept
+ */
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override
+    {
+        return traits_type::not_eof(c);
+    }
+};
+
+/**
+ * @class Stopwatch
+ * @brief accumulates the time between Start and Stop, so that a stage can
+ * leave its setup out of the measurement
+ */
+class Stopwatch
+{
+public:
+    void Start()
+    {
+        start = std::chrono::steady_clock::now();
+    }
+
+    void Stop()
+    {
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    double Seconds() const
+    {
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration elapsed{ 0 };
+};
+
+/**
+ * @struct StageResult
+ * @brief units counts what the stage works on (tokens, conditions or
+ * macros), tokens and bytes are the input it consumed, for the macro
+ * stages the tokens and bytes of the replacement lists
+ */
+struct StageResult
+{
+    std::string stage;
+    std::string unit;
+    std::size_t units{ 0 };
+    std::size_t tokens{ 0 };
+    std::size_t bytes{ 0 };
+    std::vector<double> seconds; // one per repetition
+    std::string error;
+
+    double Median() const
+    {
+        if(seconds.empty())
+        {
+            return 0.0;
+        }
+        std::vector<double> sorted(seconds);
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+};
+
+/**
+ * @struct InputResult
+ * @brief the stages of one input file or of one generated input
+ */
+struct InputResult
+{
+    std::string name;
+    std::string kind; // file, generated, header or dependency
+    std::size_t bytes{ 0 };
+    std::vector<StageResult> stages;
+};
+
+struct BenchOptions
+{
+    LexerBackend backend{ LexerBackend::slex };
+    std::size_t repetitions{ 5 };
+};
+
+/// @brief runs the stage once to warm up and then once per repetition,
+/// each run does its own setup and times the measured part with the watch
+template <typename Stage>
+void Measure(StageResult& result, std::size_t repetitions, Stage stage)
+{
+    try
+    {
+        for(std::size_t run = 0; run <= repetitions; ++run)
+        {
+            Stopwatch watch;
+            stage(watch);
+            if(run != 0)
+            {
+                result.seconds.push_back(watch.Seconds());
+            }
+        }
+    }
+    catch(ExceptionHandler& e)
+    {
+        result.seconds.clear();
+        result.error = e.GetExMessage();
+    }
+    catch(std::exception& e)
+    {
+        result.seconds.clear();
+        result.error = e.what();
+    }
+}
+
+std::size_t TokenBytes(std::vector<token_type> const& toks)
+{
+    std::size_t bytes = 0;
+    for(auto const& tok : toks)
+    {
+        bytes += tok.get_value().size();
+    }
+    return bytes;
+}
+
+/// @brief lexes and parses the contents once per stage and repetition,
+/// the scopes come from the LexerScopeClassifier as with --front-end=lexer
+InputResult BenchInput(std::string const& name, std::string const& kind,
+        std::string_view contents, BenchOptions const& options,
+        DemacroficationScheme const& scheme, GlobalMacros_t const& global_macros)
+{
+    DiscardBuffer discard_buffer;
+    std::ostream discard(&discard_buffer);
+
+    InputResult input{ name, kind, contents.size(), {} };
+    // indexed once for all the stages, as the SourceBuffer of a file is
+    const boost::wave::cpplexer::source_index line_index(
+            name, contents.data(), contents.data() + contents.size());
+    const position_type pos = line_index.position();
+
+    // the slex lexer (or the one chosen by --lexer) over the whole file
+    StageResult lex{ "lexer", "tokens" };
+    TokenArena arena;
+    Measure(lex, options.repetitions, [&](Stopwatch& watch) {
+        watch.Start();
+        if(scheme.lexerThreads == 1)
+        {
+            arena.Lex(MakeLexerIterator(options.backend, contents, pos, benchLanguage), lexer_iterator());
+        }
+        else
+        {
+            arena.Assign(LexInParallel(options.backend, contents, pos, benchLanguage, scheme.lexerThreads));
+        }
+        watch.Stop();
+        lex.units = lex.tokens = arena.size();
+        lex.bytes = contents.size();
+    });
+    input.stages.push_back(lex);
+    if(!lex.error.empty())
+    {
+        return input;
+    }
+
+    // the same lexer over the spans of SourceSpanScanner, as the Parser lexes
+    // a file without the scope classifier; the scan is part of the time and
+    // each skipped span is a single token
+    StageResult span_lex{ "span_lexer", "tokens" };
+    Measure(span_lex, options.repetitions, [&](Stopwatch& watch) {
+        TokenArena span_arena;
+        watch.Start();
+        const SourceSpans spans = ScanSourceSpans(contents, {});
+        if(!spans.usable)
+        {
+            throw ExceptionHandler("the spans of the input can't be scanned, it is lexed as a whole");
+        }
+        if(scheme.lexerThreads == 1)
+        {
+            span_arena.Lex(MakeSpanTokenIterator(contents, spans, pos, benchLanguage, options.backend),
+                    lexer_iterator());
+        }
+        else
+        {
+            span_arena.Assign(LexSpansInParallel(
+                    options.backend, contents, spans, pos, benchLanguage, scheme.lexerThreads));
+        }
+        watch.Stop();
+        span_lex.units = span_lex.tokens = span_arena.size();
+        span_lex.bytes = contents.size();
+    });
+    input.stages.push_back(span_lex);
+
+    // the slex lexer on the full rows and on the byte class dfa tables,
+    // on the calling thread whatever --lexer and --lex-threads are
+    for(auto const& [layout_stage, layout_backend] :
+            { std::pair{ "slex_full_rows", LexerBackend::slex },
+                    std::pair{ "slex_byte_classes", LexerBackend::slexByteClasses } })
+    {
+        StageResult layout{ layout_stage, "tokens" };
+        Measure(layout, options.repetitions, [&](Stopwatch& watch) {
+            TokenArena layout_arena;
+            watch.Start();
+            layout_arena.Lex(MakeLexerIterator(layout_backend, contents, pos, benchLanguage), lexer_iterator());
+            watch.Stop();
+            layout.units = layout.tokens = layout_arena.size();
+            layout.bytes = contents.size();
+        });
+        input.stages.push_back(layout);
+    }
+
+    // Parser::ParseMacros over tokens lexed beforehand, the Parser of the
+    // last repetition is kept for the stages below
+    StageResult parse{ "parse_macros", "macros" };
+    ASTMacroStat_t macro_stat;
+    std::unique_ptr<LexerScopeClassifier> classifier;
+    std::unique_ptr<Parser> parser;
+    Measure(parse, options.repetitions, [&](Stopwatch& watch) {
+        parser.reset();
+        macro_stat.clear();
+        classifier = std::make_unique<LexerScopeClassifier>(macro_stat);
+        parser = std::make_unique<Parser>(scheme, discard, global_macros);
+        parser->SetScopeClassifier(classifier.get());
+        parser->LexLocalMacros(contents, pos);
+
+        MacroList_t local_macros;
+        watch.Start();
+        parser->ParseMacros(local_macros);
+        watch.Stop();
+        parse.units = parser->GetMacroCount();
+        parse.tokens = arena.size();
+        parse.bytes = contents.size();
+    });
+    input.stages.push_back(parse);
+    if(!parse.error.empty())
+    {
+        return input;
+    }
+
+    // every #if and #elif of the file, as PPIfHandler passes them
+    StageResult cond{ "cond_parser", "conditions" };
+    CondParser cond_parser(global_macros);
+    Measure(cond, options.repetitions, [&](Stopwatch& watch) {
+        std::size_t conditions = 0;
+        std::size_t tokens = 0;
+        std::size_t bytes = 0;
+        watch.Start();
+        for(auto t_it = arena.begin(); t_it != arena.end(); ++t_it)
+        {
+            if(auto id = boost::wave::token_id(*t_it);
+                    id == boost::wave::T_PP_IF || id == boost::wave::T_PP_ELIF)
+            {
+                Node node;
+                cond_parser.ParseConditions(node, t_it);
+                const token_iterator cond_end = cond_parser.GetTokenPosition();
+                ++conditions;
+                tokens += cond_end - t_it;
+                if(cond_end != arena.end())
+                {
+                    bytes += cond_end->get_position().get_offset() - t_it->get_position().get_offset();
+                }
+            }
+        }
+        watch.Stop();
+        cond.units = conditions;
+        cond.tokens = tokens;
+        cond.bytes = bytes;
+    });
+    input.stages.push_back(cond);
+
+    // the macros in the order they were defined, the #undefs are left out
+    DepList_t const& dep_list = parser->GetMacTree()->BuildMacroDependencyList();
+    std::vector<PPMacro*> macros;
+    std::size_t rl_tokens = 0;
+    std::size_t rl_bytes = 0;
+    for(auto const& [macro, deps] : dep_list)
+    {
+        if(macro->operation == PPOperation::define)
+        {
+            macros.push_back(macro);
+            rl_tokens += macro->rep_list.get_replacement_list_tokens().size();
+            rl_bytes += TokenBytes(macro->rep_list.get_replacement_list_tokens());
+        }
+    }
+
+    StageResult rl{ "rl_parser", "macros" };
+    RlParser rl_parser(scheme, discard);
+    Measure(rl, options.repetitions, [&](Stopwatch& watch) {
+        watch.Start();
+        for(PPMacro* macro : macros)
+        {
+            rl_parser.Parse(macro->rep_list);
+        }
+        watch.Stop();
+        rl.units = macros.size();
+        rl.tokens = rl_tokens;
+        rl.bytes = rl_bytes;
+    });
+    input.stages.push_back(rl);
+
+    // as Parser::Demacrofy, a new Demacrofier so the ready queue starts empty
+    StageResult translate{ "demacrofier_translate", "macros" };
+    Measure(translate, options.repetitions, [&](Stopwatch& watch) {
+        Demacrofier demacrofier;
+        demacrofier.SetASTStat(&macro_stat);
+        demacrofier.SetValidator(&scheme.validatorMap.GetValidMacros());
+        watch.Start();
+        for(PPMacro const* macro : macros)
+        {
+            demacrofier.Translate(macro, discard, scheme.performCleanup, true);
+        }
+        watch.Stop();
+        translate.units = macros.size();
+        translate.tokens = rl_tokens;
+        translate.bytes = rl_bytes;
+    });
+    input.stages.push_back(translate);
+
+    // as Parser::PPBuildMacroDependencyList, the list itself is built once
+    StageResult dep{ "dep_analyzer", "macros" };
+    Measure(dep, options.repetitions, [&](Stopwatch& watch) {
+        std::vector<PPMacro*> order;
+        watch.Start();
+        DepAnalyzer<PPMacro> macro_dep(dep_list);
+        macro_dep.MakeGraph();
+        macro_dep.DoTopologicalSort(order);
+        macro_dep.CheckTotalOrder(discard);
+        watch.Stop();
+        dep.units = dep_list.size();
+        dep.tokens = rl_tokens;
+        dep.bytes = rl_bytes;
+    });
+    input.stages.push_back(dep);
+
+    return input;
+}
+
+/**
+ * @brief a translation unit of about bytes bytes made of blocks of object
+ * like, function like, statement and string macros, conditionals over the
+ * earlier macros, a function using the macros (some defined inside of it)
+ * and every 16th block a macro using one defined after it. The same seed
+ * gives the same source on every platform.
+ */
+std::string GenerateSource(std::size_t bytes, std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::string source;
+    source.reserve(bytes + 1024);
+
+    for(std::size_t n = 0; source.size() < bytes; ++n)
+    {
+        const std::size_t prev = n == 0 ? 0 : n - 1 - rng() % std::min<std::size_t>(n, 8);
+
+        source += fmt::format("/* block {} of the generated input */\n", n);
+        source += fmt::format("#define OBJ_{} {}\n", n, rng() % 1000);
+        source += fmt::format("#define FUN_{0}(a, b) ((a) * OBJ_{1} + (b) - OBJ_{0})\n", n, prev);
+        source += fmt::format("#define STMT_{0}(x) do {{ (x) += FUN_{0}(x, {1}); }} while(0)\n",
+                n, rng() % 64);
+        source += fmt::format("#define STR_{0} \"generated string {0}\"\n", n);
+        source += fmt::format("#if defined(OBJ_{0}) && OBJ_{0} > {1}\n", prev, rng() % 1000);
+        source += fmt::format("#define COND_{} (OBJ_{} + 1)\n", n, prev);
+        source += fmt::format("#elif FUN_{}(1, 2) > {}\n", prev, rng() % 1000);
+        source += fmt::format("#define COND_{} 2\n", n);
+        source += "#else\n";
+        source += fmt::format("#define COND_{} 0\n", n);
+        source += "#endif\n";
+        if(n % 16 == 15)
+        {
+            source += fmt::format("#define LATE_{} (OBJ_{} << 1)\n", n, n + 1);
+        }
+        source += fmt::format("struct s_{} {{ int v; double d; char const* s; }};\n", n);
+        source += fmt::format("// uses the macros of block {}\n", n);
+        source += fmt::format("static int f_{}(int a)\n{{\n", n);
+        if(n % 4 == 0)
+        {
+            source += fmt::format("#define LOCAL_{}(x) ((x) + COND_{})\n", n, n);
+            source += fmt::format("    a = LOCAL_{}(a);\n", n);
+        }
+        source += fmt::format("    int r = FUN_{}(a, 0x{:x});\n", n, rng() % 4096);
+        source += fmt::format("    STMT_{}(r);\n", n);
+        source += fmt::format("    if(r > {}) {{ r -= COND_{}; }}\n", rng() % 100, n);
+        source += fmt::format("    return r + 'c' + static_cast<int>(sizeof(STR_{}));\n}}\n\n", n);
+    }
+
+    return source;
+}
+
+/**
+ * @brief a configuration header of about bytes bytes like the ones of large
+ * portable libraries: #if ladders over the platforms defining the same
+ * macros once per platform, macros built from earlier ones and inline
+ * functions using many identifiers of which only some are macros. Nearly
+ * every token is an identifier which the Parser looks up as a macro.
+ */
+std::string GenerateMacroHeader(std::size_t bytes, std::uint32_t seed)
+{
+    static constexpr const char* platforms[] = { "_WIN32", "__APPLE__", "__linux__", "__FreeBSD__", "__sun" };
+
+    std::mt19937 rng(seed);
+    std::string source;
+    source.reserve(bytes + 1024);
+
+    for(std::size_t n = 0; source.size() < bytes; ++n)
+    {
+        const std::size_t prev = n == 0 ? 0 : rng() % n;
+
+        for(std::size_t p = 0; p < std::size(platforms); ++p)
+        {
+            source += fmt::format("#{} defined({})\n", p == 0 ? "if" : "elif", platforms[p]);
+            source += fmt::format("#define CFG_{}_SIZE {}\n", n, rng() % 256);
+            source += fmt::format("#define CFG_{0}_CALL(x) cfg_{0}_{1}(x, CFG_{2}_SIZE)\n", n, p, prev);
+        }
+        source += "#endif\n";
+        source += fmt::format("#define CFG_{0}_FLAGS (CFG_{0}_SIZE | CFG_{1}_SIZE << {2})\n", n, prev,
+                rng() % 16);
+        source += fmt::format("static inline int cfg_use_{}(int value, int other)\n{{\n", n);
+        source += fmt::format("    int result = CFG_{0}_CALL(value) + other * CFG_{0}_FLAGS;\n", n);
+        source += fmt::format("    result += cfg_helper(value, other, result) - CFG_{}_SIZE;\n", prev);
+        source += "    return result;\n}\n\n";
+    }
+
+    return source;
+}
+
+/**
+ * @brief a header of object like macros each using up to three of
+ * the ones defined shortly before it, every 64th also using a macro defined
+ * at the end of the header, which the DepAnalyzer reports as out of order.
+ * There are no conditionals and no code, so the time goes to the
+ * dependency graph of the macros.
+ */
+std::string GenerateDependencyHeader(std::size_t macros, std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::string source;
+    source.reserve(macros * 48);
+
+    std::size_t late = 0;
+    for(std::size_t n = 0; n < macros; ++n)
+    {
+        source += fmt::format("#define DEP_{} ({}", n, rng() % 1000);
+        for(std::size_t d = 0, uses = std::min<std::size_t>(n, rng() % 4); d < uses; ++d)
+        {
+            source += fmt::format(" + DEP_{}", n - 1 - rng() % std::min<std::size_t>(n, 32));
+        }
+        if(n % 64 == 63)
+        {
+            source += fmt::format(" + LATE_{}", late++);
+        }
+        source += ")\n";
+    }
+    for(std::size_t n = 0; n < late; ++n)
+    {
+        source += fmt::format("#define LATE_{} {}\n", n, rng() % 1000);
+    }
+
+    return source;
+}
+
+/// @brief the string as a JSON string literal
+std::string JsonString(std::string_view str)
+{
+    std::string quoted = "\"";
+    for(const char c : str)
+    {
+        switch(c)
+        {
+        case '"':
+            quoted += "\\\"";
+            break;
+        case '\\':
+            quoted += "\\\\";
+            break;
+        case '\n':
+            quoted += "\\n";
+            break;
+        case '\t':
+            quoted += "\\t";
+            break;
+        default:
+            if(static_cast<unsigned char>(c) < 0x20)
+            {
+                quoted += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+            }
+            else
+            {
+                quoted += c;
+            }
+            break;
+        }
+    }
+    return quoted += '"';
+}
+
+/// @brief amount per second, 0 when the time was too short to measure
+double Rate(double amount, double seconds)
+{
+    return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+void WriteStage(std::ostream& os, StageResult const& stage, char const* indent)
+{
+    fmt::print(os, "{0}{{\n{0}  \"stage\": {1},\n{0}  \"unit\": {2},\n", indent,
+            JsonString(stage.stage), JsonString(stage.unit));
+    fmt::print(os, "{0}  \"units\": {1},\n{0}  \"tokens\": {2},\n{0}  \"bytes\": {3},\n", indent,
+            stage.units, stage.tokens, stage.bytes);
+    if(!stage.error.empty())
+    {
+        fmt::print(os, "{}  \"error\": {}\n{}}}", indent, JsonString(stage.error), indent);
+        return;
+    }
+
+    const double median = stage.Median();
+    const auto [min, max] = std::minmax_element(stage.seconds.begin(), stage.seconds.end());
+    fmt::print(os, "{0}  \"seconds\": {{ \"min\": {1}, \"median\": {2}, \"max\": {3} }},\n", indent,
+            *min, median, *max);
+    fmt::print(os, "{0}  \"units_per_second\": {1},\n{0}  \"tokens_per_second\": {2},\n", indent,
+            Rate(stage.units, median), Rate(stage.tokens, median));
+    fmt::print(os, "{0}  \"megabytes_per_second\": {1}\n{0}}}", indent,
+            Rate(stage.bytes / 1e6, median));
+}
+
+/// @brief the stages summed over the inputs of one kind, the times are
+/// the sums of the medians
+std::vector<StageResult> Totals(std::vector<InputResult> const& inputs, std::string const& kind)
+{
+    std::vector<StageResult> totals;
+    for(auto const& input : inputs)
+    {
+        if(input.kind != kind)
+        {
+            continue;
+        }
+        for(auto const& stage : input.stages)
+        {
+            auto total = std::find_if(totals.begin(), totals.end(),
+                    [&stage](StageResult const& t) { return t.stage == stage.stage; });
+            if(total == totals.end())
+            {
+                total = totals.insert(totals.end(), StageResult{ stage.stage, stage.unit });
+                total->seconds.push_back(0.0);
+            }
+            if(!stage.error.empty())
+            {
+                continue;
+            }
+            total->units += stage.units;
+            total->tokens += stage.tokens;
+            total->bytes += stage.bytes;
+            total->seconds.front() += stage.Median();
+        }
+    }
+    return totals;
+}
+
+void WriteJson(std::ostream& os, std::vector<InputResult> const& inputs, std::string const& lexer,
+        DemacroficationScheme const& scheme, BenchOptions const& options)
+{
+    fmt::print(os, "{{\n  \"benchmark\": \"cpp2cxx-bench\",\n  \"version\": 1,\n");
+    fmt::print(os, "  \"timestamp\": \"{:%Y-%m-%dT%H:%M:%SZ}\",\n", fmt::gmtime(std::time(nullptr)));
+    fmt::print(os, "  \"lexer\": {},\n  \"lex_threads\": {},\n", JsonString(lexer), scheme.lexerThreads);
+    fmt::print(os, "  \"hardware_threads\": {},\n  \"repetitions\": {},\n",
+            std::thread::hardware_concurrency(), options.repetitions);
+
+    fmt::print(os, "  \"inputs\": [");
+    for(std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        auto const& input = inputs[i];
+        fmt::print(os, "{}\n    {{\n      \"name\": {},\n      \"kind\": {},\n", i == 0 ? "" : ",",
+                JsonString(input.name), JsonString(input.kind));
+        fmt::print(os, "      \"bytes\": {},\n      \"stages\": [", input.bytes);
+        for(std::size_t s = 0; s < input.stages.size(); ++s)
+        {
+            fmt::print(os, "{}\n", s == 0 ? "" : ",");
+            WriteStage(os, input.stages[s], "        ");
+        }
+        fmt::print(os, "\n      ]\n    }}");
+    }
+    fmt::print(os, "\n  ],\n");
+
+    fmt::print(os, "  \"totals\": {{");
+    const char* separator = "";
+    for(std::string const kind : { "file", "generated", "header", "dependency" })
+    {
+        const auto totals = Totals(inputs, kind);
+        if(totals.empty())
+        {
+            continue;
+        }
+        fmt::print(os, "{}\n    {}: [", separator, JsonString(kind));
+        for(std::size_t s = 0; s < totals.size(); ++s)
+        {
+            fmt::print(os, "{}\n", s == 0 ? "" : ",");
+            WriteStage(os, totals[s], "      ");
+        }
+        fmt::print(os, "\n    ]");
+        separator = ",";
+    }
+    fmt::print(os, "\n  }},\n");
+    fmt::print(os, "  \"peak_rss_bytes\": {}\n}}\n", general_utilities::peakResidentBytes());
+}
+
+void PrintSummary(InputResult const& input)
+{
+    fmt::print("{} ({} bytes)\n", input.name, input.bytes);
+    for(auto const& stage : input.stages)
+    {
+        if(!stage.error.empty())
+        {
+            fmt::print("  {:<22} error: {}\n", stage.stage, stage.error);
+            continue;
+        }
+        const double median = stage.Median();
+        fmt::print("  {:<22} {:>12.6f} s {:>14.0f} tokens/s {:>10.2f} MB/s\n", stage.stage, median,
+                Rate(stage.tokens, median), Rate(stage.bytes / 1e6, median));
+    }
+}
+
+} // namespace
+
+/**
+ * @main
+ * without input files the .cpp files of the input directory are used,
+ * every --generate-mb adds a generated input of that many megabytes and
+ * every --generate-header-mb a generated macro heavy header and every
+ * --generate-dep-macros a generated header of that many dependent macros
+ */
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::vector<std::filesystem::path> input_files;
+        std::filesystem::path input_directory;
+        std::vector<std::size_t> generate_mb;
+        std::vector<std::size_t> generate_header_mb;
+        std::vector<std::size_t> generate_dep_macros;
+        std::filesystem::path output_file;
+        std::string global_macros_formatted;
+        std::string predefined_macros;
+        std::string lexer_backend;
+        std::size_t lexer_threads = 1;
+        std::uint32_t seed = 2012;
+        BenchOptions options;
+
+        po::options_description bench_options("Allowed options");
+        bench_options.add_options()("help,h", "produce help message")("input-file,i",
+                po::value<std::vector<std::filesystem::path>>(&input_files),
+                "input file, replaces the files of the input directory")("input-directory",
+                po::value<std::filesystem::path>(&input_directory)->default_value("tests"),
+                "directory whose .cpp files are benchmarked when no input file is given")(
+                "generate-mb",
+                po::value<std::vector<std::size_t>>(&generate_mb)
+                        ->default_value(std::vector<std::size_t>{ 8 }, "8"),
+                "size in megabytes of a generated input, may be repeated, 0 generates none")(
+                "generate-header-mb",
+                po::value<std::vector<std::size_t>>(&generate_header_mb)
+                        ->default_value(std::vector<std::size_t>{ 2 }, "2"),
+                "size in megabytes of a generated macro heavy header, may be repeated, 0 generates none")(
+                "generate-dep-macros",
+                po::value<std::vector<std::size_t>>(&generate_dep_macros)
+                        ->default_value(std::vector<std::size_t>{ 100000 }, "100000"),
+                "number of macros of a generated header of dependent macros, may be repeated, 0 generates none")("seed",
+                po::value<std::uint32_t>(&seed)->default_value(2012),
+                "seed of the generated inputs")("repetitions,r",
+                po::value<std::size_t>(&options.repetitions)->default_value(5),
+                "timed runs of every stage, after one untimed run")("output-file,o",
+                po::value<std::filesystem::path>(&output_file)->default_value("cpp2cxx-bench.json"),
+                "file where the results are written as JSON")("global-macros-formatted",
+                po::value<std::string>(&global_macros_formatted),
+                "file containing global macros formatted in following way\n<Macro-id>\n<Replacement-list>\nor its binary snapshot (<file>.snapshot)")(
+                "predefined-macros", po::value<std::string>(&predefined_macros)->default_value("file"),
+                "where the predefined macros come from, either file (global-macros-formatted, none without it) or clang")(
+                "lexer", po::value<std::string>(&lexer_backend)->default_value("slex"),
+                "the lexer which tokenizes the files, either slex, slex-classes (byte class dfa tables), hand (written) or wave (Boost.Wave re2c)")(
+                "lex-threads", po::value<std::size_t>(&lexer_threads)->default_value(1),
+                "number of threads lexing a large file (from 1 MB on), 0 uses all hardware threads");
+
+        po::positional_options_description positional;
+        positional.add("input-file", -1);
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(bench_options).positional(positional).run(),
+                vm);
+        po::notify(vm);
+
+        if(vm.count("help"))
+        {
+            fmt::print("usage: cpp2cxx-bench [options] [input files]\n{}", bench_options);
+            return 0;
+        }
+
+        if(options.repetitions == 0)
+        {
+            fmt::print(std::cerr, "Error: at least one repetition is needed.\n{}", bench_options);
+            return -1;
+        }
+
+        options.backend = ParseLexerBackend(lexer_backend);
+
+        DemacroficationScheme scheme{};
+        scheme.demacroficationGranularity = "OneFileAtATime";
+        scheme.frontEndMode = "lexer";
+        scheme.lexerBackend = lexer_backend;
+        scheme.lexerThreads = lexer_threads;
+        scheme.globalMacrosFormatted = global_macros_formatted;
+        scheme.predefinedMacros = predefined_macros;
+
+        DiscardBuffer discard_buffer;
+        std::ostream discard(&discard_buffer);
+
+        GlobalMacros_t global_macros = MacroSnapshot::Build({});
+        if(!global_macros_formatted.empty() || predefined_macros == "clang")
+        {
+            global_macros = Parser(scheme, discard).GetGlobalMacros();
+        }
+
+        if(input_files.empty() && std::filesystem::is_directory(input_directory))
+        {
+            for(auto const& entry : std::filesystem::directory_iterator(input_directory))
+            {
+                if(entry.is_regular_file() && entry.path().extension() == ".cpp")
+                {
+                    input_files.push_back(entry.path());
+                }
+            }
+            std::sort(input_files.begin(), input_files.end());
+        }
+
+        std::vector<InputResult> results;
+        for(auto const& input_file : input_files)
+        {
+            const SourceBuffer source(input_file);
+            if(!source.IsOpen())
+            {
+                fmt::print(std::cerr, "Input file: {} could not be opened, skipping it.\n",
+                        input_file.string());
+                continue;
+            }
+            results.push_back(BenchInput(input_file.generic_string(), "file", source.GetContents(),
+                    options, scheme, global_macros));
+            PrintSummary(results.back());
+        }
+
+        for(const std::size_t megabytes : generate_mb)
+        {
+            if(megabytes == 0)
+            {
+                continue;
+            }
+            const std::string source = GenerateSource(megabytes * 1000 * 1000, seed);
+            results.push_back(BenchInput(fmt::format("generated-{}mb.cpp", megabytes), "generated",
+                    source, options, scheme, global_macros));
+            PrintSummary(results.back());
+        }
+
+        for(const std::size_t megabytes : generate_header_mb)
+        {
+            if(megabytes == 0)
+            {
+                continue;
+            }
+            const std::string source = GenerateMacroHeader(megabytes * 1000 * 1000, seed);
+            results.push_back(BenchInput(fmt::format("generated-{}mb.h", megabytes), "header",
+                    source, options, scheme, global_macros));
+            PrintSummary(results.back());
+        }
+
+        for(const std::size_t macros : generate_dep_macros)
+        {
+            if(macros == 0)
+            {
+                continue;
+            }
+            const std::string source = GenerateDependencyHeader(macros, seed);
+            results.push_back(BenchInput(fmt::format("generated-{}-macros.h", macros), "dependency",
+                    source, options, scheme, global_macros));
+            PrintSummary(results.back());
+        }
+
+        std::ofstream json(output_file);
+        if(!json.is_open())
+        {
+            fmt::print(std::cerr, "Output file: {} could not be opened.\n", output_file.string());
+            return -1;
+        }
+        WriteJson(json, results, lexer_backend, scheme, options);
+        fmt::print("\nResults written to {}\n", output_file.string());
+    }
+    catch(ExceptionHandler& e)
+    {
+        fmt::print(std::cerr, "Exception Handler: {}\n", e.GetExMessage());
+        return -1;
+    }
+    catch(std::exception& e)
+    {
+        fmt::print(std::cerr, "std::exception: {}\n", e.what());
+        return -1;
+    }
+
+    return 0;
+}
@@ -109,6 +109,13 @@ int main(int argc, char* argv[])
         bool cleanup = false;
         bool multiple_definitions = false;
         std::string make_command;
+        std::size_t jobs = 1;
+        std::string front_end_mode;
+        std::string lexer_backend;
+        std::size_t lexer_threads = 1;
+        std::vector<std::string> prefix_headers;
+        std::string predefined_macros;
+        std::string predefined_macro_cache;
         std::vector<std::string> macros_preventing_demacrofication;
         std::string demacrofication_granularity;
         std::string global_macros_raw;
@@ -144,7 +151,7 @@ int main(int argc, char* argv[])
                         po::value<std::vector<std::string>>(&macros_preventing_demacrofication),
                         "those predefined macros if they are in the replacement text of any other macro will prevent it from being demacrofied")(
                         "global-macros-formatted", po::value<std::string>(&global_macros_formatted),
-                        "file containing global macros formatted in following way\n<Macro-id>\n<Replacement-list>")(
+                        "file containing global macros formatted in following way\n<Macro-id>\n<Replacement-list>\nor its binary snapshot (<file>.snapshot)")(
                         "global-macros-raw", po::value<std::string>(&global_macros_raw),
                         "file containing global macros")("demacrofication-granularity",
                         po::value<std::string>(&demacrofication_granularity)
@@ -163,7 +170,26 @@ int main(int argc, char* argv[])
                         "the directory where source files should be copied for backup, this directory will be deleted later")(
                         "make-command",
                         po::value<std::string>(&make_command)->default_value("make"),
-                        "the command which needs to be invoked in the shell to compile the project");
+                        "the command which needs to be invoked in the shell to compile the project")(
+                        "jobs,j", po::value<std::size_t>(&jobs)->default_value(1),
+                        "number of files processed in parallel, 0 uses one worker per hardware thread")(
+                        "front-end",
+                        po::value<std::string>(&front_end_mode)->default_value("ast"),
+                        "how much of the clang front end runs on each file, either ast, preprocessor or lexer (no clang)")(
+                        "lexer",
+                        po::value<std::string>(&lexer_backend)->default_value("slex"),
+                        "the lexer which tokenizes the files, either slex, slex-classes (byte class dfa tables), hand (written) or wave (Boost.Wave re2c)")(
+                        "lex-threads", po::value<std::size_t>(&lexer_threads)->default_value(1),
+                        "number of threads lexing a large file (from 1 MB on), 0 uses all hardware threads")(
+                        "prefix-header",
+                        po::value<std::vector<std::string>>(&prefix_headers),
+                        "header precompiled once and reused by every file which starts by including the prefix headers in the given order")(
+                        "predefined-macros",
+                        po::value<std::string>(&predefined_macros)->default_value("file"),
+                        "where the predefined macros come from, either file (global-macros-formatted or global-macros-raw) or clang (the macros clang predefines for its target and language standard)")(
+                        "predefined-macro-cache",
+                        po::value<std::string>(&predefined_macro_cache),
+                        "directory where the macros predefined by clang are cached, the temp directory by default");
 
         //po::positional_options_description p;
         //p.add("input-file", -1);
@@ -177,6 +203,20 @@ int main(int argc, char* argv[])
         }
 
 
+        //options given on the command line after the config file
+        //take precedence over the config file e.g. --jobs=8, they are
+        //stored first since the first value stored for an option is kept
+        po::options_description command_line_options;
+        command_line_options.add(config_file_options);
+        command_line_options.add_options()("config-file", po::value<std::string>(), "config file");
+        po::positional_options_description config_file_position;
+        config_file_position.add("config-file", 1);
+        po::store(po::command_line_parser(argc, argv)
+                          .options(command_line_options)
+                          .positional(config_file_position)
+                          .run(),
+                vm);
+
         po::store(po::parse_config_file(cfg, config_file_options), vm);
         po::notify(vm);
 
@@ -404,7 +444,7 @@ int main(int argc, char* argv[])
         }
 
 #ifndef BUILD_NEW_MACRO_LIST
-        else
+        else if(predefined_macros != "clang")
         {
             std::cerr << "when BUILD_NEW_MACRO_LIST is not defined,"
                       << "a file containing global formatted macros"
@@ -459,6 +499,11 @@ int main(int argc, char* argv[])
                     "default command `make` will be used\n");
         }
 
+        if(jobs != 1)
+        {
+            fmt::print("Processing files with {} jobs\n", jobs);
+        }
+
         if(vm.count("demacrofication-granularity"))
         {
             if((demacrofication_granularity != "OneFileAtATime")
@@ -472,6 +517,20 @@ int main(int argc, char* argv[])
             fmt::print("Demacrofying: {}\n", demacrofication_granularity);
         }
 
+        if((front_end_mode != "ast") && (front_end_mode != "preprocessor")
+                && (front_end_mode != "lexer"))
+        {
+            fmt::print(std::cerr, "Error: invalid value for front end.\n{}", config_file_options);
+            return -1;
+        }
+
+        if((lexer_backend != "slex") && (lexer_backend != "slex-classes") && (lexer_backend != "hand")
+                && (lexer_backend != "wave"))
+        {
+            fmt::print(std::cerr, "Error: invalid value for lexer.\n{}", config_file_options);
+            return -1;
+        }
+
         /**     ***********     END PRORAM OPTIONS   ************/
 
 
@@ -487,11 +546,16 @@ int main(int argc, char* argv[])
                 macros_preventing_demacrofication, enable_warning, global_macros_raw,
                 global_macros_formatted, multiple_definitions, cleanup);
         pConfigScheme.SetBuildScheme(make_command);
+        pConfigScheme.SetFrontEndMode(front_end_mode);
+        pConfigScheme.SetLexerBackend(lexer_backend);
+        pConfigScheme.SetLexerThreads(lexer_threads);
+        pConfigScheme.SetPrefixHeaders(prefix_headers);
+        pConfigScheme.SetPredefinedMacros(predefined_macros, predefined_macro_cache);
 
         //step1. load the Overseer class with the configuration scheme
         auto pOverseer = Overseer(std::move(pConfigScheme));
         //step2. start processing
-        pOverseer.StartProcessing(!no_translate);
+        pOverseer.StartProcessing(!no_translate, jobs);
         
         fmt::print("\nFinished...\n");
 
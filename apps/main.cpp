@@ -142,7 +142,7 @@ int main(int argc, char* argv[])
     app.add_option("-p,--ignore-macros", macros_preventing_demacrofication, "Predefined macros that, when found in the body of other macros, prevent demacrofication.");
 
     std::string global_macros_formatted;
-    app.add_option("--global-formatted", global_macros_formatted, "File containing global macros formatted like:\n<Macro-id>\n<Replacement-list>");
+    app.add_option("--global-formatted", global_macros_formatted, "File containing global macros formatted like:\n<Macro-id>\n<Replacement-list>\nor its binary snapshot (<file>.snapshot)");
 
     std::string global_macros_raw;
     app.add_option("--global-raw", global_macros_raw, "File containing global macros.");
@@ -151,6 +151,35 @@ int main(int argc, char* argv[])
     app.add_option("--gran", demac_granularity, "Demacrofy either per file or per macro.")
         ->default_str("file");
 
+    std::size_t jobs{1};
+    app.add_option("-j,--jobs", jobs, "Number of files processed in parallel, 0 uses all hardware threads.")
+        ->default_val(1);
+
+    std::string front_end_mode{"ast"};
+    app.add_option("--front-end", front_end_mode, "How much of the clang front end runs on each file: ast, preprocessor or lexer (no clang).")
+        ->default_val("ast")
+        ->check(CLI::IsMember({"ast", "preprocessor", "lexer"}));
+
+    std::string lexer_backend{"slex"};
+    app.add_option("--lexer", lexer_backend, "The lexer which tokenizes the files: slex, slex-classes (byte class dfa tables), hand (written) or wave (Boost.Wave re2c).")
+        ->default_val("slex")
+        ->check(CLI::IsMember({"slex", "slex-classes", "hand", "wave"}));
+
+    std::size_t lexer_threads{1};
+    app.add_option("--lex-threads", lexer_threads, "Number of threads lexing a large file (from 1 MB on), 0 uses all hardware threads.")
+        ->default_val(1);
+
+    std::vector<std::string> prefix_headers;
+    app.add_option("--prefix-header", prefix_headers, "Header precompiled once and reused by every file which starts by including the prefix headers in the given order.");
+
+    std::string predefined_macros{"file"};
+    app.add_option("--predefined-macros", predefined_macros, "Where the predefined macros come from: file (--global-formatted or --global-raw) or clang (the macros clang predefines for its target and language standard).")
+        ->default_val("file")
+        ->check(CLI::IsMember({"file", "clang"}));
+
+    std::string predefined_macro_cache;
+    app.add_option("--predefined-macro-cache", predefined_macro_cache, "Directory where the macros predefined by clang are cached, the temp directory by default.");
+
     try
     {
         app.parse(argc, argv);
@@ -333,7 +362,7 @@ int main(int argc, char* argv[])
     }
 
 #ifndef BUILD_NEW_MACRO_LIST
-        else
+        else if(predefined_macros != "clang")
         {
             std::cerr << "when BUILD_NEW_MACRO_LIST is not defined,"
                       << "a file containing global formatted macros"
@@ -414,11 +443,16 @@ int main(int argc, char* argv[])
 
     // @TODO: Setup a different way to do this.
     pConfigScheme.SetBuildScheme("make");
+    pConfigScheme.SetFrontEndMode(front_end_mode);
+    pConfigScheme.SetLexerBackend(lexer_backend);
+    pConfigScheme.SetLexerThreads(lexer_threads);
+    pConfigScheme.SetPrefixHeaders(prefix_headers);
+    pConfigScheme.SetPredefinedMacros(predefined_macros, predefined_macro_cache);
 
     //step1. load the Overseer class with the configuration scheme
     auto pOverseer = Overseer(pConfigScheme);
     //step2. start processing
-    pOverseer.StartProcessing(!analyze_only);
+    pOverseer.StartProcessing(!analyze_only, jobs);
     std::cout << "\ndone...\n";
 
 
@@ -29,6 +29,7 @@ limitations under the License.
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/Basic/LangStandard.h"
 
 #include "clang/Parse/ParseAST.h"
 
@@ -36,6 +37,7 @@ limitations under the License.
 #include <map>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declarations:
@@ -50,9 +52,25 @@ class MyASTConsumer : public clang::ASTConsumer
 {
 public:
     bool HandleTopLevelDecl(clang::DeclGroupRef d) override;
+    /// \brief one time setup, the compiler instance can then be used
+    /// for any number of calls to DumpContent
     int InitializeCI(clang::CompilerInstance& ci, const std::vector<std::filesystem::path>& search_paths);
-
-    void DumpContent(const std::string& file_name);
+    /// \brief the language standard InitializeCI sets up
+    static constexpr clang::LangStandard::Kind languageStandard = clang::LangStandard::lang_cxx11;
+    /// \brief target triple, language standard, standard library and clang
+    /// version of the initialized compiler instance, the predefined macros
+    /// depend on nothing else
+    std::string GetConfiguration() const;
+    /// \brief the #define lines of the predefined macros of the compiler
+    /// instance, as clang::InitializePreprocessor generates them
+    std::string GetPredefines();
+
+    /// \brief parses the file, the function ranges come from the AST.
+    /// contents replaces what is on disk and is not copied
+    void DumpContent(const std::string& file_name, std::string_view contents);
+    /// \brief runs only the preprocessor on the file, the function ranges
+    /// come from matching the braces of the preprocessed tokens
+    void PreprocessContent(const std::string& file_name, std::string_view contents);
     void PrintSourceLocation(const clang::FunctionDecl* fd);
     void PrintSourceLocation(const clang::SourceManager& sm, clang::SourceLocation loc);
     void PrintStats() override;
@@ -63,6 +81,12 @@ public:
         return track_macro->GetInvocationStat();
     }
 
+private:
+    /// \brief recreates the per file state of the compiler instance
+    void BeginTranslationUnit();
+    /// \brief makes the file with the given contents the main file
+    void EnterMainFile(const std::string& file_name, std::string_view contents);
+
 private:
     clang::CompilerInstance* pci{ nullptr };
 
@@ -0,0 +1,146 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+          
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef FRONT_END_CONTEXT_HPP
+#define FRONT_END_CONTEXT_HPP
+
+#include "ASTConsumer.hpp"
+#include "FunctionInfo.h"
+
+#include "clang/Frontend/CompilerInstance.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @enum FrontEndMode
+ * @brief ast runs the complete front end (ParseAST) and takes the function
+ * ranges from the declarations, preprocessor only runs the preprocessor
+ * and finds the function ranges by matching braces, which is much faster
+ * on template heavy code. Without any clang front end (lexer mode) no
+ * context is created at all.
+ */
+enum class FrontEndMode
+{
+    ast,
+    preprocessor
+};
+
+/**
+ * @struct PrefixPCH
+ * @brief a precompiled header for a set of prefix headers, built once and
+ * then only read by all the front ends. A translation unit whose first
+ * includes are exactly the prefix headers, in that order, loads the PCH
+ * instead of parsing them again. As with clang -include-pch the prefix
+ * headers need include guards (or #pragma once) to be skipped when the
+ * translation unit includes them.
+ */
+struct PrefixPCH
+{
+    std::filesystem::path pchFile;
+    /// @brief the header which includes all the prefix headers,
+    /// the PCH is built from it
+    std::filesystem::path prefixFile;
+    /// @brief canonical paths of the prefix headers found on disk, and the
+    /// names of the ones included with <> from the system directories,
+    /// in the include order
+    std::vector<std::filesystem::path> headers;
+    std::vector<bool> isSystemHeader;
+};
+
+/// @brief builds the PCH of the prefix headers with the same options as the
+/// FrontEndContext, returns false when clang reported errors
+bool BuildPrefixPCH(const std::vector<std::filesystem::path>& search_paths, PrefixPCH const& prefix_pch);
+
+/**
+ * @class ClangPredefinedMacros
+ * @brief a compiler instance set up like the ones of the FrontEndContexts,
+ * which is only asked for its configuration and its predefined macros.
+ * The search paths don't change the predefined macros, so none are used.
+ */
+class ClangPredefinedMacros
+{
+public:
+    ClangPredefinedMacros();
+
+    ClangPredefinedMacros(const ClangPredefinedMacros&) = delete;
+    ClangPredefinedMacros& operator=(const ClangPredefinedMacros&) = delete;
+
+    /// @brief identifies the set of predefined macros, see MyASTConsumer::GetConfiguration
+    std::string GetConfiguration() const;
+    /// @brief the predefined macros as #define lines
+    std::string GetDefines();
+
+private:
+    clang::CompilerInstance ci;
+    MyASTConsumer astConsumer;
+};
+
+/**
+ * @class FrontEndContext
+ * @brief a clang front end which is kept alive across translation units.
+ * The CompilerInstance with its FileManager (and the stat cache), the
+ * diagnostics, the target info and the header search options are set up
+ * once; only the SourceManager, Preprocessor and ASTContext are recreated
+ * for every file. A context is not thread safe, each worker uses its own.
+ */
+class FrontEndContext
+{
+public:
+    /// @param prefix_pch is used for the files starting with the prefix
+    /// headers, it must outlive the context
+    FrontEndContext(const std::vector<std::filesystem::path>& search_paths, FrontEndMode mode,
+            PrefixPCH const* prefix_pch = nullptr);
+
+    FrontEndContext(const FrontEndContext&) = delete;
+    FrontEndContext& operator=(const FrontEndContext&) = delete;
+
+    /// @brief parses the file and returns the information about the
+    /// macros defined and invoked in it. contents is the file as already
+    /// read by the caller, it must be null terminated and is used in place
+    ASTMacroStat_t ParseFile(const std::string& file_name, std::string_view contents);
+
+    /// @brief number of translation units parsed with this context
+    std::size_t GetParsedFileCount() const;
+
+    /// @brief whether the last file parsed loaded the prefix PCH
+    bool UsedPrefixPCH() const;
+
+private:
+    /// @brief true when the first includes of the file are the prefix headers
+    bool StartsWithPrefixHeaders(const std::string& file_name, std::string_view contents) const;
+
+private:
+    clang::CompilerInstance ci;
+    MyASTConsumer astConsumer;
+    FrontEndMode frontEndMode;
+    std::vector<std::filesystem::path> searchPaths;
+    PrefixPCH const* prefixPCH;
+    bool usedPrefixPCH{ false };
+    std::size_t parsedFileCount{ 0 };
+};
+
+#endif // FRONT_END_CONTEXT_HPP
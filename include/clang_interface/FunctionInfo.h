@@ -45,7 +45,7 @@ struct CollectedMacroInfo
     PPOperation op;
     MacroCategory m_cat;
     CondCategory c_cat;
-    MacroScopeCategory s_cat;
+    MacroScopeCategory s_cat{ MacroScopeCategory::local };
 };
 
 using MacroNameStr = std::string;
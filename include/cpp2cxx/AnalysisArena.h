@@ -0,0 +1,95 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#ifndef ANALYSISARENA_H
+#define ANALYSISARENA_H
+
+/**
+ *  @file AnalysisArena.h
+ *  @brief the MacTree, its Nodes and the PPMacros of a file are allocated
+ *  from a monotonic buffer owned by the FileSession. Nothing is freed one by
+ *  one, Release runs the destructors and hands the buffers back at once
+ *  when the file is done, so a long run does not keep the trees of the
+ *  files it has already processed.
+ */
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @class AnalysisArena
+ * @brief the objects are destroyed in the reverse order of their creation,
+ * as if they were members of one object. Pointers to them are valid until
+ * the next Release.
+ */
+class AnalysisArena
+{
+public:
+    AnalysisArena();
+    ~AnalysisArena();
+
+    AnalysisArena(const AnalysisArena&) = delete;
+    AnalysisArena& operator=(const AnalysisArena&) = delete;
+
+    template<typename T, typename... Args>
+    T* Create(Args&&... args)
+    {
+        if constexpr(!std::is_trivially_destructible_v<T>)
+        {
+            // the object is never left without its destructor
+            destructors.reserve(destructors.size() + 1);
+        }
+        void* p = resource.allocate(sizeof(T), alignof(T));
+        allocatedBytes += sizeof(T);
+        T* object = ::new(p) T(std::forward<Args>(args)...);
+        if constexpr(!std::is_trivially_destructible_v<T>)
+        {
+            destructors.push_back({ object, [](void* o) { static_cast<T*>(o)->~T(); } });
+        }
+        return object;
+    }
+
+    /// @brief destroys all the objects and releases the buffers
+    void Release();
+
+    /// @brief bytes of the objects created since the last Release
+    std::size_t GetAllocatedBytes() const;
+
+private:
+    struct Destructor
+    {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    std::pmr::monotonic_buffer_resource resource;
+    std::vector<Destructor> destructors;
+    std::size_t allocatedBytes{ 0 };
+};
+
+#endif /*ANALYSISARENA_H*/
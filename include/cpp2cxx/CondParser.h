@@ -39,14 +39,10 @@ limitations under the License.
 
 #include "DemacBoostWaveIncludes.h"
 #include "DepGraph.h"
+#include "MacroSnapshot.h"
 
-#include <filesystem>
-#include <map>
 #include <string>
 
-using MacroList_t = std::map<std::string, //identifier
-        std::string>;                     //replacement text
-
 /**
  * @class CondParser
  * To parse the tokens of the preprocessing conditional statements
@@ -55,7 +51,7 @@ class CondParser
 {
 
 public:
-    CondParser(const std::filesystem::path& file_global_macros);
+    explicit CondParser(GlobalMacros_t global_macros);
     void ParseConditions(Node& tree_node, token_iterator t_it);
 
     bool Match(boost::wave::token_id id);
@@ -79,8 +75,8 @@ private:
     CondCategory condCat{ CondCategory::config };
     //std::vector<token_type> condStmt;
     Node* pNode{ nullptr };
-    token_iterator it;
-    MacroList_t macroList;
+    token_iterator it{ nullptr };
+    GlobalMacros_t macroList;
 };
 
 #endif /*CONDPARSER_H*/
@@ -40,6 +40,7 @@ limitations under the License.
 #include "DemacroficationScheme.h"
 #include "FileManagerScheme.h"
 
+#include <cstddef>
 #include <filesystem>
 #include <iosfwd>
 #include <string>
@@ -63,6 +64,16 @@ public:
             bool multiple_definitions, bool cleanup);
 
     void SetBuildScheme(const std::string& make_command);
+
+    void SetFrontEndMode(const std::string& front_end_mode);
+
+    void SetLexerBackend(const std::string& lexer_backend);
+
+    void SetLexerThreads(std::size_t lexer_threads);
+
+    void SetPrefixHeaders(const std::vector<std::string>& prefix_headers);
+
+    void SetPredefinedMacros(const std::string& predefined_macros, const std::string& cache_directory);
     
     FileManagerScheme& GetFileManagerScheme();
     DemacroficationScheme& GetDemacroficationScheme();
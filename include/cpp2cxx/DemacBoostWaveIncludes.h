@@ -41,7 +41,9 @@ limitations under the License.
 // using position_type = token_type::position_type;
 
 using token_type = boost::wave::cpplexer::slex_token<>;
-using token_iterator = boost::wave::cpplexer::slex::slex_iterator<token_type>;
+using lexer_iterator = boost::wave::cpplexer::slex::slex_iterator<token_type>;
+/// points into the tokens of a TokenArena
+using token_iterator = token_type const*;
 using position_type = token_type::position_type;
 
 /**
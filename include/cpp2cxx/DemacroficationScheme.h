@@ -27,8 +27,10 @@ limitations under the License.
 #include "ValidatorMap.h"
 #include "general_utilities/string_utils.hpp"
 
+#include <cstddef>
 #include <set>
 #include <string>
+#include <vector>
 
 /**
   *  @struct DemacroficationScheme
@@ -48,6 +50,26 @@ struct DemacroficationScheme
     std::set<std::string, general_utilities::SortString> macrosPreventingDemacrofication;
 
     std::string demacroficationGranularity;
+    /// how much of the clang front end is run on each file, either ast,
+    /// preprocessor or lexer (no clang, the scopes come from the tokens)
+    std::string frontEndMode{ "ast" };
+    /// the lexer which tokenizes the files, either slex, slex-classes (on
+    /// the byte class dfa tables), hand (written) or wave (the re2c lexer
+    /// of Boost.Wave)
+    std::string lexerBackend{ "slex" };
+    /// threads lexing a large file, 1 lexes on the thread of the file
+    /// and 0 uses all the hardware threads
+    std::size_t lexerThreads{ 1 };
+    /// headers precompiled once and loaded by the clang front end for every
+    /// file which starts by including them in this order
+    std::vector<std::string> prefixHeaders;
+    /// where the predefined (global) macros come from, either file
+    /// (globalMacrosFormatted or globalMacrosRaw) or clang (the macros
+    /// predefined by the clang front end, cached by its configuration)
+    std::string predefinedMacros{ "file" };
+    /// directory of the cached clang predefined macros, the temp directory
+    /// when empty
+    std::string predefinedMacroCache;
     std::string globalMacrosRaw;
     std::string globalMacrosFormatted;
     ValidatorMap validatorMap;
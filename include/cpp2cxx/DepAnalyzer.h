@@ -26,15 +26,13 @@ limitations under the License.
 
 #include "ExceptionHandler.h"
 
-#include <algorithm>
-#include <map>
+#include <cstddef>
+#include <iostream>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <utility>
-
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/graph_traits.hpp>
-#include <boost/graph/topological_sort.hpp>
+#include <vector>
 
 
 /// @todo handle multiple definitions
@@ -43,43 +41,28 @@ limitations under the License.
 /**
  * @class DepAnalyzer
  * analyzes the dependencies between the macros based on the replacement list
+ * @details the graph is kept in compressed sparse rows: the edges from a
+ * macro to the macros it uses are outTargets[outOffsets[v]..outOffsets[v+1])
+ * and the reverse edges, from a macro to the macros using it, are
+ * inSources[inOffsets[v]..inOffsets[v+1]). The vertices are numbered in the
+ * order of the dependency list, which is the order of the definitions.
  */
 template <typename Vertex_t>
 class DepAnalyzer
 {
 private:
-    struct VertexOrder
-    {
-        bool operator()(const Vertex_t* v1, const Vertex_t* v2) const
-        {
-            //comparing the pointers to handle multiple definitions
-            return v1 < v2;
-        }
-    };
-    //for the hash map
-    struct VertexEqual
-    {
-        bool operator()(const Vertex_t* v1, const Vertex_t* v2) const
-        {
-            return v1->identifier_str == v2->identifier_str;
-        }
-    };
-
     // vector of pairs to retain the order in which they occur
     //also defined in the DepGraph.h
     using DepList_t = std::vector<std::pair<Vertex_t*, std::vector<Vertex_t*>>>;
 
-    //also defined in the DepGraph.h
-    using Graph_t = boost::adjacency_list<boost::listS, boost::vecS, boost::directedS, Vertex_t*>;
-
-    using Vd_t = typename boost::graph_traits<Graph_t>::vertex_descriptor;
-    using MapVertexVd_t = std::map<Vertex_t*, Vd_t, VertexOrder>;
+    using Vd_t = std::size_t;
+    //comparing the pointers to handle multiple definitions
+    using MapVertexVd_t = std::unordered_map<Vertex_t*, Vd_t>;
 
 public:
     //check if the map has the object type that is less than convertible
     DepAnalyzer(DepList_t const& adjList) : pDepList(&adjList)
     {
-        depGraph = pDepList->size();
     }
 
     void Analyze(DepList_t const& adjList);
@@ -95,11 +78,19 @@ public:
 private:
     void MakeVertices();
     void MakeEdges();
+    /// @brief the vertices sorted once, every macro after the ones it uses
+    std::vector<Vd_t> const& GetTopologicalOrder();
 
 private:
     DepList_t const* pDepList;
     MapVertexVd_t mapVertexVd;
-    Graph_t depGraph;
+    std::vector<Vertex_t*> vertices;
+    std::vector<std::size_t> outOffsets;
+    std::vector<Vd_t> outTargets;
+    std::vector<std::size_t> inOffsets;
+    std::vector<Vd_t> inSources;
+    std::vector<Vd_t> topoOrder;
+    bool sorted{ false };
 };
 
 template <typename Vertex_t>
@@ -107,7 +98,7 @@ void DepAnalyzer<Vertex_t>::Analyze(DepList_t const& adjList)
 {
     pDepList = &adjList;
     MakeGraph();
-    CheckTotalOrder();
+    CheckTotalOrder(std::cout);
 }
 
 /**
@@ -121,6 +112,7 @@ void DepAnalyzer<Vertex_t>::MakeGraph()
 {
     MakeVertices();
     MakeEdges();
+    sorted = false;
 }
 
 /**
@@ -133,18 +125,75 @@ void DepAnalyzer<Vertex_t>::MakeGraph()
 template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::DoTopologicalSort(std::vector<Vertex_t*>& v)
 {
-    //typename is required since the type Vd_t depends upon the type Vertex_t
-    typename std::vector<Vd_t> topo_order;
-    boost::topological_sort(depGraph, std::back_inserter(topo_order));
-    std::for_each(topo_order.begin(), topo_order.end(),
-            [&v, this](Vd_t vd) { v.push_back(this->depGraph[vd]); });
+    for(const Vd_t vd : GetTopologicalOrder())
+    {
+        v.push_back(vertices[vd]);
+    }
 }
 
 
 template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::DoTopologicalSort(std::vector<Vd_t>& topo_order)
 {
-    boost::topological_sort(depGraph, std::back_inserter(topo_order));
+    std::vector<Vd_t> const& order = GetTopologicalOrder();
+    topo_order.insert(topo_order.end(), order.begin(), order.end());
+}
+
+/**
+  *  @brief  depth first search from every unvisited vertex in the order of
+  *  the definitions, a vertex is appended when all the macros it uses are
+  *  @details the stack keeps the next edge of every vertex on the path, so
+  *  the search is linear in the vertices and edges and doesn't recurse as
+  *  deep as the longest chain of macros. Throws ExceptionHandler when the
+  *  macros depend upon each other in a cycle.
+  */
+template <typename Vertex_t>
+std::vector<typename DepAnalyzer<Vertex_t>::Vd_t> const& DepAnalyzer<Vertex_t>::GetTopologicalOrder()
+{
+    if(sorted)
+    {
+        return topoOrder;
+    }
+
+    enum class Color : unsigned char { white, gray, black };
+    std::vector<Color> color(vertices.size(), Color::white);
+    std::vector<std::pair<Vd_t, std::size_t>> stack; // vertex, next edge
+
+    topoOrder.clear();
+    topoOrder.reserve(vertices.size());
+    for(Vd_t root = 0; root < vertices.size(); ++root)
+    {
+        if(color[root] != Color::white)
+        {
+            continue;
+        }
+        color[root] = Color::gray;
+        stack.emplace_back(root, outOffsets[root]);
+        while(!stack.empty())
+        {
+            auto& [u, edge] = stack.back();
+            if(edge == outOffsets[u + 1])
+            {
+                color[u] = Color::black;
+                topoOrder.push_back(u);
+                stack.pop_back();
+                continue;
+            }
+            const Vd_t w = outTargets[edge++];
+            if(color[w] == Color::white)
+            {
+                color[w] = Color::gray;
+                stack.emplace_back(w, outOffsets[w]);
+            }
+            else if(color[w] == Color::gray)
+            {
+                throw ExceptionHandler("macro: " + vertices[w]->identifier_str
+                                       + " is part of a dependency cycle\n");
+            }
+        }
+    }
+    sorted = true;
+    return topoOrder;
 }
 
 /** @todo improve the code by removing the portion of code specific to
@@ -153,108 +202,55 @@ void DepAnalyzer<Vertex_t>::DoTopologicalSort(std::vector<Vd_t>& topo_order)
 template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::CheckTotalOrder(std::ostream& os)
 {
-    //typename is required since the type Vd_t depends upon the type Vertex_t
-    typename std::vector<Vd_t> topo_order;
-    typename std::vector<Vd_t>::iterator ordered_vertices_iter;
-    typename boost::graph_traits<Graph_t>::edge_iterator ei, ei_end;
-
     //puts the topologically sorted vertices into topo_order
-    DoTopologicalSort(topo_order);
+    std::vector<Vd_t> const& topo_order = GetTopologicalOrder();
     std::stringstream err_msg;
-    //will point to the vertices in the order they were inserted
-    typename boost::graph_traits<Graph_t>::vertex_iterator vi, vi_end;
-    std::unordered_map<Vertex_t*, int, std::hash<Vertex_t*>, VertexEqual> orig_order_map,
-            topo_order_map;
-
-    int i = 0;
-    //int num_macros;
-    //inserts the macros in hash table with value as integer
-    for(std::tie(vi, vi_end) = boost::vertices(depGraph); vi != vi_end; ++vi)
-    {
-        orig_order_map[depGraph[*vi]] = ++i;
-        //std::cout<<depGraph[*vi]->identifier_str<<"\n";
-    }
-    //num_macros = i;
-    i = 0;
-    //will point to the vertices in the topological order
-    ordered_vertices_iter = topo_order.begin();
-    for(; ordered_vertices_iter != topo_order.end(); ordered_vertices_iter++)
+
+    //the vertices are numbered in the order they were inserted, so the
+    //position in the original list is the vertex itself
+    std::vector<std::size_t> topo_position(vertices.size());
+    for(std::size_t i = 0; i < topo_order.size(); ++i)
     {
-        //inserts the macros in hash table with value as integer
-        topo_order_map[depGraph[*ordered_vertices_iter]] = ++i;
-        //std::cout<<depGraph[*ordered_vertices_iter]->identifier_str<<"\n";
+        topo_position[topo_order[i]] = i;
     }
 
-    ordered_vertices_iter = topo_order.begin();
-    if(ordered_vertices_iter != topo_order.end())
+    if(!topo_order.empty())
     {
         os << "  - log: checking the dependency order of macro "
-           << depGraph[*ordered_vertices_iter]->identifier_str << "\n";
+           << vertices[topo_order.front()]->identifier_str << "\n";
     }
-    for(; ordered_vertices_iter != topo_order.end(); ordered_vertices_iter++)
+    for(const Vd_t vd : topo_order)
     {
         //if the vertex in topologically sorted list occurs before(w.r.t. position)
         //the macro in the original list of vertices, then it's okay
-        if(orig_order_map[depGraph[*ordered_vertices_iter]]
-                > topo_order_map[depGraph[*ordered_vertices_iter]])
+        if(vd <= topo_position[vd])
         {
-            //try to remove get_identifier to the exception handler
-            //making sure the processing continues even after an out of order
-            //macro is found, ask Andrew
-
-            err_msg << "  - "
-                    << depGraph[*ordered_vertices_iter]->identifier.get_position().get_file()
-                    << ":"
-                    << depGraph[*ordered_vertices_iter]->identifier.get_position().get_line()
-                    << ":"
-                    << depGraph[*ordered_vertices_iter]
-                               ->identifier
-                               .get_position()
-                               .get_column()
-                    << ":\n";
-            err_msg << "    - warning: ";
-            os << err_msg.str() << "macro '"
-               << depGraph[*ordered_vertices_iter]->identifier_str
-               << "' is used before it is defined\n";
-            err_msg.str(std::string());
-            /// set the out_of_order_dependent_type token type, to true
-            depGraph[*ordered_vertices_iter]
-                    ->rep_list
-                    .set_replacement_list_dependency_category(true);
-            boost::tie(ei, ei_end) = boost::edges(depGraph);
-            //finding the macro which depend upon this out of order macros
-            for(; ei != ei_end; ++ei)
-            {
-                //if the target vertex is the current vertex i.e. we have a match
-                if(target(*ei, depGraph) == *ordered_vertices_iter)
-                {
-                    //print the source vertex
-                    os << "    - note: used at: "
-                       << depGraph[source(*ei, depGraph)]
-                                    ->identifier
-                                    .get_position()
-                                    .get_file()
-                       << ":"
-                       << depGraph[source(*ei, depGraph)]
-                                    ->identifier
-                                    .get_position()
-                                    .get_line()
-                       << ":"
-                       << depGraph[source(*ei, depGraph)]
-                                    ->identifier
-                                    .get_position()
-                                    .get_column()
-                       << ":"
-                       << " with macro: " << depGraph[source(*ei, depGraph)]->identifier_str
-                       << "\n";
-                    /// this macro depends upon a macro that is defined after its use
-                    depGraph[source(*ei, depGraph)]
-                            ->rep_list
-                            .set_replacement_list_dependency_category(true);
-                }
-            }
-            //err_msg = depGraph[*ordered_vertices_iter]->identifier_str;
-            //std::cerr << "macro: " << err_msg << ": out of order\n";
+            continue;
+        }
+        Vertex_t* vertex = vertices[vd];
+        //try to remove get_identifier to the exception handler
+        //making sure the processing continues even after an out of order
+        //macro is found, ask Andrew
+
+        err_msg << "  - " << vertex->identifier.get_position().get_file() << ":"
+                << vertex->identifier.get_position().get_line() << ":"
+                << vertex->identifier.get_position().get_column() << ":\n";
+        err_msg << "    - warning: ";
+        os << err_msg.str() << "macro '" << vertex->identifier_str
+           << "' is used before it is defined\n";
+        err_msg.str(std::string());
+        /// set the out_of_order_dependent_type token type, to true
+        vertex->rep_list.set_replacement_list_dependency_category(true);
+        //the macros which depend upon this out of order macro
+        for(std::size_t edge = inOffsets[vd]; edge != inOffsets[vd + 1]; ++edge)
+        {
+            Vertex_t* user = vertices[inSources[edge]];
+            os << "    - note: used at: " << user->identifier.get_position().get_file() << ":"
+               << user->identifier.get_position().get_line() << ":"
+               << user->identifier.get_position().get_column() << ":"
+               << " with macro: " << user->identifier_str << "\n";
+            /// this macro depends upon a macro that is defined after its use
+            user->rep_list.set_replacement_list_dependency_category(true);
         }
     }
 }
@@ -265,23 +261,21 @@ void DepAnalyzer<Vertex_t>::CheckTotalOrder(std::ostream& os)
   *  @param  none
   *  @return void
   *  @details
-  *  inserts the vertices in the graph as well as in the property map
+  *  numbers the vertices in the order of the dependency list
   */
 template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::MakeVertices()
 {
     DepList_t const& depList = *pDepList;
 
-    //add vertices
-    typename boost::graph_traits<Graph_t>::vertex_iterator v_iter;
-    v_iter = vertices(depGraph).first;
-    typename DepList_t::const_iterator dl_iter;
-    dl_iter = depList.begin();
-    for(; dl_iter != depList.end(); dl_iter++, v_iter++)
+    vertices.clear();
+    vertices.reserve(depList.size());
+    mapVertexVd.clear();
+    mapVertexVd.reserve(depList.size());
+    for(auto const& dep : depList)
     {
-        //vd = boost::add_vertex(map_iter->first,depGraph);
-        depGraph[*v_iter] = dl_iter->first;
-        mapVertexVd.insert(std::make_pair(dl_iter->first, *v_iter));
+        mapVertexVd.emplace(dep.first, vertices.size());
+        vertices.push_back(dep.first);
     }
 }
 
@@ -289,55 +283,57 @@ void DepAnalyzer<Vertex_t>::MakeVertices()
   *  @brief  makes the edges in the graph
   *  @param  none
   *  @return void
-  *  @details adds the edges according to the adjacency list
+  *  @details adds the edges according to the adjacency list, then counts
+  *  the edges into every vertex to lay out the reverse edges
   */
 template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::MakeEdges()
 {
     DepList_t const& depList = *pDepList;
-    /*    DepList_t depList;
-    MapVertexVd_t mapVertexVd;
-    Graph_t depGraph;*/
-    //iterator to the depList mapped_type
-    typename std::vector<Vertex_t*>::const_iterator dt_iter;
-    //iterator to the depList
-    typename DepList_t::const_iterator dl_iter;
-    //iterator to the map of vertex to vertex descriptor
-    typename MapVertexVd_t::iterator pm_iter = mapVertexVd.begin();
-    // @TODO: Initialize these.
-    Vd_t u, v; //ordered pair (u,v)
-    for(dl_iter = depList.begin(); dl_iter != depList.end(); dl_iter++)
+
+    outOffsets.assign(1, 0);
+    outOffsets.reserve(depList.size() + 1);
+    outTargets.clear();
+    for(auto const& [macro, deps] : depList)
     {
-        //find the iterator to the mapVertex where macro is
-        pm_iter = mapVertexVd.find(dl_iter->first);
-        if(pm_iter != mapVertexVd.end())
+        //the vertex with the out edge in the ordered pair (u,v)
+        if(mapVertexVd.find(macro) == mapVertexVd.end())
         {
-            //the vertex with the in edge in the ordered pair (u,v)
-            v = pm_iter->second;
-        }
-        else
-        {
-            std::string err_msg =
-                    "vertex for " + dl_iter->first->identifier_str + " not added\n";
+            std::string err_msg = "vertex for " + macro->identifier_str + " not added\n";
             throw ExceptionHandler(err_msg);
         }
-        dt_iter = dl_iter->second.begin();
-        for(; dt_iter != dl_iter->second.end(); dt_iter++)
+        for(Vertex_t* dep : deps)
         {
-            // the vertex with the out edge in the ordered pair (u,v)
-            pm_iter = mapVertexVd.find(*dt_iter);
-            if(pm_iter != mapVertexVd.end())
-            {
-                u = pm_iter->second;
-                //for topological_sort insert the edges in opposite direction
-                //since this topological_sort uses BFS
-                boost::add_edge(v, u, depGraph);
-            }
-            else
+            auto pm_iter = mapVertexVd.find(dep);
+            if(pm_iter == mapVertexVd.end())
             { //first vertex not found => error
-                std::string err_msg = "macro: " + (*dt_iter)->identifier_str + " not found\n";
+                std::string err_msg = "macro: " + dep->identifier_str + " not found\n";
                 throw ExceptionHandler(err_msg);
             }
+            //the edge goes from the macro to the one it uses, so that the
+            //topological sort puts the macros used first
+            outTargets.push_back(pm_iter->second);
+        }
+        outOffsets.push_back(outTargets.size());
+    }
+
+    //the reverse edges, each vertex keeps its sources in increasing order
+    inOffsets.assign(vertices.size() + 1, 0);
+    for(const Vd_t target : outTargets)
+    {
+        ++inOffsets[target + 1];
+    }
+    for(std::size_t vd = 0; vd < vertices.size(); ++vd)
+    {
+        inOffsets[vd + 1] += inOffsets[vd];
+    }
+    inSources.resize(outTargets.size());
+    std::vector<std::size_t> next(inOffsets.begin(), inOffsets.end() - 1);
+    for(Vd_t source = 0; source < vertices.size(); ++source)
+    {
+        for(std::size_t edge = outOffsets[source]; edge != outOffsets[source + 1]; ++edge)
+        {
+            inSources[next[outTargets[edge]]++] = source;
         }
     }
 }
@@ -352,11 +348,10 @@ template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::PrintVertices()
 {
     std::stringstream strm;
-    typename boost::graph_traits<Graph_t>::vertex_iterator vi, vi_end;
 
-    for(boost::tie(vi, vi_end) = boost::vertices(depGraph); vi != vi_end; ++vi)
+    for(Vertex_t const* vertex : vertices)
     {
-        strm << depGraph[*vi]->identifier_str << "\n";
+        strm << vertex->identifier_str << "\n";
     }
     std::cout << strm.str();
 }
@@ -371,12 +366,14 @@ template <typename Vertex_t>
 void DepAnalyzer<Vertex_t>::PrintEdges()
 {
     std::stringstream strm;
-    typename boost::graph_traits<Graph_t>::edge_iterator ei, ei_end;
 
-    for(boost::tie(ei, ei_end) = boost::edges(depGraph); ei != ei_end; ++ei)
+    for(Vd_t source = 0; source < vertices.size(); ++source)
     {
-        strm << " (" << depGraph[source(*ei, depGraph)]->identifier_str << " , "
-             << depGraph[target(*ei, depGraph)]->identifier_str << ")\n";
+        for(std::size_t edge = outOffsets[source]; edge != outOffsets[source + 1]; ++edge)
+        {
+            strm << " (" << vertices[source]->identifier_str << " , "
+                 << vertices[outTargets[edge]]->identifier_str << ")\n";
+        }
     }
     std::cout << strm.str();
 }
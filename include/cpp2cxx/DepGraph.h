@@ -21,6 +21,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+
 #ifndef DEPGRAPH_H
 #define DEPGRAPH_H
 
@@ -42,166 +43,187 @@ limitations under the License.
   *    it and it's sibling.
   * 4.
   */
+#include "AnalysisArena.h"
 #include "DemacBoostWaveIncludes.h"
 #include "Macro.h"
 #include "UseCaseState.h"
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/depth_first_search.hpp>
-#include <boost/graph/graph_traits.hpp>
-#include <boost/graph/topological_sort.hpp>
-
-#include <algorithm>
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 /**
  * @class Node
- * @brief Node of the macro tree used to store macros
+ * @brief a conditional directive as collected by the Parser and the
+ * CondParser, the MacTree makes its nodes from it
  */
 struct Node
 {
-    //public:
-    Node() noexcept
-            : key(boost::wave::T_UNKNOWN),
-              nodeIndex(0),
-              condCat(CondCategory::local),
-              parent(nullptr)
-    {
-    }
-    ~Node()
-    {
-        std::for_each(vecMacro.begin(), vecMacro.end(), [](PPMacro* mac) {
-            delete mac;
-            mac = NULL;
-        });
-    }
-    std::vector<token_type> const& GetCondStmt()
-    {
-        return condStmt;
-    }
-    //put the macro in the free store
-    PPMacro* PushBackMacro(PPMacro& mac)
-    {
-        // TODO: Replace with smart pointer.
-        PPMacro* m = new PPMacro(mac);
-        //*m = mac;
-        return vecMacro.emplace_back(m);
-    }
-    bool operator==(Node& n)
-    {
-        return (condStmt == n.condStmt) && (parent == n.parent) && (vecMacro == n.vecMacro);
-    }
-
     token_type key{ boost::wave::T_UNKNOWN }; //this key may be #if, #ifdef, #ifndef, #endif
-    int nodeIndex{ 0 };
     //whether config macros used or local macros tested for
     CondCategory condCat{ CondCategory::local };
     //the complete condition text including the #if etc...
     std::vector<token_type> condStmt;
-    //Macros within the condition block
-    std::vector<PPMacro*> vecMacro; //keep only the pointer to macro
-    Node* parent{ nullptr };
 };
 
 /**
- * @struct NodeOrder
- * @brief To sort the Node
+ * @struct TokenSpan
+ * @brief the tokens [first, last) of the TokenArena the tree was parsed from
  */
-struct NodeOrder
+struct TokenSpan
 {
-    bool operator()(Node const* n1, Node const* n2 = NULL) const
+    token_iterator first{ nullptr };
+    token_iterator last{ nullptr };
+
+    token_iterator begin() const
     {
-        if(n2 == NULL)
-            return true;
-        return n1->nodeIndex < n2->nodeIndex;
+        return first;
+    }
+    token_iterator end() const
+    {
+        return last;
+    }
+    std::size_t size() const
+    {
+        return static_cast<std::size_t>(last - first);
+    }
+    bool empty() const
+    {
+        return first == last;
     }
 };
 
-using TokenMacroMap_t = std::multimap<token_type, PPMacro*, TokenOrder>;
-using PairMacroIter_t = std::pair<TokenMacroMap_t::iterator, TokenMacroMap_t::iterator>;
-
-//first arg: type of adjacency list, second arg: backbone of graph
-//Also defined in DepAnalyzer.h
-using Graph_t = boost::adjacency_list<boost::listS, boost::vecS, boost::directedS, Node*>;
-
-//Also defined in DepAnalyzer.h
-using Vertex_t = boost::graph_traits<Graph_t>::vertex_descriptor;
+/// the index of a node in the MacTree, the root is 0
+using NodeIndex_t = std::uint32_t;
+inline constexpr NodeIndex_t noNode = UINT32_MAX;
 
-using VertexIterator_t = boost::graph_traits<Graph_t>::vertex_iterator;
-using OutEdgeIterator_t = boost::graph_traits<Graph_t>::out_edge_iterator;
-
-//since we are storing pointers no need of a multimap
-using NodeMap_t = std::map<Node*, Vertex_t, NodeOrder>;
+/// the #defines and #undefs of one identifier, in the order they occur
+using MacroDefinitions_t = std::vector<PPMacro*>;
+/// keyed by the interned symbol of the identifier (token_type::get_symbol)
+using SymbolMacroMap_t = std::unordered_map<std::uint32_t, MacroDefinitions_t>;
+/// the definition made at an identifier token, keyed by the source and the
+/// byte offset of the token (see MacTree::GetDefinition)
+using DefinitionMap_t = std::unordered_map<std::uint64_t, PPMacro*>;
 
 // vector of pairs to retain the order in which they occur
 //also defined in the DepAnalyzer.h
 using DepList_t = std::vector<std::pair<PPMacro*, std::vector<PPMacro*>>>;
 
-//not used right now
-class DFSVisitor : public boost::default_dfs_visitor
+class MacTree;
+
+/**
+ * @class ChildIterator
+ * @brief walks the children of a node through the next sibling indices
+ */
+class ChildIterator
 {
 public:
-    void discover_vertex(Vertex_t v, const Graph_t& g) const
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = NodeIndex_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = NodeIndex_t const*;
+    using reference = NodeIndex_t;
+
+    ChildIterator() = default;
+    ChildIterator(MacTree const* tree, NodeIndex_t node) : pTree(tree), current(node)
+    {
+    }
+
+    NodeIndex_t operator*() const
     {
-        /*    for_each(g[v]->vecMacro.begin(),g[v]->vecMacro.End(),
-      [&linearOrder](PPMacro mac) {
-        linearOrder.push_back(&mac);
-      });*/
+        return current;
     }
+    ChildIterator& operator++();
+    ChildIterator operator++(int)
+    {
+        ChildIterator prev = *this;
+        ++*this;
+        return prev;
+    }
+    bool operator==(ChildIterator const& other) const
+    {
+        return current == other.current;
+    }
+    bool operator!=(ChildIterator const& other) const
+    {
+        return current != other.current;
+    }
+
+private:
+    MacTree const* pTree{ nullptr };
+    NodeIndex_t current{ noNode };
 };
 
 /**
  * @class MacTree
- * @brief The tree class having Node as vertices of the trees
+ * @brief the tree of the conditional blocks of a file, the root being the
+ * file itself. The nodes are indices into parallel arrays (parent, first
+ * child, next sibling, condition), so making a node appends to the arrays
+ * and the navigation is a lookup. The conditions are spans of the tokens
+ * of the Parser, valid until it lexes another file.
  */
-// TODO: Make this more of a container.
 class MacTree
 {
 
 public:
-    MacTree() noexcept : nodeIndex(0), depGraph(1)
-    {
-        // FIXME: Memory leak.
-        Node* pn = new Node;
-        //currVertex is dummy here
-        NodeMap_t::iterator nodeMap_iter = nodeMap.insert(std::make_pair(pn, currVertex)).first;
-        currVertex = boost::add_vertex(nodeMap_iter->first, depGraph);
-        nodeMap_iter->second = currVertex;
-        startVertex = currVertex;
-    }
-
-    ~MacTree()
-    {
-        DeleteNodes();
-    }
+    /// @brief the macros are created in the arena, and live until it is
+    /// released
+    explicit MacTree(AnalysisArena& analysis_arena);
 
     /// @brief get the root node
-    Node const* GetRoot() const;
+    NodeIndex_t GetRoot() const;
+
+    /// @brief the node the next macro or conditional goes into
+    NodeIndex_t GetCurrentNode() const;
 
-    /// @brief get the parent node
-    static Node* GetParent(Node* const np);
+    /// @brief get the parent node, noNode for the root
+    NodeIndex_t GetParent(NodeIndex_t n) const;
 
-    /// @brief return the first child of the node, not implemented
-    Node* GetFirstChild(Vertex_t const v);
+    /// @brief return the first child of the node, noNode when it has none
+    NodeIndex_t GetFirstChild(NodeIndex_t n) const;
 
-    /// @brief get the total number of nodes
+    /// @brief return the next sibling of the node, noNode for the last one
+    NodeIndex_t GetNextSibling(NodeIndex_t n) const;
+
+    /// @brief get the total number of nodes, the root is not counted
     int GetNumNodes() const;
 
     /// @brief is the node a root node
-    bool IsRoot(Vertex_t v) const;
+    bool IsRoot(NodeIndex_t n) const;
+
+    /// @brief the #if, #ifdef, #ifndef, #elif, #else or #endif of the node,
+    /// T_UNKNOWN for the root
+    boost::wave::token_id GetKey(NodeIndex_t n) const;
+
+    /// @brief the tokens of the conditional directive of the node
+    TokenSpan GetCondition(NodeIndex_t n) const;
+
+    CondCategory GetCondCategory(NodeIndex_t n) const;
 
-    /// @brief sibling of the currently pointed vertex
-    bool MakeSibling(Node& rn);
+    /// @brief the macros within the conditional block of the node
+    std::vector<PPMacro*> GetMacros(NodeIndex_t n) const;
+
+    /// @brief sibling of the currently pointed vertex, condition is the
+    /// span of the tokens the Parser went over for the directive of rn
+    bool MakeSibling(Node const& rn, TokenSpan condition);
 
     /// @brief child to the currently pointed vertex
-    bool MakeChild(Node& rn);
+    bool MakeChild(Node const& rn, TokenSpan condition);
 
     /// @brief specific to the macro insertion
     void PushBackMacro(PPMacro& mac);
 
-    /// @brief returns the macro associated having the identifier token as tok
-    PairMacroIter_t GetMacro(const token_type& tok);
+    /// @brief returns the macros having the identifier token as tok,
+    /// empty when tok is not a macro
+    MacroDefinitions_t const& GetMacro(const token_type& tok) const;
+
+    /// @brief returns the #define (or #undef) whose identifier is the token
+    /// identifier itself, not just one with the same spelling; null when no
+    /// macro of the tree was made at that token
+    PPMacro* GetDefinition(const token_type& identifier) const;
 
     /// @brief sets the pointer of the current node to the parent node
     void GotoParent();
@@ -209,42 +231,69 @@ public:
     /// @brief builds the dependency list, and returns a refernce to it
     const DepList_t& BuildMacroDependencyList();
 
-    /// @brief gets the vertex descriptor to the parent of the current vertex
-    Vertex_t GetParent(Vertex_t const v);
-
-    /// @brief returns the pair of iterators to the siblings
-    std::pair<OutEdgeIterator_t, OutEdgeIterator_t> GetSiblings(Vertex_t const vd);
+    /// @brief returns the pair of iterators to the siblings, the node included
+    std::pair<ChildIterator, ChildIterator> GetSiblings(NodeIndex_t n) const;
 
     /// @brief returns the pair of iterators to the children
-    std::pair<OutEdgeIterator_t, OutEdgeIterator_t> GetChildren(Vertex_t const vd);
+    std::pair<ChildIterator, ChildIterator> GetChildren(NodeIndex_t n) const;
+
+    /// @brief moves childN (with its subtree) to the last child of parentN
+    bool MakeChild(NodeIndex_t parentN, NodeIndex_t childN);
+    bool MakeSibling(NodeIndex_t firstN, NodeIndex_t secondN);
+    /// @brief unlinks the node from its parent, its subtree goes with it
+    bool DeleteVertex(NodeIndex_t n);
+    bool IsMacro(token_type const& tok) const;
+    /// @brief collects the use cases of the macros, returns true when the
+    /// token is the identifier of a macro #defined so far
+    bool CheckToken(const token_iterator& tok_iter);
+
+    /// @brief the ancestor of the current node at the nesting level,
+    /// the root being at level 0
+    NodeIndex_t GetAncestor(int nesting_level) const;
+
+    /// algorithm, the nodes below startN in preorder
+    void Dfs(NodeIndex_t const startN, std::vector<NodeIndex_t>& order) const;
+    /// algorithm, the nodes below startN level by level
+    void Bfs(NodeIndex_t const startN, std::vector<NodeIndex_t>& order) const;
+    /// algorithm, every node after its descendants (as boost::topological_sort)
+    void TopSort(std::vector<NodeIndex_t>& topo_order) const;
 
-    bool MakeChild(Vertex_t parentV, Vertex_t childV);
-    bool MakeSibling(Vertex_t firstV, Vertex_t secondV);
-    bool DeleteVertex(Vertex_t v);
-    void DeleteNodes();
-    bool IsMacro(token_type const& tok);
-    void CheckToken(const token_iterator& tok_iter);
-
-    /// not defined: for future use
-    Vertex_t GetAncestor(int nesting_level);
-
-    /// algorithm
-    void Dfs(Vertex_t const startV);
-    /// algorithm
-    void Bfs(Vertex_t const startV);
-    /// algorithm
-    void TopSort(std::vector<Graph_t::vertex_descriptor>& topo_order);
+private:
+    NodeIndex_t AddNode(Node const& rn, TokenSpan condition, NodeIndex_t parentN);
+    /// @brief appends the node to the children of parentN
+    void LinkChild(NodeIndex_t parentN, NodeIndex_t childN);
+    void UnlinkChild(NodeIndex_t childN);
 
 private:
-    int nodeIndex;
-    NodeMap_t nodeMap;
+    AnalysisArena& arena;
+
+    // the nodes, one entry per node in each array
+    std::vector<NodeIndex_t> parents;
+    std::vector<NodeIndex_t> firstChildren;
+    std::vector<NodeIndex_t> lastChildren;
+    std::vector<NodeIndex_t> nextSiblings;
+    std::vector<TokenSpan> conditions;
+    std::vector<CondCategory> condCategories;
+    /// the first and last macro of each node, indices into linearOrder,
+    /// the macros of a node are chained through nextMacros
+    std::vector<std::uint32_t> firstMacros;
+    std::vector<std::uint32_t> lastMacros;
+
     std::vector<PPMacro*> linearOrder; //keeps the macro order as they occur
+    std::vector<std::uint32_t> nextMacros;
     UseCaseState macroUseCaseState;
-    TokenMacroMap_t tokenMacroMap;
+    SymbolMacroMap_t symbolMacroMap;
+    DefinitionMap_t definitionMap;
     DepList_t macroDepList;
-    Graph_t depGraph;
-    Vertex_t currVertex;
-    Vertex_t startVertex; //the root node
+    NodeIndex_t currNode{ 0 };
+
+    friend class ChildIterator;
 };
 
+inline ChildIterator& ChildIterator::operator++()
+{
+    current = pTree->nextSiblings[current];
+    return *this;
+}
+
 #endif /*DEPGRAPH_H*/
@@ -24,6 +24,7 @@ limitations under the License.
 #ifndef FILEMANAGER_H
 #define FILEMANAGER_H
 
+#include <cstddef>
 #include <filesystem>
 #include <iosfwd>
 #include <string>
@@ -44,10 +45,10 @@ struct FileManagerScheme;
 struct DemacroficationScheme;
 
 /**
- * @class OverSeer
+ * @class FileSession
  * @brief forward declaration
  */
-class Overseer;
+class FileSession;
 
 /**
  * @class FileManager
@@ -76,8 +77,9 @@ public:
     void UpdateFile(std::string_view file_str);
     void UpdateFile(std::ostream& fp, std::string_view file_str);
 
-    /// @brief observer, gets updated whenever a new file is demacrofied
-    void UpdateFile(Overseer const& overseer);
+    /// @brief observer, gets updated whenever a new file is demacrofied,
+    /// writes to the output file corresponding to the session's input file
+    void UpdateFile(FileSession const& session);
 
     /// @brief returns the list of input files
     const std::vector<std::filesystem::path>& GetInputFiles() const;
@@ -116,8 +118,8 @@ private:
 
     DemacroficationScheme const& demacroficationScheme;
     /// @todo try to make a map from input files to output files
-    unsigned int inputFileIndex;
-    unsigned int outputFileIndex;
+    std::size_t inputFileIndex;
+    std::size_t outputFileIndex;
 };
 
 #endif /*FILEMANAGER_H*/
@@ -0,0 +1,175 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef FILESESSION_H
+#define FILESESSION_H
+
+/**
+ *  @file FileSession.h
+ *  @brief everything needed to process one input file: the clang front end,
+ *  the Parser (and with it the MacTree and the Demacrofier) and the buffers
+ *  collecting what the file writes to the log and stat files.
+ *  Sessions share nothing mutable, so the Overseer can run several of them
+ *  on different threads and merge their results in the order of the input files.
+ */
+
+#include "AnalysisArena.h"
+#include "LexerScopeClassifier.h"
+#include "MacroStat.h"
+#include "Parser.h"
+#include "SourceBuffer.h"
+#include "SplicePlan.h"
+#include "clang_interface/FunctionInfo.h"
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct DemacroficationScheme;
+
+/**
+ * @class FrontEndContext
+ * forward declaration
+ */
+class FrontEndContext;
+
+/**
+ * @class FileSession
+ * @brief processes one input file, the results are kept until the
+ * Overseer merges them into the log, stat and output files.
+ */
+class FileSession
+{
+public:
+    FileSession(std::size_t file_index, std::filesystem::path file_name,
+            DemacroficationScheme const& demacrofication_scheme, GlobalMacros_t const& global_macros,
+            FrontEndContext* front_end);
+
+    /// @brief runs the clang front end and the parser, and if demacrofy is
+    /// set the demacrofier and the dependency analyzer.
+    /// Any exception is kept in the session and rethrown by RethrowError,
+    /// so that the Overseer can report it in the order of the input files.
+    void Run(bool demacrofy);
+
+    std::size_t GetFileIndex() const;
+    const std::filesystem::path& GetFileName() const;
+
+    /// @brief true when the parser went through the whole file
+    bool IsParsed() const;
+    /// @brief true when the demacrofied file is available
+    bool IsDemacrofied() const;
+    bool HasError() const;
+    void RethrowError() const;
+
+    /// @brief contents to be appended to the log file
+    std::string GetLog() const;
+    /// @brief contents to be appended to the demacrofied macro stat file
+    std::string GetStat() const;
+
+    std::size_t GetMacroCount() const;
+    std::size_t GetFunctionLikeCount() const;
+    std::size_t GetObjectLikeCount() const;
+    const std::vector<MacroStat>& GetMacroStats() const;
+    std::size_t GetSourceBytes() const;
+    /// @brief bytes the parser copied without lexing them
+    std::size_t GetSkippedSourceBytes() const;
+    /// @brief bytes of the MacTree, nodes and macros of the file,
+    /// released along with the parser
+    std::size_t GetAnalysisArenaBytes() const;
+
+    /// @brief true when the file went through the clang front end
+    bool IsClangParsed() const;
+    /// @brief true when the pre-scan found that no macro of the file
+    /// needs the clang information and the front end was skipped
+    bool IsClangSkipped() const;
+    /// @brief true when the front end loaded the prefix PCH for the file
+    bool UsedPrefixPCH() const;
+    std::chrono::nanoseconds GetClangTime() const;
+    std::chrono::nanoseconds GetPreScanTime() const;
+    /// @brief agreement of the LexerScopeClassifier with clang,
+    /// only available when the file went through the clang front end
+    const ScopeAgreement& GetScopeAgreement() const;
+
+    /// @brief called by the FileManager to write the demacrofied file
+    void WriteOutputFile(std::ostream& os) const;
+    /// @brief writes the demacrofied file with vectored I/O, returns false
+    /// when the file could not be written
+    bool WriteOutputFile(const std::filesystem::path& output_file) const;
+
+private:
+    void GenerateExternalASTHandler();
+    void RunParser();
+    void RunDemacrofier();
+    void RunDependencyAnalyzer();
+    /// @brief keeps the statistics and releases the parser
+    void ReleaseParser();
+
+private:
+    std::size_t fileIndex;
+    std::filesystem::path fileName;
+    DemacroficationScheme const& demacroficationScheme;
+    /// \brief clang front end of the worker running this session,
+    /// null when the scopes are classified from the tokens only
+    FrontEndContext* frontEnd;
+    /// \brief the file is read once, for the pre-scan, clang and the parser
+    SourceBuffer source;
+
+    std::stringstream logStream;
+    std::stringstream statStream;
+    /// \brief the per-file analysis objects of the parser, declared
+    /// before it so that it goes first
+    AnalysisArena analysisArena;
+    std::unique_ptr<Parser> pParser;
+    /// \brief holds information returned from clang AST
+    ASTMacroStat_t ASTMacroStat;
+    /// \brief the same information as classified from the tokens
+    ASTMacroStat_t lexerMacroStat;
+    LexerScopeClassifier scopeClassifier;
+    ScopeAgreement scopeAgreement;
+
+    bool clangParsed{ false };
+    bool clangSkipped{ false };
+    bool usedPrefixPCH{ false };
+    std::chrono::nanoseconds clangTime{ 0 };
+    std::chrono::nanoseconds preScanTime{ 0 };
+
+    bool parsed{ false };
+    bool demacrofied{ false };
+    std::exception_ptr error;
+
+    /// \brief the demacrofied file is source with these edits
+    SplicePlan demacrofiedPlan;
+    std::size_t macroCount{ 0 };
+    std::size_t functionLikeCount{ 0 };
+    std::size_t objectLikeCount{ 0 };
+    std::vector<MacroStat> macroStats;
+    std::size_t skippedSourceBytes{ 0 };
+    std::size_t analysisArenaBytes{ 0 };
+};
+
+#endif /*FILESESSION_H*/
@@ -0,0 +1,43 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef HANDWRITTENLEXER_H
+#define HANDWRITTENLEXER_H
+
+/**
+ *  @file HandWrittenLexer.h
+ *  @brief a lexer written for the tokens cpp2cxx looks at: directives,
+ *  identifiers, punctuators, literals, comments and continuation lines.
+ *  It dispatches on the first byte of a token and matches the rest with
+ *  straight line code, but returns the same tokens (ids, values and
+ *  positions) as the slex lexer for every language option the slex
+ *  lexer supports.
+ */
+
+#include "LexerBackend.h"
+
+/// @brief a new hand written lexer over [first, last), owned by the caller
+lexer_interface* NewHandWrittenLexer(char const* first, char const* last,
+        position_type const& pos, boost::wave::language_support language);
+
+#endif /*HANDWRITTENLEXER_H*/
@@ -0,0 +1,69 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef LEXERBACKEND_H
+#define LEXERBACKEND_H
+
+/**
+ *  @file LexerBackend.h
+ *  @brief the lexers which can produce the tokens of a file. All of them
+ *  implement the Wave lex_input_interface for token_type, so the Parser,
+ *  the SpanLexer and the PreScan do not know which one runs.
+ *  slex is the default, slex-classes is the same lexer running on the
+ *  byte class dfa tables (a quarter of the size, a lookup more per byte),
+ *  the hand written lexer returns the same tokens and the stock Wave
+ *  (re2c) lexer is kept for comparison.
+ */
+
+#include "DemacBoostWaveIncludes.h"
+
+#include <string>
+#include <string_view>
+
+using lexer_interface = boost::wave::cpplexer::lex_input_interface<token_type>;
+
+/**
+ * @enum LexerBackend
+ */
+enum class LexerBackend
+{
+    slex,
+    slexByteClasses,
+    handWritten,
+    wave
+};
+
+/// @brief the backend named by the --lexer option: slex, slex-classes,
+/// hand or wave,
+/// throws an ExceptionHandler for any other name
+LexerBackend ParseLexerBackend(std::string const& name);
+
+/// @brief a new lexer over [first, last), owned by the caller
+lexer_interface* NewLexer(LexerBackend backend, char const* first, char const* last,
+        position_type const& pos, boost::wave::language_support language);
+
+/// @brief lexes the contents in place, they have to outlive the iterator
+lexer_iterator MakeLexerIterator(LexerBackend backend, std::string_view contents,
+        position_type const& pos, boost::wave::language_support language);
+
+#endif /*LEXERBACKEND_H*/
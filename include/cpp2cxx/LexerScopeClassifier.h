@@ -0,0 +1,99 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef LEXERSCOPECLASSIFIER_H
+#define LEXERSCOPECLASSIFIER_H
+
+/**
+ *  @file LexerScopeClassifier.h
+ *  @brief derives the scope of the macros and the lines where they are
+ *  invoked from the tokens seen by the Parser, without the clang front end.
+ *  Brace nesting is tracked and a brace following a closing paren (with
+ *  qualifiers or a constructor initializer list in between) is taken to
+ *  open a function body; braces after a class-key open a class.
+ */
+
+#include "DemacBoostWaveIncludes.h"
+#include "MacroScopeClassifier.h"
+#include "clang_interface/FunctionInfo.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class LexerScopeClassifier
+ * @brief fills an ASTMacroStat_t the same way the clang front end does
+ * (defined line, scope category and invoked lines of the macros)
+ */
+class LexerScopeClassifier
+{
+public:
+    explicit LexerScopeClassifier(ASTMacroStat_t& macro_stat);
+
+    /// @brief called for every token outside the preprocessor directives
+    void PutToken(token_type const& tok);
+    /// @brief called for every #define with the identifier of the macro
+    void MacroDefined(token_type const& identifier);
+    /// @brief called for every use of a macro defined in the file
+    void MacroInvoked(token_type const& identifier);
+
+    MacroScopeCategory GetCurrentScope() const;
+
+private:
+    enum class BraceKind
+    {
+        scope,
+        class_scope,
+        function,
+        block
+    };
+
+private:
+    ASTMacroStat_t& macroStat;
+    std::vector<BraceKind> braces;
+    bool insideFunction{ false };
+    int parenDepth{ 0 };
+    bool afterParen{ false };
+    bool scopeHead{ false };
+    bool classHead{ false };
+};
+
+/**
+ * @struct ScopeAgreement
+ * @brief how many of the macros found by the clang front end were
+ * classified the same way by the LexerScopeClassifier. Clang only tells
+ * apart macros inside a function, so local and inside_class are the same.
+ */
+struct ScopeAgreement
+{
+    std::size_t macros{ 0 };
+    std::size_t scopeMatches{ 0 };
+    std::size_t invocationMatches{ 0 };
+
+    ScopeAgreement& operator+=(ScopeAgreement const& other);
+};
+
+ScopeAgreement CompareScopeClassification(
+        ASTMacroStat_t const& clang_stat, ASTMacroStat_t const& lexer_stat);
+
+#endif /*LEXERSCOPECLASSIFIER_H*/
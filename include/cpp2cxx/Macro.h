@@ -89,7 +89,7 @@ public:
     //keep the function_like PPMacro's arguments and their position
     vpTokInt identifier_parameters;                // Unique to each macro
     PPOperation operation{ PPOperation::unknown }; //define or undefine etc...
-    MacroScopeCategory m_scat;                     // inside function, inside class, etc...
+    MacroScopeCategory m_scat{ MacroScopeCategory::local }; // inside function, inside class, etc...
     ReplacementList rep_list;                      // Unique to each macro
     CondCategory cond_cat{ CondCategory::config };
     std::vector<std::string> invoArgs; // Unique to each macro
@@ -0,0 +1,59 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MACROPRESCAN_H
+#define MACROPRESCAN_H
+
+/**
+ *  @file MacroPreScan.h
+ *  @brief a quick pass over the tokens of a file which decides whether
+ *  the information collected by the clang front end (scope of the macros
+ *  and the lines where they are invoked) is needed to demacrofy the file.
+ *  The clang data is only used for function like macros defined inside a
+ *  function and for object like macros whose translation is postponed to
+ *  the point of first use (statements, assignments and braces), so a file
+ *  without those can skip the clang front end.
+ */
+
+#include "DemacBoostWaveIncludes.h"
+#include "LexerBackend.h"
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @struct PreScanResult
+ */
+struct PreScanResult
+{
+    std::size_t defineCount{ 0 };
+    /// true when at least one macro needs the clang information,
+    /// also set when the file could not be lexed
+    bool needsClang{ false };
+};
+
+/// @brief scans the file contents, stops at the first macro which needs
+/// the clang information
+PreScanResult PreScanMacros(std::string_view file_str, position_type const& pos, LexerBackend backend);
+
+#endif /*MACROPRESCAN_H*/
@@ -0,0 +1,120 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MACROSNAPSHOT_H
+#define MACROSNAPSHOT_H
+
+/**
+ *  @file MacroSnapshot.h
+ *  @brief the global (predefined) macros in a compact binary form which is
+ *  memory mapped read-only and shared by the Parser, the CondParser and
+ *  all the FileSessions. Loading it costs the same for ten or ten thousand
+ *  macros, the lookups go straight to the mapped pages.
+ *
+ *  layout, all integers are 32 bit in host byte order:
+ *  header | entries sorted by name | hash index | string table
+ *  An entry holds the offsets and sizes of the name and the replacement
+ *  list in the string table, the hash index is an open addressed table
+ *  (linear probing) of entry index + 1, 0 marks an empty slot.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using MacroList_t = std::map<std::string, //identifier
+        std::string>;                     //replacement text
+
+/**
+ * @class MacroSnapshot
+ * @brief either a mapped snapshot file or one built in memory from a
+ * MacroList_t, both are accessed the same way and never modified.
+ */
+class MacroSnapshot
+{
+public:
+    /// @brief maps the snapshot file, throws ExceptionHandler when it
+    /// can't be mapped or isn't a valid snapshot
+    static std::shared_ptr<MacroSnapshot const> Map(const std::filesystem::path& snapshot_file);
+    /// @brief a snapshot of the macros, kept in memory
+    static std::shared_ptr<MacroSnapshot const> Build(MacroList_t const& macros);
+    /// @brief writes the snapshot of the macros, returns false on failure
+    static bool Write(const std::filesystem::path& snapshot_file, MacroList_t const& macros);
+
+    /// @brief true when the file starts with the header of a snapshot
+    /// written on a machine with the same byte order
+    static bool IsSnapshotFile(const std::filesystem::path& file_name);
+    /// @brief the file the snapshot of a formatted macro file is cached in
+    static std::filesystem::path GetCacheFile(const std::filesystem::path& macro_file);
+    /// @brief true when the cache is a snapshot at least as new as the file
+    static bool IsCacheFresh(const std::filesystem::path& cache_file,
+            const std::filesystem::path& macro_file);
+
+    MacroSnapshot(const MacroSnapshot&) = delete;
+    MacroSnapshot& operator=(const MacroSnapshot&) = delete;
+    ~MacroSnapshot();
+
+    bool Contains(std::string_view name) const;
+    /// @brief the replacement list of the macro
+    std::optional<std::string_view> Find(std::string_view name) const;
+
+    /// @brief the number of macros, which are indexed in sorted order
+    std::size_t size() const;
+    std::string_view GetName(std::size_t index) const;
+    std::string_view GetReplacement(std::size_t index) const;
+    /// @brief a copy of the macros as a map, for the callers which modify it
+    MacroList_t ToMacroList() const;
+
+private:
+    struct Header;
+    struct Entry;
+    struct Mapping;
+
+    MacroSnapshot() = default;
+    /// @brief points the views into data after validating the layout,
+    /// throws ExceptionHandler when it is not a valid snapshot
+    void Attach(char const* data, std::size_t size);
+    std::string_view GetString(std::uint32_t offset, std::uint32_t size) const;
+
+    /// the bytes of a snapshot built in memory, 8 byte aligned
+    std::vector<std::uint64_t> ownedBytes;
+    /// the mapping of a snapshot file
+    std::unique_ptr<Mapping> mapping;
+
+    Entry const* entries{ nullptr };
+    std::uint32_t entryCount{ 0 };
+    std::uint32_t const* slots{ nullptr };
+    std::uint32_t slotMask{ 0 };
+    char const* strings{ nullptr };
+    std::uint32_t stringsSize{ 0 };
+};
+
+using GlobalMacros_t = std::shared_ptr<MacroSnapshot const>;
+
+#endif /*MACROSNAPSHOT_H*/
@@ -36,12 +36,14 @@ limitations under the License.
  *  for compiling pass -std=c++0x to the compiler
  */
 
-#include "clang_interface/ASTConsumer.hpp"
 #include "ConfigScheme.h"
 #include "FileManager.h"
 #include "FileManagerScheme.h"
+#include "LexerScopeClassifier.h"
 #include "Parser.h"
 
+#include <chrono>
+#include <cstddef>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -52,10 +54,22 @@ limitations under the License.
 /// log the error according to the demacrofication scheme
 
 /**
- * @class MacTree
+ * @class FileSession
  * forward declaration
  */
-class MacTree;
+class FileSession;
+
+/**
+ * @class FrontEndContext
+ * forward declaration
+ */
+class FrontEndContext;
+
+/**
+ * @struct PrefixPCH
+ * forward declaration
+ */
+struct PrefixPCH;
 
 /**
  * @class Overseer
@@ -67,6 +81,7 @@ class Overseer
 {
 public:
     explicit Overseer(ConfigScheme&& config_scheme);
+    ~Overseer();
 
     void ConfigureFileManager();
     /**
@@ -82,17 +97,13 @@ public:
      * 8. call the build class
      * 9. goto step2
      * 10. catch any errors
+     * with jobs > 1 the files are processed by that many worker threads,
+     * each file in its own FileSession; the results are merged in the order
+     * of the input files so the output is the same as with jobs = 1.
+     * jobs = 0 uses one worker per hardware thread.
      */
-    void StartProcessing(bool demacrofy);
-    void RunParser(const std::filesystem::path& file_name);
-    void RunDependencyAnalyzer();
+    void StartProcessing(bool demacrofy, std::size_t jobs = 1);
     void PrintTotalOrder();
-    void RunDemacrofier();
-    void UpdateFileManager();
-    void WriteOutputFile(std::ostream& os) const;
-    //void        GetInformationFromExternalSource(const std::string& filename);
-    void GenerateExternalASTHandler(const std::string& filename);
-    //void        GenerateExternalASTHandler();
     std::ostream& GetLogFile();
     std::ostream& GetMacroStatFile();
     std::ostream& GetStatFile();
@@ -101,14 +112,49 @@ public:
     FileManagerScheme& GetFileManagerScheme();
 
 
+private:
+    std::unique_ptr<FileSession> MakeSession(std::size_t file_index, FrontEndContext* front_end);
+    /// @brief makes sure there is one clang front end for each worker,
+    /// none in the lexer mode
+    void InitializeFrontEnds(std::size_t jobs);
+    /// @brief precompiles the prefix headers of the DemacroficationScheme
+    /// once for all the front ends
+    void InitializePrefixPCH();
+    /// @brief writes the results of the session to the log, stat and output
+    /// files, returns false when the processing has to stop
+    bool MergeSession(FileSession const& session);
+    /// @brief writes how often the clang front end was run or skipped
+    /// and the time spent in it to the macro stat file
+    void PrintFrontEndStats();
+    void ProcessSerially(bool demacrofy);
+    void ProcessInParallel(bool demacrofy, std::size_t jobs);
+
 private:
     ConfigScheme configScheme;
     std::unique_ptr<FileManager> pFileManager;
+    /// \brief loads the global macros which are shared by all the sessions
     std::unique_ptr<Parser> pParser;
-    const MacTree* pMacTree {nullptr};
-    MyASTConsumer pASTConsumer;
-    /// \brief holds information returned from clang AST
-    ASTMacroStat_t ASTMacroStat;
+    /// \brief clang front ends kept alive across the files, one per worker
+    std::vector<std::unique_ptr<FrontEndContext>> frontEnds;
+    /// \brief shared by the front ends, null without prefix headers
+    std::unique_ptr<PrefixPCH> prefixPCH;
+    /// \brief running totals written to the macro stat file
+    std::size_t macroCount{ 0 };
+    std::size_t functionLikeCount{ 0 };
+    std::size_t objectLikeCount{ 0 };
+    /// \brief bytes of the parsed files and those the parser didn't lex
+    std::size_t sourceBytes{ 0 };
+    std::size_t skippedSourceBytes{ 0 };
+    /// bytes of the largest MacTree, with its nodes and macros, of a file
+    std::size_t peakAnalysisArenaBytes{ 0 };
+    /// \brief running totals of the clang front end usage
+    std::size_t clangParsedFiles{ 0 };
+    std::size_t clangSkippedFiles{ 0 };
+    std::chrono::nanoseconds clangTime{ 0 };
+    std::chrono::nanoseconds preScanTime{ 0 };
+    std::size_t prefixPCHFiles{ 0 };
+    std::chrono::nanoseconds pchBuildTime{ 0 };
+    ScopeAgreement scopeAgreement;
 };
 
 #endif /*OVERSEER_H*/
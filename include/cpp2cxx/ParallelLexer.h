@@ -0,0 +1,62 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PARALLELLEXER_H
+#define PARALLELLEXER_H
+
+/**
+ *  @file ParallelLexer.h
+ *  @brief lexes a large file on several threads. The file is cut at line
+ *  starts which most likely begin a token, each chunk is lexed on its own
+ *  thread and the chunks are stitched together where the token boundaries
+ *  of the preceding chunk meet those of the next one. A chunk which started
+ *  inside a token (e.g. in a comment) is relexed from the preceding one, so
+ *  the tokens are always the ones of the sequential lexer. All the chunks
+ *  share the line index of the file, their positions need no fixing up.
+ */
+
+#include "DemacBoostWaveIncludes.h"
+#include "LexerBackend.h"
+#include "SourceSpanScanner.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/// smaller files are not worth a thread
+constexpr std::size_t minParallelLexChunk = std::size_t(1) << 20;
+
+/// @brief the tokens of the contents including the T_EOF, lexed in chunks of
+/// at least min_chunk bytes on up to threads threads (0 uses all hardware
+/// threads). The Wave backend is always run on the calling thread.
+std::vector<token_type> LexInParallel(LexerBackend backend, std::string_view contents,
+        position_type const& pos, boost::wave::language_support language, std::size_t threads,
+        std::size_t min_chunk = minParallelLexChunk);
+
+/// @brief the tokens of MakeSpanTokenIterator, the spans are independent
+/// of each other so groups of them are lexed on up to threads threads
+std::vector<token_type> LexSpansInParallel(LexerBackend backend, std::string_view contents,
+        SourceSpans const& spans, position_type const& pos, boost::wave::language_support language,
+        std::size_t threads, std::size_t min_chunk = minParallelLexChunk);
+
+#endif /*PARALLELLEXER_H*/
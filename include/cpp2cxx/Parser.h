@@ -39,11 +39,16 @@ limitations under the License.
  *  for compiling pass -std=c++0x to the compiler
  */
 
+#include "AnalysisArena.h"
 #include "CondParser.h"
 #include "Demacrofier.h"
 #include "DepGraph.h"
+#include "LexerBackend.h"
+#include "MacroSnapshot.h"
 #include "MacroStat.h"
 #include "RlParser.h"
+#include "SplicePlan.h"
+#include "TokenArena.h"
 #include "clang_interface/FunctionInfo.h"
 
 #include <iosfwd> //for void Parser::GetDemacrofiedFile(std::ostream os)
@@ -51,6 +56,7 @@ limitations under the License.
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -68,6 +74,16 @@ struct DemacroficationScheme;
  */
 class PPMacro;
 
+/** forward declaration
+ * @class LexerScopeClassifier
+ */
+class LexerScopeClassifier;
+
+/** forward declaration
+ * @class SourceBuffer
+ */
+class SourceBuffer;
+
 /**
  * @class Parser
  */
@@ -75,37 +91,80 @@ class Parser
 {
 
 public:
+    /// @brief reads (or parses) the global macros as configured in the
+    /// demacrofication scheme
+    Parser(DemacroficationScheme const& demacrofication_scheme, std::ostream& log_file);
+    /// @brief shares the global macros already loaded by another Parser,
+    /// so that a Parser can be created for each file cheaply. The MacTree
+    /// is allocated from analysis_arena when given, which must outlive the
+    /// Parser, otherwise from an arena of the Parser.
     Parser(DemacroficationScheme const& demacrofication_scheme, std::ostream& log_file,
-            std::ostream& macro_list_file);
+            GlobalMacros_t global_macros, AnalysisArena* analysis_arena = nullptr);
 
     void Parse(const std::filesystem::path& file_name);
-    void Parse(const std::filesystem::path& file_name, ASTMacroStat_t* p,
-            InvocationStat_t* is = nullptr);
+    /// @brief parses the file already read into source, the tokens keep
+    /// their own copies of the text so source may go after the parse,
+    /// unless the file is demacrofied: the output is spliced from source
+    void Parse(const std::filesystem::path& file_name, SourceBuffer const& source);
+    void Parse(const std::filesystem::path& file_name, SourceBuffer const& source,
+            ASTMacroStat_t* p, InvocationStat_t* is = nullptr);
 
     void ParseNewGlobalMacros(const std::string& raw_global_macro_file_name);
+    /// @brief takes the predefined macros from the clang front end, or
+    /// from their snapshot cached for the configuration of the front end
+    void LoadClangPredefinedMacros();
+    /// @brief maps the snapshot of the formatted global macros, the file
+    /// is either a snapshot or text whose snapshot is cached next to it
     void ReadGlobalMacros(const std::filesystem::path& global_macro_file_name);
+    /// @brief the classifier sees the tokens of the local macros while
+    /// they are parsed, and records the scope and invocations of the macros
+    void SetScopeClassifier(LexerScopeClassifier* scope_classifier);
     //Parser(std::string instr, position_type pos);
 
-    MacTree const* GetMacTree();
+    /// @brief the tree of the last ParseMacros, which builds the
+    /// dependency list on demand
+    MacTree* GetMacTree();
+    GlobalMacros_t const& GetGlobalMacros() const;
+    /// @brief statistics of the macros parsed so far
+    std::size_t GetMacroCount() const;
+    std::size_t GetFunctionLikeCount() const;
+    std::size_t GetObjectLikeCount() const;
+    /// @brief bytes of the file which were not lexed, see SourceSpanScanner.h
+    std::size_t GetSkippedSourceBytes() const;
+    std::vector<MacroStat> const& GetMacroStats() const;
     /** @function Configure
       * for loading the configuration file dynamically
       */
     void Configure(DemacroficationScheme const& demacrofication_scheme);
 
+    /// @brief parses the tokens lexed by LexLocalMacros into a new MacTree
     void ParseMacros(MacroList_t& macro_list);
     void ParseGlobalMacros();
-    void ParseLocalMacros(std::string ifileStr, const position_type& pos);
+    /// @brief LexLocalMacros followed by ParseMacros of the local macros
+    void ParseLocalMacros(std::string_view source, const position_type& pos);
+    /// @brief lexes the source into the token arena and rewinds to the
+    /// first token, the spans lexed depend on the scope classifier
+    void LexLocalMacros(std::string_view source, const position_type& pos);
 
     bool PPCheckIdentifier(std::string const& id_value) const;
     bool PPCheckIdentifier(std::string const& id_str, MacroList_t const& macro_list) const;
     void GetDemacrofiedFile(std::ostream& os);
-    //std::stringstream const& GetDemacrofiedFile();
+    /// @brief the edits of the source made by the last Demacrofy, for the
+    /// caller which keeps the source and writes the output later
+    SplicePlan TakeSplicePlan();
     void PPAnalyzeMacroDependency(std::ostream& os);
     // when multiple occurences of same macros are allowed multiple_definitions=true
     void Demacrofy(std::ostream& stat, bool multiple_definitions = false);
 
 private:
+    /// @brief lexes and parses the #defines of the global macros
+    MacroList_t ParseGlobalMacroSource(std::string_view source, std::string const& source_name);
     void InitializeMacTree();
+    /// @brief the byte offset of the token in the lexed source
+    std::size_t SourceOffset(token_iterator tok_iter) const;
+    /// @brief moves the translations postponed by the Demacrofier into the
+    /// plan, before the line of the first invocation unless it is before from
+    void SplicePostponedTranslations(std::size_t from);
     void PPDefineHandler(MacroList_t& macro_list, PPMacro& macro_ref);
     std::string PPUndefHandler(MacroList_t& macro_list, PPMacro& macro_ref);
     void PPIfHandler(Node& node);
@@ -130,8 +189,12 @@ private:
     /// @brief contains line numbers whre the macros are invoked
     InvocationStat_t* pInvocationStat{ nullptr };
 
+    /// @brief classifies the scope of the macros without clang, may be null
+    LexerScopeClassifier* pScopeClassifier{ nullptr };
+
     /**
-     * Variables initialized in the body of the constructor
+     * Variables initialized when a file is lexed
+     *     @var TokenArena tokens;//all the tokens of the file
      *     @var token_iterator it;//current token
      *     @var token_iterator it_begin;//first token
      *     @var token_iterator it_end;//one past the last token
@@ -141,19 +204,23 @@ private:
     std::unique_ptr<RlParser> rp;
     std::unique_ptr<Demacrofier> demac;
 
-    token_iterator it;       //current token
-    token_iterator it_begin; //first token
-    token_iterator it_end;   //one past the last token
+    /// @brief line index of the global macro source, the tokens of the
+    /// files come with the index of their SourceBuffer
+    boost::wave::cpplexer::source_index globalSourceIndex;
+    TokenArena tokens;                         //all the tokens of the file
+    token_iterator it{ tokens.begin() };       //current token
+    token_iterator it_begin{ tokens.begin() }; //first token
+    token_iterator it_end{ tokens.end() };     //one past the last token
     /**
       * variables to be passed to the constructor to be called by the
       * Overseer class
       */
     /// information for the parser and demacrofier on how to demacrofy
     DemacroficationScheme const* pDemacroficationScheme;
+    /// the lexer which fills the tokens, from the scheme
+    LexerBackend lexerBackend;
     /// log file to store all the errors and warnings etc.
     std::ostream& logFile;
-    /// file to store the complete macro(identifier+repl_text)
-    std::ostream& mlFile;
     /**
      * Variables initialized in the initializer list of the constructor
      *     @var int nesting_level;
@@ -184,26 +251,31 @@ private:
      * @var MacroList_t localMacros;
      * @var MacroList_t globalMacros;
      * @var MacTree tree;
-     * @var std::stringstream outStream;
-     * @var std::string ifileStr;
+     * @var SplicePlan splicePlan;
      */
     /// @brief useful for passing around the conditional statement
     std::vector<token_type> condStmt;
     /// @brief list of macros in the current file
     MacroList_t localMacros;
-    /// @brief list of predefined macros
-    // FIXME: Make this static.
-    MacroList_t globalMacros;
-    /// @brief make this a pointer to tree and dynamically allocate
+    /// @brief list of predefined macros, shared read-only with the
+    /// CondParser and the Parsers of the other files
+    GlobalMacros_t globalMacros;
+    /// @brief the MacTree, its nodes and macros of the last ParseMacros
+    AnalysisArena ownArena;
+    AnalysisArena* pArena{ &ownArena };
+    /// @brief allocated from *pArena, which releases it with the next tree
     MacTree* pTree{ nullptr };
-    /// @brief demacrofied file
-    std::stringstream outStream;
-    /// @brief the input file contents
-    std::string ifileStr;
+    /// @brief the source last lexed by LexLocalMacros, the demacrofied
+    /// file is the source with the edits of splicePlan
+    std::string_view sourceText;
+    /// @brief kept when Parse read the file itself
+    std::shared_ptr<SourceBuffer const> ownedSource;
+    SplicePlan splicePlan;
     /// @brief statistics
     std::size_t macro_count{ 0 };
     std::size_t object_like_count{ 0 };
     std::size_t function_like_count{ 0 };
+    std::size_t skipped_source_bytes{ 0 };
     std::vector<MacroStat> vec_macro_stat;
 };
 
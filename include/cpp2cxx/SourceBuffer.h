@@ -0,0 +1,73 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+
+/**
+ *  @file SourceBuffer.h
+ *  @brief the contents of an input file, read with a single read and
+ *  shared by the pre-scan, the clang front end and the Wave lexer of the
+ *  Parser, none of which copies it. The demacrofied file is written as
+ *  slices of it between the edits of the Demacrofier. Its line index is
+ *  built once and shared by all the lexers of the file.
+ */
+
+#include "slex_position.hpp"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+/**
+ * @class SourceBuffer
+ * @brief the whole file followed by a newline, in case the replacement
+ * list of the last macro doesn't end with one. The contents are null
+ * terminated so clang can use them without a copy.
+ */
+class SourceBuffer
+{
+public:
+    /// @brief reads the file, check IsOpen for errors
+    explicit SourceBuffer(const std::filesystem::path& file_name);
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    bool IsOpen() const;
+    std::string_view GetContents() const;
+
+    /// @brief the indexed position of the first byte of the contents,
+    /// the lexers of the file start from it
+    boost::wave::cpplexer::slex_position GetPosition() const;
+    /// @brief drops the line index when the tokens of the file are no
+    /// longer resolved, the contents are kept
+    void ReleaseLineIndex();
+
+private:
+    std::string contents;
+    bool isOpen{ false };
+    boost::wave::cpplexer::source_index lineIndex;
+};
+
+#endif /*SOURCEBUFFER_H*/
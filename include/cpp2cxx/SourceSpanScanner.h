@@ -0,0 +1,80 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SOURCESPANSCANNER_H
+#define SOURCESPANSCANNER_H
+
+/**
+ *  @file SourceSpanScanner.h
+ *  @brief a byte level scan of a file, vectorized where SSE2/AVX2 is
+ *  available, which splits the file into the spans the Parser has to see
+ *  as tokens and the spans it only copies to the demacrofied file.
+ *  A span is relevant when it contains a directive, an identifier #defined
+ *  earlier in the file (up to the closing paren of its arguments) or the
+ *  first invocation of a macro reported by clang. Comments and literals
+ *  are skipped the way the Wave lexer matches them, so the spans always
+ *  begin at the start of a token.
+ */
+
+#include "DemacBoostWaveIncludes.h"
+#include "LexerBackend.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct SourceSpan
+ * @brief whole lines of the file, starting at line number `line`
+ */
+struct SourceSpan
+{
+    std::size_t begin{ 0 };
+    std::size_t end{ 0 };
+    std::size_t line{ 1 };
+    bool relevant{ false };
+};
+
+/**
+ * @struct SourceSpans
+ */
+struct SourceSpans
+{
+    std::vector<SourceSpan> spans;
+    /// false when the file uses something the scan does not model
+    /// (trigraphs or a carriage return without a newline), the file
+    /// has to be lexed as a whole then
+    bool usable{ false };
+    std::size_t skippedBytes{ 0 };
+};
+
+/// @brief splits the contents into spans, keep_lines are the line numbers
+/// which must be seen as tokens in any case
+SourceSpans ScanSourceSpans(std::string_view contents, std::vector<std::size_t> const& keep_lines);
+
+/// @brief lexes the relevant spans with the given lexer backend, every
+/// skipped span is returned as a single T_ANY token holding its text
+lexer_iterator MakeSpanTokenIterator(std::string_view contents, SourceSpans const& spans,
+        position_type const& pos, boost::wave::language_support language, LexerBackend backend);
+
+#endif /*SOURCESPANSCANNER_H*/
@@ -0,0 +1,81 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#ifndef SPLICEPLAN_H
+#define SPLICEPLAN_H
+
+/**
+ *  @file SplicePlan.h
+ *  @brief the demacrofied file as a list of edits of the source file:
+ *  byte ranges replaced by the translations of the #defines and the
+ *  postponed translations inserted before a line. The output is the
+ *  untouched slices of the source between the edits and the generated
+ *  fragments, so writing it costs the number of edits, not of tokens.
+ */
+
+#include <cstddef>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class SplicePlan
+ * @brief the offsets are byte offsets into the source the plan is written
+ * with. Edits may be added in any order; insertions at the same offset
+ * keep their order and go before a replacement starting there, and an
+ * insertion inside a replaced range goes to its end.
+ */
+class SplicePlan
+{
+public:
+    /// @brief the bytes [begin, end) of the source are replaced by fragment
+    void Replace(std::size_t begin, std::size_t end, std::string fragment);
+    /// @brief fragment is inserted before the byte at offset
+    void Insert(std::size_t offset, std::string fragment);
+    void Clear();
+
+    std::size_t GetEditCount() const;
+
+    /// @brief the output in order, views into source and into the plan
+    std::vector<std::string_view> GetSlices(std::string_view source) const;
+
+    void Write(std::ostream& os, std::string_view source) const;
+    /// @brief writes the slices with vectored I/O where available,
+    /// replacing the file; returns false when it could not be written
+    bool WriteFile(const std::filesystem::path& file_name, std::string_view source) const;
+
+private:
+    struct Edit
+    {
+        std::size_t begin;
+        std::size_t end;
+        std::string fragment;
+    };
+
+    std::vector<Edit> edits;
+};
+
+#endif /*SPLICEPLAN_H*/
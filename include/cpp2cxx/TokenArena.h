@@ -0,0 +1,70 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef TOKENARENA_H
+#define TOKENARENA_H
+
+/**
+ *  @file TokenArena.h
+ *  @brief the tokens of a file, lexed once into a contiguous array.
+ *  The Parser, CondParser, UseCaseState and Demacrofier walk it with
+ *  token_iterator, so rewinding, lookahead and GoPastMacro are plain
+ *  pointer arithmetic.
+ */
+
+#include "DemacBoostWaveIncludes.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class TokenArena
+ * @brief the tokens are followed by a T_EOI token, so dereferencing end()
+ * gives the same eoi token the multi_pass lexer iterator did. The array
+ * is only refilled by Lex, which invalidates all the token_iterators.
+ */
+class TokenArena
+{
+public:
+    TokenArena();
+
+    TokenArena(const TokenArena&) = delete;
+    TokenArena& operator=(const TokenArena&) = delete;
+
+    /// @brief drains the lexer, replacing the previous tokens; they are
+    /// kept when the lexer throws
+    void Lex(lexer_iterator first, const lexer_iterator& last);
+
+    /// @brief takes the tokens lexed elsewhere (e.g. by LexInParallel),
+    /// replacing the previous tokens
+    void Assign(std::vector<token_type> lexed);
+
+    token_iterator begin() const;
+    token_iterator end() const;
+    std::size_t size() const;
+
+private:
+    std::vector<token_type> tokens;
+};
+
+#endif /*TOKENARENA_H*/
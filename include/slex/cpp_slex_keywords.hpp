@@ -0,0 +1,277 @@
+/*=============================================================================
+    Boost.Wave: A Standard compliant C++ preprocessor library
+
+    Keyword recognition of the SLex based C++ lexer
+
+    http://www.boost.org/
+
+    Copyright (c) 2001-2012 Hartmut Kaiser. Distributed under the Boost
+    Software License, Version 1.0. (See accompanying file
+    LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#if !defined(SLEX_KEYWORDS_HPP_0D6B2F4E_7A31_4C59_8E2D_93F1A6C0B7E4_INCLUDED)
+#define SLEX_KEYWORDS_HPP_0D6B2F4E_7A31_4C59_8E2D_93F1A6C0B7E4_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include <boost/wave/wave_config.hpp>
+#include <boost/wave/language_support.hpp>
+#include <boost/wave/token_ids.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace boost {
+namespace wave {
+namespace cpplexer {
+namespace slex {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The dfa matches the keywords as identifiers, they are told apart by a
+//  perfect hash of the length and a few bytes of the identifier. The hash
+//  table is built at compile time, a keyword added to keyword_data which
+//  collides with another one makes the build fail: choose another
+//  keyword_multiplier then.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// the languages a keyword belongs to
+enum class keyword_set : unsigned char
+{
+    common,     // C++ and C99
+    cpp,        // C++ only (the alternative tokens)
+    import,     // C++ only, BOOST_WAVE_SUPPORT_IMPORT_KEYWORD
+    cpp0x,      // C++0x only
+    msext       // BOOST_WAVE_SUPPORT_MS_EXTENSIONS
+};
+
+struct keyword_entry
+{
+    std::string_view name;
+    token_id id;
+    keyword_set set;
+};
+
+#define KEYWORD_DATA(id, name, set)                                          \
+        { name, T_##id, keyword_set::set }                                    \
+    /**/
+
+inline constexpr keyword_entry keyword_data[] =
+{
+    KEYWORD_DATA(ASM, "asm", common),
+    KEYWORD_DATA(AUTO, "auto", common),
+    KEYWORD_DATA(BOOL, "bool", common),
+    KEYWORD_DATA(FALSE, "false", common),
+    KEYWORD_DATA(TRUE, "true", common),
+    KEYWORD_DATA(BREAK, "break", common),
+    KEYWORD_DATA(CASE, "case", common),
+    KEYWORD_DATA(CATCH, "catch", common),
+    KEYWORD_DATA(CHAR, "char", common),
+    KEYWORD_DATA(CLASS, "class", common),
+    KEYWORD_DATA(CONST, "const", common),
+    KEYWORD_DATA(CONSTCAST, "const_cast", common),
+    KEYWORD_DATA(CONTINUE, "continue", common),
+    KEYWORD_DATA(DEFAULT, "default", common),
+    KEYWORD_DATA(DELETE, "delete", common),
+    KEYWORD_DATA(DO, "do", common),
+    KEYWORD_DATA(DOUBLE, "double", common),
+    KEYWORD_DATA(DYNAMICCAST, "dynamic_cast", common),
+    KEYWORD_DATA(ELSE, "else", common),
+    KEYWORD_DATA(ENUM, "enum", common),
+    KEYWORD_DATA(EXPLICIT, "explicit", common),
+    KEYWORD_DATA(EXPORT, "export", common),
+    KEYWORD_DATA(EXTERN, "extern", common),
+    KEYWORD_DATA(FLOAT, "float", common),
+    KEYWORD_DATA(FOR, "for", common),
+    KEYWORD_DATA(FRIEND, "friend", common),
+    KEYWORD_DATA(GOTO, "goto", common),
+    KEYWORD_DATA(IF, "if", common),
+    KEYWORD_DATA(INLINE, "inline", common),
+    KEYWORD_DATA(INT, "int", common),
+    KEYWORD_DATA(LONG, "long", common),
+    KEYWORD_DATA(MUTABLE, "mutable", common),
+    KEYWORD_DATA(NAMESPACE, "namespace", common),
+    KEYWORD_DATA(NEW, "new", common),
+    KEYWORD_DATA(OPERATOR, "operator", common),
+    KEYWORD_DATA(PRIVATE, "private", common),
+    KEYWORD_DATA(PROTECTED, "protected", common),
+    KEYWORD_DATA(PUBLIC, "public", common),
+    KEYWORD_DATA(REGISTER, "register", common),
+    KEYWORD_DATA(REINTERPRETCAST, "reinterpret_cast", common),
+    KEYWORD_DATA(RETURN, "return", common),
+    KEYWORD_DATA(SHORT, "short", common),
+    KEYWORD_DATA(SIGNED, "signed", common),
+    KEYWORD_DATA(SIZEOF, "sizeof", common),
+    KEYWORD_DATA(STATIC, "static", common),
+    KEYWORD_DATA(STATICCAST, "static_cast", common),
+    KEYWORD_DATA(STRUCT, "struct", common),
+    KEYWORD_DATA(SWITCH, "switch", common),
+    KEYWORD_DATA(TEMPLATE, "template", common),
+    KEYWORD_DATA(THIS, "this", common),
+    KEYWORD_DATA(THROW, "throw", common),
+    KEYWORD_DATA(TRY, "try", common),
+    KEYWORD_DATA(TYPEDEF, "typedef", common),
+    KEYWORD_DATA(TYPEID, "typeid", common),
+    KEYWORD_DATA(TYPENAME, "typename", common),
+    KEYWORD_DATA(UNION, "union", common),
+    KEYWORD_DATA(UNSIGNED, "unsigned", common),
+    KEYWORD_DATA(USING, "using", common),
+    KEYWORD_DATA(VIRTUAL, "virtual", common),
+    KEYWORD_DATA(VOID, "void", common),
+    KEYWORD_DATA(VOLATILE, "volatile", common),
+    KEYWORD_DATA(WCHART, "wchar_t", common),
+    KEYWORD_DATA(WHILE, "while", common),
+
+    KEYWORD_DATA(AND_ALT, "bitand", cpp),
+    KEYWORD_DATA(ANDASSIGN_ALT, "and_eq", cpp),
+    KEYWORD_DATA(ANDAND_ALT, "and", cpp),
+    KEYWORD_DATA(OR_ALT, "bitor", cpp),
+    KEYWORD_DATA(ORASSIGN_ALT, "or_eq", cpp),
+    KEYWORD_DATA(OROR_ALT, "or", cpp),
+    KEYWORD_DATA(XORASSIGN_ALT, "xor_eq", cpp),
+    KEYWORD_DATA(XOR_ALT, "xor", cpp),
+    KEYWORD_DATA(NOTEQUAL_ALT, "not_eq", cpp),
+    KEYWORD_DATA(NOT_ALT, "not", cpp),
+    KEYWORD_DATA(COMPL_ALT, "compl", cpp),
+    KEYWORD_DATA(IMPORT, "import", import),
+
+    KEYWORD_DATA(ALIGNAS, "alignas", cpp0x),
+    KEYWORD_DATA(ALIGNOF, "alignof", cpp0x),
+    KEYWORD_DATA(CHAR16_T, "char16_t", cpp0x),
+    KEYWORD_DATA(CHAR32_T, "char32_t", cpp0x),
+    KEYWORD_DATA(CONSTEXPR, "constexpr", cpp0x),
+    KEYWORD_DATA(DECLTYPE, "decltype", cpp0x),
+    KEYWORD_DATA(NOEXCEPT, "noexcept", cpp0x),
+    KEYWORD_DATA(NULLPTR, "nullptr", cpp0x),
+    KEYWORD_DATA(STATICASSERT, "static_assert", cpp0x),
+    KEYWORD_DATA(THREADLOCAL, "threadlocal", cpp0x),
+
+    KEYWORD_DATA(MSEXT_INT8, "__int8", msext),
+    KEYWORD_DATA(MSEXT_INT16, "__int16", msext),
+    KEYWORD_DATA(MSEXT_INT32, "__int32", msext),
+    KEYWORD_DATA(MSEXT_INT64, "__int64", msext),
+    KEYWORD_DATA(MSEXT_BASED, "_based", msext),
+    KEYWORD_DATA(MSEXT_BASED, "__based", msext),
+    KEYWORD_DATA(MSEXT_DECLSPEC, "_declspec", msext),
+    KEYWORD_DATA(MSEXT_DECLSPEC, "__declspec", msext),
+    KEYWORD_DATA(MSEXT_CDECL, "_cdecl", msext),
+    KEYWORD_DATA(MSEXT_CDECL, "__cdecl", msext),
+    KEYWORD_DATA(MSEXT_FASTCALL, "_fastcall", msext),
+    KEYWORD_DATA(MSEXT_FASTCALL, "__fastcall", msext),
+    KEYWORD_DATA(MSEXT_STDCALL, "_stdcall", msext),
+    KEYWORD_DATA(MSEXT_STDCALL, "__stdcall", msext),
+    KEYWORD_DATA(MSEXT_TRY, "__try", msext),
+    KEYWORD_DATA(MSEXT_EXCEPT, "__except", msext),
+    KEYWORD_DATA(MSEXT_FINALLY, "__finally", msext),
+    KEYWORD_DATA(MSEXT_LEAVE, "__leave", msext),
+    KEYWORD_DATA(MSEXT_INLINE, "_inline", msext),
+    KEYWORD_DATA(MSEXT_INLINE, "__inline", msext),
+    KEYWORD_DATA(MSEXT_ASM, "_asm", msext),
+    KEYWORD_DATA(MSEXT_ASM, "__asm", msext),
+};
+
+#undef KEYWORD_DATA
+
+inline constexpr std::size_t keyword_min_length = 2;
+inline constexpr std::size_t keyword_max_length = 16;
+inline constexpr unsigned int keyword_hash_bits = 10;
+inline constexpr std::uint64_t keyword_multiplier = 0xa9165c42dee52043ull;
+
+// the length, the first two, the last and the third last byte (which tells
+// char16_t from char32_t) of a name with keyword_min_length or more bytes
+constexpr std::size_t
+keyword_hash(char const* name, std::size_t length)
+{
+    std::uint64_t const key = std::uint64_t(length)
+        | std::uint64_t((unsigned char)name[0]) << 8
+        | std::uint64_t((unsigned char)name[1]) << 16
+        | std::uint64_t((unsigned char)name[length - 1]) << 24
+        | std::uint64_t(length > 2 ? (unsigned char)name[length - 3] : 0) << 32;
+    return std::size_t((key * keyword_multiplier) >> (64 - keyword_hash_bits));
+}
+
+// the index of the keyword + 1 in each slot, 0 for an empty slot
+using keyword_table = std::array<unsigned char, std::size_t(1) << keyword_hash_bits>;
+
+constexpr keyword_table
+make_keyword_table()
+{
+    static_assert(std::size(keyword_data) < 255, "too many keywords");
+
+    keyword_table table{};
+    for (std::size_t i = 0; i < std::size(keyword_data); ++i)
+    {
+        std::string_view const name = keyword_data[i].name;
+        if (name.size() < keyword_min_length || name.size() > keyword_max_length)
+            throw "keyword length out of range";
+
+        auto& slot = table[keyword_hash(name.data(), name.size())];
+        if (slot != 0)
+            throw "keyword hash collision, choose another keyword_multiplier";
+        slot = (unsigned char)(i + 1);
+    }
+    return table;
+}
+
+inline constexpr keyword_table keyword_slots = make_keyword_table();
+
+///////////////////////////////////////////////////////////////////////////////
+//  the id of the keyword spelled by an identifier, T_IDENTIFIER if it's none
+//  in the given language
+inline token_id
+classify_identifier(char const* name, std::size_t length,
+    boost::wave::language_support language)
+{
+    if (length < keyword_min_length || length > keyword_max_length)
+        return T_IDENTIFIER;
+
+    unsigned char const slot = keyword_slots[keyword_hash(name, length)];
+    if (slot == 0)
+        return T_IDENTIFIER;
+
+    keyword_entry const& keyword = keyword_data[slot - 1];
+    if (keyword.name != std::string_view(name, length))
+        return T_IDENTIFIER;
+
+    switch (keyword.set) {
+    case keyword_set::common:
+        return keyword.id;
+
+    case keyword_set::cpp:
+        return !boost::wave::need_c99(language) ? keyword.id : T_IDENTIFIER;
+
+    case keyword_set::import:
+#if BOOST_WAVE_SUPPORT_IMPORT_KEYWORD != 0
+        return !boost::wave::need_c99(language) ? keyword.id : T_IDENTIFIER;
+#else
+        return T_IDENTIFIER;
+#endif
+
+    case keyword_set::cpp0x:
+#if BOOST_WAVE_SUPPORT_CPP0X != 0
+        return boost::wave::need_cpp0x(language) ? keyword.id : T_IDENTIFIER;
+#else
+        return T_IDENTIFIER;
+#endif
+
+    case keyword_set::msext:
+#if BOOST_WAVE_SUPPORT_MS_EXTENSIONS != 0
+        return keyword.id;
+#else
+        return T_IDENTIFIER;
+#endif
+    }
+    return T_IDENTIFIER;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}   // namespace slex
+}   // namespace cpplexer
+}   // namespace wave
+}   // namespace boost
+
+#endif // !defined(SLEX_KEYWORDS_HPP_0D6B2F4E_7A31_4C59_8E2D_93F1A6C0B7E4_INCLUDED)
@@ -13,6 +13,10 @@
 #if !defined(SLEX_LEXER_HPP_5E8E1DF0_BB41_4938_B7E5_A4BB68222FF6_INCLUDED)
 #define SLEX_LEXER_HPP_5E8E1DF0_BB41_4938_B7E5_A4BB68222FF6_INCLUDED
 
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <string>
 #if defined(BOOST_SPIRIT_DEBUG)
 #include <iostream>
@@ -39,6 +43,11 @@
 #include "../slex_iterator.hpp"
 
 #include "lexer.hpp"   // "spirit/lexer.hpp"
+#include "cpp_slex_keywords.hpp"
+
+#if defined(CPP2CXX_SLEX_STATIC_DFA)
+#include "slex_dfa_tables.hpp"
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace boost {
@@ -51,13 +60,13 @@ namespace lexer {
 //  The following numbers are the array sizes of the token regex's which we
 //  need to specify to make the CW compiler happy (at least up to V9.5).
 #if BOOST_WAVE_SUPPORT_MS_EXTENSIONS != 0
-#define INIT_DATA_SIZE              175
+#define INIT_DATA_SIZE              97
 #else
-#define INIT_DATA_SIZE              158
+#define INIT_DATA_SIZE              95
 #endif
-#define INIT_DATA_CPP_SIZE          15
+#define INIT_DATA_CPP_SIZE          4
 #define INIT_DATA_PP_NUMBER_SIZE    2
-#define INIT_DATA_CPP0X_SIZE        15
+#define INIT_DATA_CPP0X_SIZE        5
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -67,18 +76,18 @@ namespace lexer {
 
 ///////////////////////////////////////////////////////////////////////////////
 //  The following lexer_base class was necessary to workaround a CodeWarrior
-//  bug (at least up to CW V9.5).
+//  bug (at least up to CW V9.5). The lexer runs on the plain iterators, the
+//  positions are computed from the offsets of the tokens.
 template <typename IteratorT, typename PositionT>
 class lexer_base
-:   public boost::spirit::classic::lexer<
-        boost::wave::util::position_iterator<IteratorT, PositionT> >
+:   public boost::spirit::classic::lexer<IteratorT>
 {
 protected:
-    using iterator_type = boost::wave::util::position_iterator<IteratorT, PositionT>;
+    using iterator_type = IteratorT;
     using char_type = typename std::iterator_traits<IteratorT>::value_type;
     using base_type = boost::spirit::classic::lexer<iterator_type>;
 
-    lexer_base();
+    explicit lexer_base(boost::spirit::classic::dfa_layout layout);
 
 // initialization data (regular expressions for the token definitions)
     struct lexer_data {
@@ -97,6 +106,11 @@ class lexer
 public:
     using token_type = boost::wave::cpplexer::slex_token<PositionT>;
 
+    explicit lexer(boost::spirit::classic::dfa_layout layout =
+            boost::spirit::classic::dfa_layout::full_rows)
+    :   lexer_base<IteratorT, PositionT>(layout)
+    {}
+
     void init_dfa(boost::wave::language_support language);
 
 // get time of last compilation
@@ -259,69 +273,6 @@ lexer<IteratorT, PositionT>::init_data[INIT_DATA_SIZE] =
     TOKEN_DATA(COMPL, Q("~")),
     TOKEN_DATA(COMPL_TRIGRAPH, TRI("-")),
     TOKEN_DATA(STARASSIGN, Q("*=")),
-    TOKEN_DATA(ASM, "asm"),
-    TOKEN_DATA(AUTO, "auto"),
-    TOKEN_DATA(BOOL, "bool"),
-    TOKEN_DATA(FALSE, "false"),
-    TOKEN_DATA(TRUE, "true"),
-    TOKEN_DATA(BREAK, "break"),
-    TOKEN_DATA(CASE, "case"),
-    TOKEN_DATA(CATCH, "catch"),
-    TOKEN_DATA(CHAR, "char"),
-    TOKEN_DATA(CLASS, "class"),
-    TOKEN_DATA(CONST, "const"),
-    TOKEN_DATA(CONSTCAST, "const_cast"),
-    TOKEN_DATA(CONTINUE, "continue"),
-    TOKEN_DATA(DEFAULT, "default"),
-    TOKEN_DATA(DELETE, "delete"),
-    TOKEN_DATA(DO, "do"),
-    TOKEN_DATA(DOUBLE, "double"),
-    TOKEN_DATA(DYNAMICCAST, "dynamic_cast"),
-    TOKEN_DATA(ELSE, "else"),
-    TOKEN_DATA(ENUM, "enum"),
-    TOKEN_DATA(EXPLICIT, "explicit"),
-    TOKEN_DATA(EXPORT, "export"),
-    TOKEN_DATA(EXTERN, "extern"),
-    TOKEN_DATA(FLOAT, "float"),
-    TOKEN_DATA(FOR, "for"),
-    TOKEN_DATA(FRIEND, "friend"),
-    TOKEN_DATA(GOTO, "goto"),
-    TOKEN_DATA(IF, "if"),
-    TOKEN_DATA(INLINE, "inline"),
-    TOKEN_DATA(INT, "int"),
-    TOKEN_DATA(LONG, "long"),
-    TOKEN_DATA(MUTABLE, "mutable"),
-    TOKEN_DATA(NAMESPACE, "namespace"),
-    TOKEN_DATA(NEW, "new"),
-    TOKEN_DATA(OPERATOR, "operator"),
-    TOKEN_DATA(PRIVATE, "private"),
-    TOKEN_DATA(PROTECTED, "protected"),
-    TOKEN_DATA(PUBLIC, "public"),
-    TOKEN_DATA(REGISTER, "register"),
-    TOKEN_DATA(REINTERPRETCAST, "reinterpret_cast"),
-    TOKEN_DATA(RETURN, "return"),
-    TOKEN_DATA(SHORT, "short"),
-    TOKEN_DATA(SIGNED, "signed"),
-    TOKEN_DATA(SIZEOF, "sizeof"),
-    TOKEN_DATA(STATIC, "static"),
-    TOKEN_DATA(STATICCAST, "static_cast"),
-    TOKEN_DATA(STRUCT, "struct"),
-    TOKEN_DATA(SWITCH, "switch"),
-    TOKEN_DATA(TEMPLATE, "template"),
-    TOKEN_DATA(THIS, "this"),
-    TOKEN_DATA(THROW, "throw"),
-    TOKEN_DATA(TRY, "try"),
-    TOKEN_DATA(TYPEDEF, "typedef"),
-    TOKEN_DATA(TYPEID, "typeid"),
-    TOKEN_DATA(TYPENAME, "typename"),
-    TOKEN_DATA(UNION, "union"),
-    TOKEN_DATA(UNSIGNED, "unsigned"),
-    TOKEN_DATA(USING, "using"),
-    TOKEN_DATA(VIRTUAL, "virtual"),
-    TOKEN_DATA(VOID, "void"),
-    TOKEN_DATA(VOLATILE, "volatile"),
-    TOKEN_DATA(WCHART, "wchar_t"),
-    TOKEN_DATA(WHILE, "while"),
     TOKEN_DATA(PP_DEFINE, POUNDDEF PPSPACE "define"),
     TOKEN_DATA(PP_IF, POUNDDEF PPSPACE "if"),
     TOKEN_DATA(PP_IFDEF, POUNDDEF PPSPACE "ifdef"),
@@ -341,21 +292,6 @@ lexer<IteratorT, PositionT>::init_data[INIT_DATA_SIZE] =
     TOKEN_DATA(PP_UNDEF, POUNDDEF PPSPACE "undef"),
     TOKEN_DATA(PP_WARNING, POUNDDEF PPSPACE "warning"),
 #if BOOST_WAVE_SUPPORT_MS_EXTENSIONS != 0
-    TOKEN_DATA(MSEXT_INT8, "__int8"),
-    TOKEN_DATA(MSEXT_INT16, "__int16"),
-    TOKEN_DATA(MSEXT_INT32, "__int32"),
-    TOKEN_DATA(MSEXT_INT64, "__int64"),
-    TOKEN_DATA(MSEXT_BASED, "_?" "_based"),
-    TOKEN_DATA(MSEXT_DECLSPEC, "_?" "_declspec"),
-    TOKEN_DATA(MSEXT_CDECL, "_?" "_cdecl"),
-    TOKEN_DATA(MSEXT_FASTCALL, "_?" "_fastcall"),
-    TOKEN_DATA(MSEXT_STDCALL, "_?" "_stdcall"),
-    TOKEN_DATA(MSEXT_TRY , "__try"),
-    TOKEN_DATA(MSEXT_EXCEPT, "__except"),
-    TOKEN_DATA(MSEXT_FINALLY, "__finally"),
-    TOKEN_DATA(MSEXT_LEAVE, "__leave"),
-    TOKEN_DATA(MSEXT_INLINE, "_?" "_inline"),
-    TOKEN_DATA(MSEXT_ASM, "_?" "_asm"),
     TOKEN_DATA(MSEXT_PP_REGION, POUNDDEF PPSPACE "region"),
     TOKEN_DATA(MSEXT_PP_ENDREGION, POUNDDEF PPSPACE "endregion"),
 #endif // BOOST_WAVE_SUPPORT_MS_EXTENSIONS != 0
@@ -400,20 +336,6 @@ template <typename IteratorT, typename PositionT>
 typename lexer_base<IteratorT, PositionT>::lexer_data const
 lexer<IteratorT, PositionT>::init_data_cpp[INIT_DATA_CPP_SIZE] =
 {
-    TOKEN_DATA(AND_ALT, "bitand"),
-    TOKEN_DATA(ANDASSIGN_ALT, "and_eq"),
-    TOKEN_DATA(ANDAND_ALT, "and"),
-    TOKEN_DATA(OR_ALT, "bitor"),
-    TOKEN_DATA(ORASSIGN_ALT, "or_eq"),
-    TOKEN_DATA(OROR_ALT, "or"),
-    TOKEN_DATA(XORASSIGN_ALT, "xor_eq"),
-    TOKEN_DATA(XOR_ALT, "xor"),
-    TOKEN_DATA(NOTEQUAL_ALT, "not_eq"),
-    TOKEN_DATA(NOT_ALT, "not"),
-    TOKEN_DATA(COMPL_ALT, "compl"),
-#if BOOST_WAVE_SUPPORT_IMPORT_KEYWORD != 0
-    TOKEN_DATA(IMPORT, "import"),
-#endif
     TOKEN_DATA(ARROWSTAR, Q("->") Q("*")),
     TOKEN_DATA(DOTSTAR, Q(".") Q("*")),
     TOKEN_DATA(COLON_COLON, "::"),
@@ -449,16 +371,6 @@ lexer<IteratorT, PositionT>::init_data_cpp0x[INIT_DATA_CPP0X_SIZE] =
                 "(" ESCAPESEQ OR UNIVERSALCHAR OR "[^\\\\\"]" ")*" Q("\"")),
     TOKEN_DATA(EXTRAWSTRINGLIT, EXTCHAR_SPEC "R" Q("\"")
                 "(" ESCAPESEQ OR UNIVERSALCHAR OR "[^\\\\\"]" ")*" Q("\"")),
-    TOKEN_DATA(ALIGNAS, "alignas"),
-    TOKEN_DATA(ALIGNOF, "alignof"),
-    TOKEN_DATA(CHAR16_T, "char16_t"),
-    TOKEN_DATA(CHAR32_T, "char32_t"),
-    TOKEN_DATA(CONSTEXPR, "constexpr"),
-    TOKEN_DATA(DECLTYPE, "decltype"),
-    TOKEN_DATA(NOEXCEPT, "noexcept"),
-    TOKEN_DATA(NULLPTR, "nullptr"),
-    TOKEN_DATA(STATICASSERT, "static_assert"),
-    TOKEN_DATA(THREADLOCAL, "threadlocal"),
     { token_id(0) }       // this should be the last entry
 };
 
@@ -497,8 +409,9 @@ lexer<IteratorT, PositionT>::init_data_cpp0x[INIT_DATA_CPP0X_SIZE] =
 // initialize cpp lexer with token data
 template <typename IteratorT, typename PositionT>
 inline
-lexer_base<IteratorT, PositionT>::lexer_base()
-:   base_type(NUM_LEXER_STATES)
+lexer_base<IteratorT, PositionT>::lexer_base(
+        boost::spirit::classic::dfa_layout layout)
+:   base_type(NUM_LEXER_STATES, layout)
 {
 }
 
@@ -555,6 +468,25 @@ boost::wave::util::time_conversion_helper
 
 ///////////////////////////////////////////////////////////////////////////////
 //
+//  the language options which change the dfa, the others are handled by
+//  the functor once a token has been matched
+inline unsigned int
+dfa_language(boost::wave::language_support language)
+{
+    return (boost::wave::need_prefer_pp_numbers(language) ? 1u : 0u)
+        | (boost::wave::need_c99(language) ? 2u : 0u)
+        | (boost::wave::need_cpp0x(language) ? 4u : 0u);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The dfa is generated at build time by slex_dfa_generator for the language
+//  used by cpp2cxx, the tables are compiled into the cpp_slexer library.
+//  For any other language (and in the generator itself) the regular
+//  expressions are compiled at runtime. Nothing is read from or written to
+//  the working directory.
+//
+///////////////////////////////////////////////////////////////////////////////
 template <typename IteratorT, typename PositionT>
 inline void
 init_lexer (lexer::lexer<IteratorT, PositionT> &lexer,
@@ -563,34 +495,28 @@ init_lexer (lexer::lexer<IteratorT, PositionT> &lexer,
     if (lexer.has_compiled_dfa())
         return;     // nothing to do
 
-    using std::ifstream;
-    using std::ofstream;
-    using std::ios;
-    using std::cerr;
-    using std::endl;
-
-ifstream dfa_in("wave_slex_lexer.dfa", ios::in|ios::binary);
-
     lexer.init_dfa(language);
-    if (force_reinit || !dfa_in.is_open() ||
-        !lexer.load (dfa_in, (long)lexer.get_compilation_time()))
+
+#if defined(CPP2CXX_SLEX_STATIC_DFA)
+    if (!force_reinit && dfa_language(language) == static_dfa_language)
     {
+        if (lexer.get_dfa_layout() == boost::spirit::classic::dfa_layout::byte_classes)
+            lexer.use_static_dfa(static_class_dfa_tables, static_dfa_num_states);
+        else
+            lexer.use_static_dfa(static_dfa_tables, static_dfa_num_states);
+        return;
+    }
+#endif
+
 #if defined(BOOST_SPIRIT_DEBUG)
-        cerr << "Compiling regular expressions for slex ...";
+    std::cerr << "Compiling regular expressions for slex ...";
 #endif // defined(BOOST_SPIRIT_DEBUG)
 
-        dfa_in.close();
-        lexer.create_dfa();
-
-    ofstream dfa_out ("wave_slex_lexer.dfa", ios::out|ios::binary|ios::trunc);
-
-        if (dfa_out.is_open())
-            lexer.save (dfa_out, (long)lexer.get_compilation_time());
+    lexer.create_dfa();
 
 #if defined(BOOST_SPIRIT_DEBUG)
-        cerr << " Done." << endl;
+    std::cerr << " Done." << std::endl;
 #endif // defined(BOOST_SPIRIT_DEBUG)
-    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -599,7 +525,9 @@ ifstream dfa_in("wave_slex_lexer.dfa", ios::in|ios::binary);
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-template <typename IteratorT, typename PositionT = wave::util::file_position_type>
+//  The token positions are the offsets of the tokens into the line index
+//  of the input, which is built once the lexer is constructed.
+template <typename IteratorT, typename PositionT = slex_position>
 class slex_functor
 :   public slex_input_interface<
         typename lexer::lexer<IteratorT, PositionT>::token_type
@@ -607,17 +535,20 @@ class slex_functor
 {
 public:
 
-    using iterator_type = boost::wave::util::position_iterator<IteratorT, PositionT>;
+    using iterator_type = IteratorT;
     using char_type = typename std::iterator_traits<IteratorT>::value_type;
     using string_type = BOOST_WAVE_STRINGTYPE;
     using token_type = typename lexer::lexer<IteratorT, PositionT>::token_type;
 
     slex_functor(IteratorT const &first_, IteratorT const &last_,
-            PositionT const &pos_, boost::wave::language_support language_)
-    :   first(first_, last_, pos_), language(language_), at_eof(false)
+            PositionT const &pos_, boost::wave::language_support language_,
+            boost::spirit::classic::dfa_layout layout =
+                boost::spirit::classic::dfa_layout::full_rows)
+    :   first(first_), last(last_), origin(first_),
+        base(pos_.indexed(std::to_address(first_), std::to_address(last_))),
+        language(language_), lexer(shared_lexer(layout, language_)),
+        at_eof(false)
     {
-        // initialize lexer dfa tables
-        init_lexer(lexer, language_);
     }
     virtual ~slex_functor() {}
 
@@ -628,11 +559,14 @@ public:
             do {
             // generate and return the next token
             std::string value;
-            PositionT pos = first.get_position();   // begin of token position
+            PositionT pos = base.at_offset(base.get_offset() +     // begin of token position
+                std::uint32_t(std::distance(origin, first)));
             token_id id = token_id(lexer.next_token(first, last, &value));
 
                 if ((token_id)(-1) == id)
                     id = T_EOF;     // end of input reached
+                else if (T_IDENTIFIER == id)
+                    id = classify_identifier(value.data(), value.size(), language);
 
             string_type token_val(value);
 
@@ -645,7 +579,11 @@ public:
                     case T_IDENTIFIER:
                     // test identifier characters for validity (throws if
                     // invalid chars found)
-                        if (!boost::wave::need_no_character_validation(language)) {
+                    // only a universal character can be invalid, the position
+                    // is resolved for the error message only
+                        if (!boost::wave::need_no_character_validation(language) &&
+                            string_type::npos != token_val.find('\\'))
+                        {
                             using boost::wave::cpplexer::impl::validate_identifier_name;
                             validate_identifier_name(token_val,
                                 pos.get_line(), pos.get_column(), pos.get_file());
@@ -667,7 +605,9 @@ public:
                             using boost::wave::cpplexer::impl::convert_trigraphs;
                             token_val = convert_trigraphs(token_val);
                         }
-                        if (!boost::wave::need_no_character_validation(language)) {
+                        if (!boost::wave::need_no_character_validation(language) &&
+                            string_type::npos != token_val.find('\\'))
+                        {
                             using boost::wave::cpplexer::impl::validate_literal;
                             validate_literal(token_val,
                                 pos.get_line(), pos.get_column(), pos.get_file());
@@ -740,9 +680,13 @@ public:
 
     void set_position(PositionT const &pos)
     {
-        // set position has to change the file name and line number only
-        first.get_position().set_file(pos.get_file());
-        first.get_position().set_line(pos.get_line());
+        // set position has to change the file name and line number only,
+        // the rest of the input is indexed again from there
+        PositionT const current = base.at_offset(base.get_offset() +
+            std::uint32_t(std::distance(origin, first)));
+        base = current.reindexed(pos.get_file(), pos.get_line(),
+            std::to_address(first), std::to_address(last));
+        origin = first;
     }
 
 #if BOOST_WAVE_SUPPORT_PRAGMA_ONCE != 0
@@ -751,10 +695,37 @@ public:
 #endif
 
 private:
+//  the lexer of the layout, its dfa tables are initialized once; it is
+//  shared by all the functors, which may be created concurrently on
+//  several threads
+    static lexer::lexer<IteratorT, PositionT>& shared_lexer(
+        boost::spirit::classic::dfa_layout layout,
+        boost::wave::language_support language_)
+    {
+        using boost::spirit::classic::dfa_layout;
+        using lexer_type = lexer::lexer<IteratorT, PositionT>;
+
+        if (layout == dfa_layout::byte_classes) {
+            static lexer_type class_lexer(dfa_layout::byte_classes);
+            static std::once_flag class_lexer_initialized;
+            std::call_once(class_lexer_initialized,
+                [&]() { init_lexer(class_lexer, language_); });
+            return class_lexer;
+        }
+
+        static lexer_type full_lexer(dfa_layout::full_rows);
+        static std::once_flag full_lexer_initialized;
+        std::call_once(full_lexer_initialized,
+            [&]() { init_lexer(full_lexer, language_); });
+        return full_lexer;
+    }
+
     iterator_type first;
     iterator_type last;
+    iterator_type origin;   // the input at the offset of base
+    PositionT base;
     boost::wave::language_support language;
-    static lexer::lexer<IteratorT, PositionT> lexer;   // needed only once
+    lexer::lexer<IteratorT, PositionT>& lexer;   // one per dfa layout
 
     bool at_eof;
 
@@ -763,9 +734,6 @@ private:
 #endif
 };
 
-template <typename IteratorT, typename PositionT>
-lexer::lexer<IteratorT, PositionT> slex_functor<IteratorT, PositionT>::lexer;
-
 #undef T_EXTCHARLIT
 #undef T_EXTSTRINGLIT
 #undef T_EXTRAWSTRINGLIT
@@ -815,6 +783,18 @@ new_lexer_gen<IteratorT, PositionT>::new_lexer(IteratorT const &first,
         language);
 }
 
+template <typename IteratorT, typename PositionT>
+BOOST_WAVE_SLEX_NEW_LEXER_INLINE
+lex_input_interface<slex_token<PositionT> > *
+new_lexer_gen<IteratorT, PositionT>::new_lexer(IteratorT const &first,
+    IteratorT const &last, PositionT const &pos,
+    boost::wave::language_support language,
+    boost::spirit::classic::dfa_layout layout)
+{
+    return new slex_functor<IteratorT, PositionT>(first, last, pos,
+        language, layout);
+}
+
 #undef BOOST_WAVE_SLEX_NEW_LEXER_INLINE
 
 ///////////////////////////////////////////////////////////////////////////////
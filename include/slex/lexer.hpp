@@ -58,6 +58,9 @@
 #include <fstream>
 #include <boost/assert.hpp>
 #include <boost/limits.hpp>
+#include <limits>
+
+#include "slex_dfa_layout.hpp"
 
 #if defined(BOOST_NO_STD_ITERATOR_TRAITS)
 #define BOOST_SPIRIT_IT_NS impl
@@ -81,6 +84,71 @@ using state_match_t = std::vector<uchar_vector>;
 template <typename TokenT>
 class lexer_control;
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  lexer_static_dfa: the dfa of one lexer state stored in flat tables, as
+//  generated at build time (see lexer::use_static_dfa). The transition
+//  table has 256 entries for each dfa node.
+//
+///////////////////////////////////////////////////////////////////////////////
+struct lexer_static_dfa
+{
+    struct rows
+    {
+        node_id_t const* table;
+
+        node_id_t const* operator[](node_id_t s) const
+        {
+            return table + s * 256;
+        }
+    };
+
+    rows transition_table;
+    node_id_t const* acceptance_index;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  lexer_class_dfa: the dfa of one lexer state with the input bytes mapped
+//  to equivalence classes first, two bytes share a class when they lead to
+//  the same node from every node. A dfa node then has a dense row of 16 bit
+//  entries, one per class rounded up to a power of two so the row is found
+//  with a shift, instead of 256 node ids.
+//
+///////////////////////////////////////////////////////////////////////////////
+using class_cell_t = short;
+const class_cell_t invalid_cell = class_cell_t(-1);
+
+struct lexer_class_dfa
+{
+    struct row
+    {
+        class_cell_t const* cells;
+        uchar const* byte_class;
+
+        // invalid_cell sign extends to invalid_node
+        node_id_t operator[](uchar c) const
+        {
+            return node_id_t(int(cells[byte_class[c]]));
+        }
+    };
+
+    struct rows
+    {
+        class_cell_t const* table;
+        uchar const* byte_class;
+        unsigned int row_shift;
+
+        row operator[](node_id_t s) const
+        {
+            return { table + (std::size_t(s) << row_shift), byte_class };
+        }
+    };
+
+    rows transition_table;
+    node_id_t const* acceptance_index;
+};
+
 class bad_regex : public std::exception
 {
 };
@@ -2080,6 +2148,52 @@ void make_case_insensitive(state_match_t& state_match)
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//  computes the byte classes of a transition table and its dense rows of
+//  2^row_shift cells, false if the node ids don't fit in a class_cell_t
+inline bool
+compress_transition_table(
+    std::vector<std::vector<node_id_t> > const& transition_table,
+    std::vector<uchar>& byte_class, std::vector<class_cell_t>& cells,
+    unsigned int& row_shift)
+{
+    if (transition_table.size() > std::size_t(std::numeric_limits<class_cell_t>::max()))
+        return false;
+
+    // the column of each byte, bytes with equal columns share a class
+    std::map<std::vector<node_id_t>, uchar> classes;
+    std::vector<uchar> first_byte;
+    std::vector<node_id_t> column(transition_table.size());
+
+    byte_class.resize(256);
+    for (unsigned int c = 0; c < 256; ++c)
+    {
+        for (std::size_t s = 0; s < transition_table.size(); ++s)
+            column[s] = transition_table[s][c];
+
+        auto inserted = classes.emplace(column, uchar(classes.size()));
+        if (inserted.second)
+            first_byte.push_back(uchar(c));
+        byte_class[c] = inserted.first->second;
+    }
+
+    row_shift = 0;
+    while ((std::size_t(1) << row_shift) < first_byte.size())
+        ++row_shift;
+
+    cells.assign(transition_table.size() << row_shift, invalid_cell);
+    for (std::size_t s = 0; s < transition_table.size(); ++s)
+    {
+        for (std::size_t k = 0; k < first_byte.size(); ++k)
+        {
+            node_id_t const target = transition_table[s][first_byte[k]];
+            if (target != invalid_node)
+                cells[(s << row_shift) + k] = class_cell_t(target);
+        }
+    }
+    return true;
+}
+
 template<bool wide_char>
 struct regex_match_helper;
 
@@ -2103,6 +2217,7 @@ struct regex_match_helper<false> // single byte char
         node_id_t last_accepting_index = invalid_node;
         IteratorT p = first;
         IteratorT last_accepting_cpos = first;
+        size_type last_accepting_size = token ? token->size() : 0;
         while (p != last)
         {
             s = dfa.transition_table[s][(uchar)*p];
@@ -2114,6 +2229,7 @@ struct regex_match_helper<false> // single byte char
             {
                 last_accepting_index = s;
                 last_accepting_cpos = p;
+                if (token) last_accepting_size = token->size();
             }
         }
         if (last_accepting_index != invalid_node)
@@ -2123,6 +2239,9 @@ struct regex_match_helper<false> // single byte char
                 dfa.acceptance_index[last_accepting_index] << '\n';
 #endif
 
+            // the characters read past the longest match (e.g. the x of 0x
+            // or an unterminated comment) are not part of the token
+            if (token) token->resize(last_accepting_size);
             first = last_accepting_cpos;
             regex_index = dfa.acceptance_index[last_accepting_index];
             return true;
@@ -2152,6 +2271,7 @@ struct regex_match_helper<true> // wide char
         node_id_t last_accepting_index = invalid_node;
         IteratorT wp = first;
         IteratorT last_accepting_cpos = first;
+        size_type last_accepting_size = token ? token->size() : 0;
 
         while (wp != last)
         {
@@ -2169,6 +2289,7 @@ struct regex_match_helper<true> // wide char
             {
                 last_accepting_index = s;
                 last_accepting_cpos = wp;
+                if (token) last_accepting_size = token->size();
             }
 
         }
@@ -2180,6 +2301,7 @@ struct regex_match_helper<true> // wide char
             std::cout << "dfa.acceptance_index[" << last_accepting_index << "] = " <<
                 dfa.acceptance_index[last_accepting_index] << '\n';
 #endif
+            if (token) token->resize(last_accepting_size);
             first = last_accepting_cpos;
             regex_index = dfa.acceptance_index[last_accepting_index];
 
@@ -2247,7 +2369,8 @@ public:
     using dfa_t = std::vector<dfa_table>;
 
 
-    lexer(unsigned int states = 1);
+    lexer(unsigned int states = 1,
+        dfa_layout layout = dfa_layout::full_rows);
 
     void register_regex(const std::basic_string<char_t>& regex,
             const TokenT& id, const CallbackT& cb = CallbackT(),
@@ -2258,6 +2381,14 @@ public:
 
     void create_dfa();
     bool has_compiled_dfa() { return m_compiled_dfa; }
+
+    // use the dfa tables generated at build time instead of compiling the
+    // regular expressions. The regular expressions still have to be
+    // registered, they give the token ids and callbacks of the matches.
+    void use_static_dfa(lexer_static_dfa const* tables, unsigned int num_states);
+    void use_static_dfa(lexer_class_dfa const* tables, unsigned int num_states);
+    dfa_t const& get_dfa() const { return m_dfa; }
+    dfa_layout get_dfa_layout() const { return m_layout; }
     
     void set_case_insensitive(bool insensitive);
 
@@ -2278,6 +2409,7 @@ public:
 private:
 
     void create_dfa_for_state(int state);
+    void create_class_dfa();
 
     static bool regex_match(const dfa_t& dfa, IteratorT& first,
         IteratorT& last, int& regex_index);
@@ -2287,6 +2419,19 @@ private:
 
     mutable bool m_compiled_dfa;
     mutable dfa_t m_dfa;
+    lexer_static_dfa const* m_static_dfa;
+
+    // the byte class tables in use, either generated ones or the ones
+    // compressed from m_dfa into m_class_storage
+    struct class_dfa_storage
+    {
+        std::vector<uchar> byte_class;
+        std::vector<class_cell_t> cells;
+    };
+    dfa_layout m_layout;
+    lexer_class_dfa const* m_class_dfa;
+    std::vector<class_dfa_storage> m_class_storage;
+    std::vector<lexer_class_dfa> m_class_tables;
 
     regex_list_t m_regex_list;
     bool m_case_insensitive;
@@ -2299,9 +2444,13 @@ private:
 
 template <typename IteratorT, typename TokenT, typename CallbackT>
 inline
-lexer<IteratorT, TokenT, CallbackT>::lexer(unsigned int states)
+lexer<IteratorT, TokenT, CallbackT>::lexer(unsigned int states,
+        dfa_layout layout)
     : g(node_stack)
     , m_compiled_dfa(false)
+    , m_static_dfa(0)
+    , m_layout(layout)
+    , m_class_dfa(0)
     , m_regex_list(states)
     , m_case_insensitive(false)
     , m_state(0)
@@ -2333,15 +2482,32 @@ lexer<IteratorT, TokenT, CallbackT>::next_token(
         typename BOOST_SPIRIT_IT_NS::iterator_traits<IteratorT>::value_type
     > *token)
 {
+    IteratorT saved = first;
+    int regex_index;
+    bool matched;
+
     if (!m_compiled_dfa)
     {
         create_dfa();
     }
 
-    IteratorT saved = first;
-    int regex_index;
-    if (!lexerimpl::regex_match<dfa_table, IteratorT, (sizeof(char_t) > 1)>::
-            do_match(m_dfa[m_state], first, last, regex_index, token))
+    if (m_class_dfa)
+    {
+        matched = lexerimpl::regex_match<lexer_class_dfa, IteratorT, (sizeof(char_t) > 1)>::
+            do_match(m_class_dfa[m_state], first, last, regex_index, token);
+    }
+    else if (m_static_dfa)
+    {
+        matched = lexerimpl::regex_match<lexer_static_dfa, IteratorT, (sizeof(char_t) > 1)>::
+            do_match(m_static_dfa[m_state], first, last, regex_index, token);
+    }
+    else
+    {
+        matched = lexerimpl::regex_match<dfa_table, IteratorT, (sizeof(char_t) > 1)>::
+            do_match(m_dfa[m_state], first, last, regex_index, token);
+    }
+
+    if (!matched)
         return -1;  // TODO: can't return -1, need to return some invalid token.
     // how to figure this out?  We can use traits I guess.
     else
@@ -2413,6 +2579,28 @@ parse_regexes(const RegexListT& regex_list, GrammarT& g)
 
 } //namespace lexerimpl
 
+template <typename IteratorT, typename TokenT, typename CallbackT>
+inline void
+lexer<IteratorT, TokenT, CallbackT>::use_static_dfa(
+        lexer_static_dfa const* tables, unsigned int num_states)
+{
+    BOOST_ASSERT(num_states == m_num_states);
+    m_static_dfa = tables;
+    m_class_dfa = 0;
+    m_compiled_dfa = true;
+}
+
+template <typename IteratorT, typename TokenT, typename CallbackT>
+inline void
+lexer<IteratorT, TokenT, CallbackT>::use_static_dfa(
+        lexer_class_dfa const* tables, unsigned int num_states)
+{
+    BOOST_ASSERT(num_states == m_num_states);
+    m_static_dfa = 0;
+    m_class_dfa = tables;
+    m_compiled_dfa = true;
+}
+
 template <typename IteratorT, typename TokenT, typename CallbackT>
 inline void
 lexer<IteratorT, TokenT, CallbackT>::create_dfa()
@@ -2420,6 +2608,37 @@ lexer<IteratorT, TokenT, CallbackT>::create_dfa()
     m_dfa.resize(m_num_states);
     for (unsigned int i = 0; i < m_num_states; ++i)
         create_dfa_for_state(i);
+
+    if (m_layout == dfa_layout::byte_classes)
+        create_class_dfa();
+}
+
+// compresses the compiled (or loaded) dfa, if a node id does not fit in
+// the 16 bit cells the full rows are used
+template <typename IteratorT, typename TokenT, typename CallbackT>
+inline void
+lexer<IteratorT, TokenT, CallbackT>::create_class_dfa()
+{
+    m_class_dfa = 0;
+    m_class_storage.assign(m_dfa.size(), class_dfa_storage());
+    m_class_tables.assign(m_dfa.size(), lexer_class_dfa());
+
+    for (std::size_t i = 0; i < m_dfa.size(); ++i)
+    {
+        unsigned int row_shift = 0;
+        if (!lexerimpl::compress_transition_table(m_dfa[i].transition_table,
+                m_class_storage[i].byte_class, m_class_storage[i].cells,
+                row_shift))
+        {
+            return;
+        }
+        m_class_tables[i].transition_table.table = m_class_storage[i].cells.data();
+        m_class_tables[i].transition_table.byte_class =
+            m_class_storage[i].byte_class.data();
+        m_class_tables[i].transition_table.row_shift = row_shift;
+        m_class_tables[i].acceptance_index = m_dfa[i].acceptance_index.data();
+    }
+    m_class_dfa = m_class_tables.data();
 }
 
 // Algorithm from Compilers: Principles, Techniques, and Tools p. 141
@@ -2659,6 +2878,8 @@ std::size_t dfa_size = 0;
     m_dfa.swap(in_dfa);         // success, swap in the read values
     m_num_states = num_states;
 
+    if (m_layout == dfa_layout::byte_classes)
+        create_class_dfa();
     m_compiled_dfa = true;
     return true;
 }
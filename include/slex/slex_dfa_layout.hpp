@@ -0,0 +1,30 @@
+/*=============================================================================
+    cpp2cxx: layout of the dfa tables of the slex lexer
+    Kept apart from lexer.hpp, so the lexer backends can choose the layout
+    without including the whole lexer.
+=============================================================================*/
+
+#if !defined(SLEX_DFA_LAYOUT_HPP_INCLUDED)
+#define SLEX_DFA_LAYOUT_HPP_INCLUDED
+
+///////////////////////////////////////////////////////////////////////////////
+namespace boost {
+namespace spirit {
+namespace classic {
+
+///////////////////////////////////////////////////////////////////////////////
+//  the layout of the transition tables, chosen when the lexer is constructed.
+//  The byte classes take a quarter of the memory but cost a lookup per byte,
+//  they pay off when the full rows don't stay in the cache.
+enum class dfa_layout
+{
+    full_rows,      // 256 node ids for each dfa node
+    byte_classes    // see lexer_class_dfa
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}   // namespace classic
+}   // namespace spirit
+}   // namespace boost
+
+#endif // !defined(SLEX_DFA_LAYOUT_HPP_INCLUDED)
@@ -0,0 +1,31 @@
+/*=============================================================================
+    cpp2cxx: dfa tables of the slex C++ lexer
+    The definitions are generated at build time by slex_dfa_generator into
+    slex_dfa_tables.cpp, which is compiled into the cpp_slexer library.
+=============================================================================*/
+
+#if !defined(SLEX_DFA_TABLES_HPP_INCLUDED)
+#define SLEX_DFA_TABLES_HPP_INCLUDED
+
+#include "lexer.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace boost {
+namespace wave {
+namespace cpplexer {
+namespace slex {
+
+// one table for each lexer state, with full rows and with byte classes
+extern const boost::spirit::classic::lexer_static_dfa static_dfa_tables[];
+extern const boost::spirit::classic::lexer_class_dfa static_class_dfa_tables[];
+extern const unsigned int static_dfa_num_states;
+// dfa_language() of the language the tables were generated for
+extern const unsigned int static_dfa_language;
+
+///////////////////////////////////////////////////////////////////////////////
+}   // namespace slex
+}   // namespace cpplexer
+}   // namespace wave
+}   // namespace boost
+
+#endif // !defined(SLEX_DFA_TABLES_HPP_INCLUDED)
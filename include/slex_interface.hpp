@@ -18,6 +18,7 @@
 #include <boost/wave/cpplexer/cpp_lex_interface.hpp>
 
 #include "slex_token.hpp"
+#include "slex/slex_dfa_layout.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace boost {
@@ -38,7 +39,7 @@ namespace slex {
 ///////////////////////////////////////////////////////////////////////////////
 template <
     typename IteratorT, 
-    typename PositionT = boost::wave::util::file_position_type
+    typename PositionT = slex_position
 >
 struct new_lexer_gen
 {
@@ -48,6 +49,12 @@ struct new_lexer_gen
     static lex_input_interface<slex_token<PositionT> > *
     new_lexer(IteratorT const &first, IteratorT const &last, 
         PositionT const &pos, boost::wave::language_support language);
+
+//  The same lexer running on the dfa tables of the given layout.
+    static lex_input_interface<slex_token<PositionT> > *
+    new_lexer(IteratorT const &first, IteratorT const &last,
+        PositionT const &pos, boost::wave::language_support language,
+        boost::spirit::classic::dfa_layout layout);
 };
 
 #undef BOOST_WAVE_NEW_LEXER_DECL
@@ -186,25 +186,33 @@ public:
         )
     {}
 
+//  takes the ownership of an already constructed lexer, e.g. one which
+//  lexes only some spans of the input
+    explicit slex_iterator(lex_input_interface<TokenT>* lexer)
+    :   base_type(functor_data_type(unique_functor_type(), lexer))
+    {}
+
     void set_position(typename TokenT::position_type const &pos)
     {
         using position_type = typename token_type::position_type;
 
-    // set the new position in the current token
+    // set the new position in the current token, the positions are immutable
     token_type const& currtoken = this->base_type::dereference(*this);
-    position_type currpos = currtoken.get_position();
+    std::size_t const column = currtoken.get_position().get_column();
 
-        currpos.set_file(pos.get_file());
-        currpos.set_line(pos.get_line());
-        const_cast<token_type&>(currtoken).set_position(currpos);
+        const_cast<token_type&>(currtoken).set_position(
+            position_type(pos.get_file(), pos.get_line(), column));
 
     // set the new position for future tokens as well
+    std::size_t line = pos.get_line();
+
         if (token_type::string_type::npos != 
             currtoken.get_value().find_first_of('\n'))
         {
-            currpos.set_line(pos.get_line() + 1);
+            ++line;
         }
-        unique_functor_type::set_position(*this, currpos);
+        unique_functor_type::set_position(*this,
+            position_type(pos.get_file(), line, column));
     }
 
 #if BOOST_WAVE_SUPPORT_PRAGMA_ONCE != 0
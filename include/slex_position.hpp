@@ -0,0 +1,541 @@
+/*=============================================================================
+    Boost.Wave: A Standard compliant C++ preprocessor library
+
+    A compact file position for the slex tokens, resolved to a line and
+    column on demand
+
+    http://www.boost.org/
+
+    Copyright (c) 2001-2012 Hartmut Kaiser. Distributed under the Boost
+    Software License, Version 1.0. (See accompanying file
+    LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#if !defined(SLEX_POSITION_HPP_5C1E07A2_3D4B_4F3A_9E61_2B7D0C84A9F3_INCLUDED)
+#define SLEX_POSITION_HPP_5C1E07A2_3D4B_4F3A_9E61_2B7D0C84A9F3_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/wave/wave_config.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SLEX_POSITION_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SLEX_POSITION_SCAN_SSE2 1
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+namespace boost {
+namespace wave {
+namespace cpplexer {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  segmented_table
+//
+//      Keeps its elements in segments of growing size which never move, so
+//      an element is looked up without locking; appending has to be
+//      serialized by the owner.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+class segmented_table
+{
+public:
+    std::uint32_t push_back(T value)
+    {
+        std::uint32_t const id = count++;
+        auto const [segment, index] = locate(id);
+        if (!segments[segment])
+            segments[segment] = std::make_unique<T[]>(std::size_t(1) << segment);
+        segments[segment][index] = std::move(value);
+        return id;
+    }
+
+    T const& operator[](std::uint32_t id) const
+    {
+        auto const [segment, index] = locate(id);
+        return segments[segment][index];
+    }
+
+    T& operator[](std::uint32_t id)
+    {
+        auto const [segment, index] = locate(id);
+        return segments[segment][index];
+    }
+
+private:
+    // segment s holds the 2^s elements from index 2^s - 1 on
+    static std::pair<std::size_t, std::size_t> locate(std::uint32_t id)
+    {
+        std::uint64_t const n = std::uint64_t(id) + 1;
+        std::size_t const segment = std::bit_width(n) - 1;
+        return { segment, std::size_t(n - (std::uint64_t(1) << segment)) };
+    }
+
+    std::array<std::unique_ptr<T[]>, 32> segments;
+    std::uint32_t count = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  file_name_table
+//
+//      Interns the file names of the token positions, every token of a file
+//      refers to the same name through its index. Only interning a new name
+//      takes the lock.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class file_name_table
+{
+public:
+    using string_type = BOOST_WAVE_STRINGTYPE;
+
+    static file_name_table& instance()
+    {
+        static file_name_table table;
+        return table;
+    }
+
+    std::uint32_t intern(string_type const& name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (auto it = ids.find(name); it != ids.end())
+            return it->second;
+
+        std::uint32_t const id = names.push_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
+
+    string_type const& get(std::uint32_t id) const
+    {
+        return names[id];
+    }
+
+private:
+    file_name_table()
+    {
+        // index 0 is the empty name of the default constructed positions
+        intern(string_type());
+    }
+
+    std::mutex mutex;
+    std::unordered_map<string_type, std::uint32_t> ids;
+    segmented_table<string_type> names;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  source_lines
+//
+//      The line index of a lexed buffer: the offsets where its lines start,
+//      of its tabs and of the '\r' of its "\r\n" line ends. An offset into
+//      the buffer is resolved to the line and column the position_iterator
+//      would have counted, the buffer itself is not kept.
+//
+//      A source without a buffer (an anchor) resolves every offset to its
+//      own line.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class source_lines
+{
+public:
+    static constexpr std::size_t tab_width = 4;
+
+    source_lines()
+    :   file_id(0), line(1), column(1), size(0), indexed(false)
+    {}
+
+    source_lines(std::uint32_t file_id_, std::size_t line_, std::size_t column_)
+    :   file_id(file_id_), line(std::uint32_t(line_)), column(std::uint32_t(column_)),
+        size(0), indexed(false)
+    {}
+
+    source_lines(std::uint32_t file_id_, std::size_t line_, std::size_t column_,
+            char const* first, char const* last)
+    :   file_id(file_id_), line(std::uint32_t(line_)), column(std::uint32_t(column_)),
+        size(std::uint32_t(last - first)), indexed(true)
+    {
+        for_each_special(first, size, [&](std::uint32_t i) {
+            switch (first[i]) {
+            case '\n':
+                line_starts.push_back(i + 1);
+                break;
+            case '\r':
+                if (i + 1 != size && first[i + 1] == '\n')
+                    carriage_returns.push_back(i);
+                else
+                    line_starts.push_back(i + 1);
+                break;
+            default:
+                tabs.push_back(i);
+                break;
+            }
+        });
+    }
+
+    std::uint32_t get_file_id() const { return file_id; }
+    bool is_indexed() const { return indexed; }
+
+//  the same source without its line index, every offset resolves to the
+//  line of offset 0
+    source_lines anchor() const
+    {
+        return source_lines(file_id, line, column);
+    }
+
+// the line and the column of the offset
+    std::pair<std::size_t, std::size_t> resolve(std::uint32_t offset) const
+    {
+        std::size_t const index = std::size_t(
+            std::upper_bound(line_starts.begin(), line_starts.end(), offset)
+            - line_starts.begin());
+        std::uint32_t const start = index == 0 ? 0 : line_starts[index - 1];
+
+    // a tab moves to the next tab stop, the '\r' of a "\r\n" takes no column
+        std::size_t col = index == 0 ? column : 1;
+        std::uint32_t prev = start;
+        for (auto tab = std::lower_bound(tabs.begin(), tabs.end(), start);
+             tab != tabs.end() && *tab < offset; ++tab)
+        {
+            col += *tab - prev;
+            col += tab_width - (col - 1) % tab_width;
+            prev = *tab + 1;
+        }
+        col += offset - prev;
+        if (offset != start && std::binary_search(carriage_returns.begin(),
+                carriage_returns.end(), offset - 1))
+        {
+            --col;
+        }
+        return { line + index, col };
+    }
+
+// the offset of a line and a column counted in bytes (a tab is a single
+// column), for the lexers which count lines and columns themselves
+    std::uint32_t offset_of(std::size_t line_, std::size_t byte_column) const
+    {
+        std::size_t const index = line_ < line ? 0 :
+            (std::min)(line_ - line, line_starts.size());
+        std::uint32_t const first = index == 0 ? 0 : line_starts[index - 1];
+        std::uint32_t const last = index == line_starts.size() ? size : line_starts[index];
+        std::size_t const first_column = index == 0 ? column : 1;
+
+        if (byte_column <= first_column)
+            return first;
+        return std::uint32_t((std::min)(std::size_t(first) + byte_column - first_column,
+            std::size_t(last)));
+    }
+
+private:
+//  calls f with the offset of every '\n', '\r' and '\t', 32 or 16 bytes are
+//  compared at a time when AVX2 or SSE2 is available
+    template <typename F>
+    static void for_each_special(char const* first, std::uint32_t size, F f)
+    {
+        std::uint32_t i = 0;
+#if defined(SLEX_POSITION_SCAN_AVX2)
+        __m256i const nl = _mm256_set1_epi8('\n');
+        __m256i const cr = _mm256_set1_epi8('\r');
+        __m256i const tab = _mm256_set1_epi8('\t');
+        for (; size - i >= 32; i += 32) {
+            __m256i const block =
+                _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first + i));
+            unsigned mask = unsigned(_mm256_movemask_epi8(_mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, nl), _mm256_cmpeq_epi8(block, cr)),
+                _mm256_cmpeq_epi8(block, tab))));
+            for (; mask != 0; mask &= mask - 1)
+                f(i + std::uint32_t(std::countr_zero(mask)));
+        }
+#elif defined(SLEX_POSITION_SCAN_SSE2)
+        __m128i const nl = _mm_set1_epi8('\n');
+        __m128i const cr = _mm_set1_epi8('\r');
+        __m128i const tab = _mm_set1_epi8('\t');
+        for (; size - i >= 16; i += 16) {
+            __m128i const block =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(first + i));
+            unsigned mask = unsigned(_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, nl), _mm_cmpeq_epi8(block, cr)),
+                _mm_cmpeq_epi8(block, tab))));
+            for (; mask != 0; mask &= mask - 1)
+                f(i + std::uint32_t(std::countr_zero(mask)));
+        }
+#endif
+        for (; i != size; ++i) {
+            if (first[i] == '\n' || first[i] == '\r' || first[i] == '\t')
+                f(i);
+        }
+    }
+
+    std::uint32_t file_id;
+    std::uint32_t line;         // line and column of offset 0
+    std::uint32_t column;
+    std::uint32_t size;
+    bool indexed;
+    std::vector<std::uint32_t> line_starts;     // of the lines after the first
+    std::vector<std::uint32_t> tabs;
+    std::vector<std::uint32_t> carriage_returns;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  source_table
+//
+//      The line indices of all the lexed buffers and the anchors of the
+//      positions constructed from a line and column. The index of a buffer
+//      owned by a source_index (and the indices derived from it by a #line)
+//      is dropped when the source_index is released, the source is kept as
+//      an anchor so the positions of the file which are still around stay
+//      valid, they only resolve to its first line.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class source_table
+{
+public:
+    static source_table& instance()
+    {
+        static source_table table;
+        return table;
+    }
+
+    std::uint32_t add(source_lines lines)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sources.push_back(std::move(lines));
+    }
+
+//  a source which is released along with the source owner, or along with
+//  itself when owner is 0; a source added by add() is never released
+    std::uint32_t add_owned(source_lines lines, std::uint32_t owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::uint32_t const id = sources.push_back(std::move(lines));
+        if (owner == 0) {
+            owned[id].push_back(id);
+            owners.emplace(id, id);
+        }
+        else if (auto it = owners.find(owner); it != owners.end()) {
+            owned[it->second].push_back(id);
+            owners.emplace(id, it->second);
+        }
+        return id;
+    }
+
+//  drops the line indices of the sources owned by owner, none of their
+//  positions may be resolved concurrently
+    void release(std::uint32_t owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = owned.find(owner);
+        if (it == owned.end())
+            return;
+
+        for (std::uint32_t id : it->second) {
+            sources[id] = sources[id].anchor();
+            owners.erase(id);
+        }
+        owned.erase(it);
+    }
+
+    source_lines const& get(std::uint32_t id) const
+    {
+        return sources[id];
+    }
+
+private:
+    source_table()
+    {
+        // index 0 is the source of the default constructed positions
+        sources.push_back(source_lines());
+    }
+
+    std::mutex mutex;
+    segmented_table<source_lines> sources;
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> owned;
+    std::unordered_map<std::uint32_t, std::uint32_t> owners;
+};
+
+class source_index;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  slex_position
+//
+//      The same accessors as boost::wave::util::file_position, but a position
+//      is only a source and a byte offset into it (8 bytes, nothing is
+//      allocated). The lexers do no line and column bookkeeping, the line
+//      and the column are looked up in the line index of the source when
+//      they are asked for.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class slex_position
+{
+public:
+    using string_type = BOOST_WAVE_STRINGTYPE;
+
+    slex_position()
+    :   source(0), offset(0)
+    {}
+    explicit slex_position(string_type const& file_, std::size_t line_ = 1,
+            std::size_t column_ = 1)
+    :   source(source_table::instance().add(source_lines(
+            file_name_table::instance().intern(file_), line_, column_))),
+        offset(0)
+    {}
+
+//  the position of first, when [first, last) is lexed from this position;
+//  a position which is already in an indexed source has to point to first
+//  in the indexed buffer, it is returned as it is. A buffer which is lexed
+//  more than once is indexed by a source_index, an index made here is
+//  never released.
+    slex_position indexed(char const* first, char const* last) const
+    {
+        if (lines().is_indexed())
+            return *this;
+
+        return slex_position(source_table::instance().add(source_lines(
+            get_file_id(), get_line(), get_column(), first, last)), 0);
+    }
+
+//  the position of first after a #line directive: the rest [first, last)
+//  of the buffer is indexed again from the line of the directive, the new
+//  index is released along with the one of this position
+    slex_position reindexed(string_type const& file_, std::size_t line_,
+        char const* first, char const* last) const
+    {
+        return slex_position(source_table::instance().add_owned(source_lines(
+            file_name_table::instance().intern(file_), line_, get_column(),
+            first, last), source), 0);
+    }
+
+//  the position at another offset into the same source
+    slex_position at_offset(std::uint32_t offset_) const
+    {
+        return slex_position(source, offset_);
+    }
+
+// accessors
+    string_type const &get_file() const
+        { return file_name_table::instance().get(get_file_id()); }
+    std::uint32_t get_file_id() const { return lines().get_file_id(); }
+    std::uint32_t get_source() const { return source; }
+    std::uint32_t get_offset() const { return offset; }
+    std::size_t get_line() const { return lines().resolve(offset).first; }
+    std::size_t get_column() const { return lines().resolve(offset).second; }
+
+//  the position of a line and a byte column in the same source
+    slex_position at_line_column(std::size_t line_, std::size_t byte_column) const
+    {
+        return slex_position(source, lines().offset_of(line_, byte_column));
+    }
+
+private:
+    friend class source_index;
+
+    slex_position(std::uint32_t source_, std::uint32_t offset_)
+    :   source(source_), offset(offset_)
+    {}
+
+    source_lines const& lines() const
+        { return source_table::instance().get(source); }
+
+    std::uint32_t source;
+    std::uint32_t offset;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  source_index
+//
+//      Owns the line index of a buffer, the lexers of the buffer start from
+//      its position instead of indexing the buffer again. The index is
+//      released with the source_index, so a long run only keeps the indices
+//      of the files it is working on.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class source_index
+{
+public:
+    using string_type = BOOST_WAVE_STRINGTYPE;
+
+    source_index()
+    :   source(0)
+    {}
+    source_index(string_type const& file_, char const* first, char const* last)
+    :   source(source_table::instance().add_owned(source_lines(
+            file_name_table::instance().intern(file_), 1, 1, first, last), 0))
+    {}
+    ~source_index() { release(); }
+
+    source_index(source_index const&) = delete;
+    source_index& operator=(source_index const&) = delete;
+
+    source_index(source_index&& rhs) noexcept
+    :   source(std::exchange(rhs.source, 0))
+    {}
+    source_index& operator=(source_index&& rhs) noexcept
+    {
+        if (this != &rhs) {
+            release();
+            source = std::exchange(rhs.source, 0);
+        }
+        return *this;
+    }
+
+//  the position of the first byte of the buffer
+    slex_position position() const { return slex_position(source, 0); }
+
+    void release()
+    {
+        if (source != 0)
+            source_table::instance().release(std::exchange(source, 0));
+    }
+
+private:
+    std::uint32_t source;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+inline bool operator== (slex_position const &lhs, slex_position const &rhs)
+{
+    if (lhs.get_source() == rhs.get_source())
+        return lhs.get_offset() == rhs.get_offset();
+
+    return lhs.get_column() == rhs.get_column() &&
+        lhs.get_line() == rhs.get_line() &&
+        lhs.get_file_id() == rhs.get_file_id();
+}
+
+inline std::ostream &
+operator<< (std::ostream &o, slex_position const &pos)
+{
+    o << pos.get_file() << ":" << pos.get_line() << ":"  << pos.get_column();
+    return o;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}   // namespace cpplexer
+}   // namespace wave
+}   // namespace boost
+
+#endif // !defined(SLEX_POSITION_HPP_5C1E07A2_3D4B_4F3A_9E61_2B7D0C84A9F3_INCLUDED)
@@ -0,0 +1,117 @@
+/*=============================================================================
+    Boost.Wave: A Standard compliant C++ preprocessor library
+
+    The interned identifiers of the slex tokens
+
+    http://www.boost.org/
+
+    Copyright (c) 2001-2012 Hartmut Kaiser. Distributed under the Boost
+    Software License, Version 1.0. (See accompanying file
+    LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#if !defined(SLEX_SYMBOL_TABLE_HPP_8E2F4C61_0B7A_4D93_A1C5_6F3E9D2B7A40_INCLUDED)
+#define SLEX_SYMBOL_TABLE_HPP_8E2F4C61_0B7A_4D93_A1C5_6F3E9D2B7A40_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <boost/wave/wave_config.hpp>
+
+#include "slex_position.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace boost {
+namespace wave {
+namespace cpplexer {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  symbol_table
+//
+//      Interns the identifiers (and keywords) of all the lexed files, the
+//      same spelling gets the same symbol in every file and on every
+//      thread, so the macro lookups compare and hash integers instead of
+//      strings. Symbol 0 is the empty spelling, which the tokens that can't
+//      name a macro carry.
+//
+//      The ids are split over shards by the hash of the spelling; looking
+//      up a known identifier takes the shared lock of its shard only,
+//      which lets the parallel lexers intern without waiting on each other.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class symbol_table
+{
+public:
+    using string_type = BOOST_WAVE_STRINGTYPE;
+
+    static constexpr std::uint32_t no_symbol = 0;
+
+    static symbol_table& instance()
+    {
+        static symbol_table table;
+        return table;
+    }
+
+    std::uint32_t intern(string_type const& name)
+    {
+        if (name.empty())
+            return no_symbol;
+
+        shard& s = shards[std::hash<string_type>()(name) % shard_count];
+        {
+            std::shared_lock<std::shared_mutex> lock(s.mutex);
+            if (auto it = s.ids.find(name); it != s.ids.end())
+                return it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        if (auto it = s.ids.find(name); it != s.ids.end())
+            return it->second;
+
+        std::uint32_t id;
+        {
+            std::lock_guard<std::mutex> names_lock(names_mutex);
+            id = names.push_back(name);
+        }
+        s.ids.emplace(name, id);
+        return id;
+    }
+
+    string_type const& get(std::uint32_t id) const
+    {
+        return names[id];
+    }
+
+private:
+    static constexpr std::size_t shard_count = 64;
+
+    struct shard
+    {
+        std::shared_mutex mutex;
+        std::unordered_map<string_type, std::uint32_t> ids;
+    };
+
+    symbol_table()
+    {
+        // index 0 is the empty spelling, it is never looked up in a shard
+        names.push_back(string_type());
+    }
+
+    std::array<shard, shard_count> shards;
+    std::mutex names_mutex;
+    segmented_table<string_type> names;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}   // namespace cpplexer
+}   // namespace wave
+}   // namespace boost
+
+#endif // !defined(SLEX_SYMBOL_TABLE_HPP_8E2F4C61_0B7A_4D93_A1C5_6F3E9D2B7A40_INCLUDED)
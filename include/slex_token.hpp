@@ -13,6 +13,7 @@
 #if !defined(SLEX_TOKEN_HPP_53A13BD2_FBAA_444B_9B8B_FCB225C2BBA8_INCLUDED)
 #define SLEX_TOKEN_HPP_53A13BD2_FBAA_444B_9B8B_FCB225C2BBA8_INCLUDED
 
+#include <cstdint>
 #include <iomanip>
 #include <ios>
 
@@ -21,6 +22,9 @@
 #include <boost/wave/language_support.hpp>
 #include <boost/wave/util/file_position.hpp>
 
+#include "slex_position.hpp"
+#include "slex_symbol_table.hpp"
+
 ///////////////////////////////////////////////////////////////////////////////
 namespace boost {
 namespace wave {
@@ -28,7 +32,7 @@ namespace cpplexer {
 
 ///////////////////////////////////////////////////////////////////////////////
 //  forward declaration of the token type
-template <typename PositionT = boost::wave::util::file_position_type>
+template <typename PositionT = slex_position>
 class slex_token;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -45,16 +49,16 @@ public:
     using position_type = PositionT;
 
     slex_token()
-    :   id(T_EOI)
+    :   id(T_EOI), symbol(symbol_table::no_symbol)
     {}
 
     //  construct an invalid token
     explicit slex_token(int)
-    :   id(T_UNKNOWN)
+    :   id(T_UNKNOWN), symbol(symbol_table::no_symbol)
     {}
 
     slex_token(token_id id_, string_type const &value_, PositionT const &pos_)
-    :   id(id_), value(value_), pos(pos_)
+    :   id(id_), pos(pos_), symbol(intern(id_, value_)), value(value_)
     {}
 
 // accessors
@@ -63,9 +67,13 @@ public:
     position_type const &get_position() const { return pos; }
     bool is_eoi() const { return id == T_EOI; }
     bool is_valid() const { return id != T_UNKNOWN; }
+    //  the interned spelling of a token which can name a macro (identifier,
+    //  keyword, true/false or an alternative token like and), no_symbol
+    //  for the other tokens
+    std::uint32_t get_symbol() const { return symbol; }
 
-    void set_token_id (token_id id_) { id = id_; }
-    void set_value (string_type const &newval) { value = newval; }
+    void set_token_id (token_id id_) { id = id_; symbol = intern(id, value); }
+    void set_value (string_type const &newval) { value = newval; symbol = intern(id, value); }
     void set_position (position_type const &pos_) { pos = pos_; }
 
     friend bool operator== (slex_token const& lhs, slex_token const& rhs)
@@ -112,9 +120,23 @@ public:
     }
 
 private:
+    static std::uint32_t intern(token_id id_, string_type const &value_)
+    {
+        if (IS_CATEGORY(id_, IdentifierTokenType) || IS_CATEGORY(id_, KeywordTokenType) ||
+            IS_CATEGORY(id_, BoolLiteralTokenType) ||
+            IS_EXTCATEGORY(id_, OperatorTokenType|AltExtTokenType))
+        {
+            return symbol_table::instance().intern(value_);
+        }
+        return symbol_table::no_symbol;
+    }
+
     boost::wave::token_id id;   // the token id
-    string_type value;             // the text, which was parsed into this token
-    PositionT pos;              // the original file position
+    PositionT pos;              // the original file position, next to the id
+                                // to pack it with a slex_position
+    std::uint32_t symbol;       // the interned value of the macro names,
+                                // fills the padding before value
+    string_type value;          // the text, which was parsed into this token
 };
 
 template <typename PositionT>
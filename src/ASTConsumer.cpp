@@ -25,6 +25,7 @@ limitations under the License.
 #include "clang_interface/FunctionInfo.h"
 
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 #include "clang/AST/Decl.h"
 #include "clang/Basic/Builtins.h"
@@ -34,21 +35,167 @@ limitations under the License.
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendOptions.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/Token.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Serialization/ASTReader.h"
 
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+namespace
+{
+/**
+ * @class FunctionRangeScanner
+ * @brief finds the function bodies by matching the braces of the
+ * preprocessed tokens of the main file, used instead of the AST when
+ * only the preprocessor is run. A brace which follows a closing paren
+ * (possibly with qualifiers or a constructor initializer list in between)
+ * starts a function body; other braces belong to a namespace, class,
+ * struct, union, enum or extern block or to an initializer.
+ */
+class FunctionRangeScanner
+{
+public:
+    void PutToken(const clang::Token& token, std::size_t line)
+    {
+        using namespace clang;
+
+        if(insideFunction)
+        {
+            if(token.is(tok::l_brace))
+            {
+                braces.push_back(BraceKind::block);
+            }
+            else if(token.is(tok::r_brace))
+            {
+                if(braces.back() == BraceKind::function)
+                {
+                    functionInfo[fmt::format("{}:{}", functionName, functionStart)] = { functionStart, line };
+                    insideFunction = false;
+                }
+                braces.pop_back();
+            }
+            return;
+        }
+
+        switch(token.getKind())
+        {
+        case tok::l_paren:
+            if(parenDepth++ == 0)
+            {
+                candidateName = lastIdentifier;
+                candidateLine = line;
+            }
+            return;
+        case tok::r_paren:
+            if(parenDepth > 0 && --parenDepth == 0)
+            {
+                afterParen = true;
+            }
+            return;
+        default:
+            break;
+        }
+
+        if(parenDepth > 0)
+        {
+            return;
+        }
+
+        switch(token.getKind())
+        {
+        case tok::identifier:
+            lastIdentifier = token.getIdentifierInfo()->getName().str();
+            break;
+        case tok::kw_namespace:
+        case tok::kw_class:
+        case tok::kw_struct:
+        case tok::kw_union:
+        case tok::kw_enum:
+        case tok::kw_extern:
+            scopeHead = true;
+            break;
+        case tok::l_brace:
+            // checked first, the head of a function may also contain
+            // a class-key e.g. struct S* f() {
+            if(afterParen)
+            {
+                braces.push_back(BraceKind::function);
+                insideFunction = true;
+                functionName = candidateName;
+                functionStart = candidateLine;
+            }
+            else if(scopeHead)
+            {
+                braces.push_back(BraceKind::scope);
+            }
+            else
+            {
+                // e.g. brace initialization of a variable
+                braces.push_back(BraceKind::block);
+            }
+            scopeHead = false;
+            afterParen = false;
+            break;
+        case tok::r_brace:
+            if(!braces.empty())
+            {
+                braces.pop_back();
+            }
+            scopeHead = false;
+            afterParen = false;
+            break;
+        case tok::semi:
+        case tok::equal:
+            scopeHead = false;
+            afterParen = false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::map<std::string, ParsedDeclInfo> const& GetFunctionInfo() const
+    {
+        return functionInfo;
+    }
+
+private:
+    enum class BraceKind
+    {
+        scope,
+        function,
+        block
+    };
+
+private:
+    std::vector<BraceKind> braces;
+    bool insideFunction{ false };
+    int parenDepth{ 0 };
+    bool afterParen{ false };
+    bool scopeHead{ false };
+    std::string lastIdentifier;
+    std::string candidateName;
+    std::size_t candidateLine{ 0 };
+    std::string functionName;
+    std::size_t functionStart{ 0 };
+    std::map<std::string, ParsedDeclInfo> functionInfo;
+};
+} // namespace
+
 std::ostream& operator<<(std::ostream& os, const ParsedDeclInfo& inf)
 {
     os << inf.start_line;
@@ -410,7 +557,8 @@ bool MyASTConsumer::HandleTopLevelDecl(clang::DeclGroupRef d)
 }
 
 /******************************************************************************
- *
+ * sets up everything which does not depend on the file being parsed, the
+ * per file state is created by BeginTranslationUnit
  *****************************************************************************/
 int MyASTConsumer::InitializeCI(
         clang::CompilerInstance& ci, const std::vector<std::filesystem::path>& search_paths)
@@ -428,29 +576,22 @@ int MyASTConsumer::InitializeCI(
 
     clang::CompilerInvocation::setLangDefaults(ci.getLangOpts(), clang::Language::CXX,
             llvm::Triple(llvm::Twine(to->Triple)), pci->getPreprocessorOpts(),
-            clang::LangStandard::lang_cxx11);
+            languageStandard);
 
     auto* pti = clang::TargetInfo::CreateTargetInfo(ci.getDiagnostics(), to);
     //ci.getInvocation().TargetOpts);
 
     ci.setTarget(pti);
+    /// the file manager is shared by all the translation units so that
+    /// the headers included by several files are looked up only once
     ci.createFileManager(nullptr);
-    ci.createSourceManager(ci.getFileManager());
-    ci.createPreprocessor(clang::TranslationUnitKind::TU_Complete);
 
     /// \brief to enable parsing of exceptions by the clang front end
     ci.getLangOpts().CXXExceptions = 1;
 
-    using clang::FrontendOptions;
-    using clang::HeaderSearchOptions;
-    using clang::PreprocessorOptions;
-
-    PreprocessorOptions& PPOpts = ci.getPreprocessorOpts();
-
-    set_package_specific_options(PPOpts);
+    set_package_specific_options(ci.getPreprocessorOpts());
 
-    clang::Preprocessor& PP = ci.getPreprocessor();
-    HeaderSearchOptions& HSOpts = ci.getHeaderSearchOpts();
+    clang::HeaderSearchOptions& HSOpts = ci.getHeaderSearchOpts();
 
     /// use the libc++ library
     HSOpts.UseLibcxx = 1;
@@ -470,30 +611,97 @@ int MyASTConsumer::InitializeCI(
     // Include header paths for the package.
     set_package_specific_paths(HSOpts);
 
+    // @TODO: Use make_unique
+    std::unique_ptr<ASTConsumer> Consumer(new MyASTConsumer);
+    ci.setASTConsumer(std::move(Consumer));
+
+    return 0;
+}
+
+std::string MyASTConsumer::GetConfiguration() const
+{
+    clang::CompilerInstance& ci = *pci;
+    return fmt::format("{};{};{};{}", ci.getTarget().getTriple().str(),
+            clang::LangStandard::getLangStandardForKind(languageStandard).getName(),
+            ci.getHeaderSearchOpts().UseLibcxx ? "libc++" : "libstdc++", clang::getClangFullVersion());
+}
+
+/******************************************************************************
+ * the predefines buffer is filled in when the preprocessor is initialized,
+ * no file has to be entered for it
+ *****************************************************************************/
+std::string MyASTConsumer::GetPredefines()
+{
+    BeginTranslationUnit();
+    return pci->getPreprocessor().getPredefines();
+}
+
+/******************************************************************************
+ * releases the state of the previous translation unit (if any) and creates
+ * a fresh SourceManager, Preprocessor and ASTContext on top of the
+ * FileManager and target which are kept in the CompilerInstance
+ *****************************************************************************/
+void MyASTConsumer::BeginTranslationUnit()
+{
+    clang::CompilerInstance& ci = *pci;
+
+    // The ASTContext and the Preprocessor refer to the SourceManager
+    // so they have to go first. The TrackMacro callback is owned by
+    // the Preprocessor and goes with it. The PCH reader of the previous
+    // translation unit refers to all three.
+    ci.setASTReader(nullptr);
+    if(ci.hasASTContext())
+    {
+        ci.setASTContext(nullptr);
+    }
+    if(ci.hasPreprocessor())
+    {
+        ci.setPreprocessor(nullptr);
+    }
+    if(ci.hasSourceManager())
+    {
+        ci.setSourceManager(nullptr);
+    }
+    ci.getDiagnostics().Reset();
+    FunctionInfo.clear();
+
+    ci.createSourceManager(ci.getFileManager());
+    ci.createPreprocessor(clang::TranslationUnitKind::TU_Complete);
+
+    using clang::FrontendOptions;
+    using clang::PreprocessorOptions;
+
+    PreprocessorOptions& PPOpts = ci.getPreprocessorOpts();
+    clang::Preprocessor& PP = ci.getPreprocessor();
+
     const FrontendOptions& FEOpts = ci.getFrontendOpts();
     const auto& PCHHR = ci.getPCHContainerReader();
     ApplyHeaderSearchOptions(
-            PP.getHeaderSearchInfo(), HSOpts, PP.getLangOpts(), PP.getTargetInfo().getTriple());
+            PP.getHeaderSearchInfo(), ci.getHeaderSearchOpts(), PP.getLangOpts(), PP.getTargetInfo().getTriple());
 
     PP.getBuiltinInfo().initializeBuiltins(PP.getIdentifierTable(), PP.getLangOpts());
 
     clang::InitializePreprocessor(PP, PPOpts, PCHHR, FEOpts);
 
-    // @TODO: Use make_unique
-    std::unique_ptr<ASTConsumer> Consumer(new MyASTConsumer);
-    ci.setASTConsumer(std::move(Consumer));
     ci.createASTContext();
 
+    // set by the FrontEndContext for the files starting with the prefix
+    // headers. The macros of the PCH are deserialized without MacroDefined
+    // callbacks and are not in the main file anyway, so TrackMacro sees
+    // the same main file macros as without it.
+    if(!PPOpts.ImplicitPCHInclude.empty())
+    {
+        ci.createPCHExternalASTSource(PPOpts.ImplicitPCHInclude, false, false, nullptr, false);
+    }
+
     // Pass the callback function to PP and it will manage the memory.
     // @TODO: Use make_unique
     track_macro = new clang::TrackMacro;
     track_macro->SetCompilerInstance(&ci);
     PP.addPPCallbacks(std::unique_ptr<clang::PPCallbacks>(track_macro));
-
-    return 0;
 }
 
-void MyASTConsumer::DumpContent(std::string const& file_name)
+void MyASTConsumer::EnterMainFile(std::string const& file_name, std::string_view contents)
 {
     clang::CompilerInstance& ci = *pci;
     m_current_file = file_name;
@@ -501,20 +709,63 @@ void MyASTConsumer::DumpContent(std::string const& file_name)
     // Kind is C_User for now because I do not know how to set the right option,
     // this does not matter so much, I think it is only used to selectively
     // emit/ignore compiler warnings.
+    // The FileEntry is still needed for the quoted includes relative to the
+    // file, its contents come from the caller's buffer instead of the disk.
     const clang::FileEntry* pFile = ci.getFileManager().getFile(file_name).get();
     clang::SourceManager& SourceMgr = ci.getSourceManager();
+    SourceMgr.overrideFileContents(pFile,
+            llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(contents.data(), contents.size()), file_name));
     SourceMgr.setMainFileID(SourceMgr.createFileID(pFile, clang::SourceLocation(), clang::SrcMgr::C_User));
 
     // set file and loc parameters for the track_macro callback
     // placing here is important. It should be after the source manager
     // has created fileid for the file to be processed.
     track_macro->SetFileName(m_current_file);
+}
+
+void MyASTConsumer::DumpContent(std::string const& file_name, std::string_view contents)
+{
+    BeginTranslationUnit();
+    EnterMainFile(file_name, contents);
 
+    clang::CompilerInstance& ci = *pci;
     ci.getDiagnosticClient().BeginSourceFile(ci.getLangOpts(), &ci.getPreprocessor());
     clang::ParseAST(ci.getPreprocessor(), this, ci.getASTContext());
     ci.getDiagnosticClient().EndSourceFile();
 }
 
+void MyASTConsumer::PreprocessContent(std::string const& file_name, std::string_view contents)
+{
+    BeginTranslationUnit();
+    EnterMainFile(file_name, contents);
+
+    clang::CompilerInstance& ci = *pci;
+    clang::SourceManager& SourceMgr = ci.getSourceManager();
+    clang::Preprocessor& PP = ci.getPreprocessor();
+    ci.getDiagnosticClient().BeginSourceFile(ci.getLangOpts(), &PP);
+    PP.EnterMainSourceFile();
+
+    // the macro callbacks are invoked while lexing, the function
+    // ranges come from the braces of the main file
+    FunctionRangeScanner scanner;
+    clang::Token tok;
+
+    do
+    {
+        PP.Lex(tok);
+
+        const clang::SourceLocation loc = SourceMgr.getExpansionLoc(tok.getLocation());
+        if(SourceMgr.isInMainFile(loc))
+        {
+            scanner.PutToken(tok, SourceMgr.getPresumedLoc(loc, true).getLine());
+        }
+    } while(tok.isNot(clang::tok::eof));
+
+    ci.getDiagnosticClient().EndSourceFile();
+
+    FunctionInfo = scanner.GetFunctionInfo();
+}
+
 void MyASTConsumer::PrintSourceLocation(const clang::SourceManager& sm, clang::SourceLocation loc)
 {
     /// print only when the functions are in the current file
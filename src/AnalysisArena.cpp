@@ -0,0 +1,60 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "cpp2cxx/AnalysisArena.h"
+
+namespace
+{
+
+/// the first buffer holds the tree of a small file, the later ones grow
+/// geometrically
+constexpr std::size_t initialBufferSize = 64 * 1024;
+
+} // namespace
+
+AnalysisArena::AnalysisArena()
+        : resource(initialBufferSize)
+{
+}
+
+AnalysisArena::~AnalysisArena()
+{
+    Release();
+}
+
+void AnalysisArena::Release()
+{
+    for(auto d = destructors.rbegin(); d != destructors.rend(); ++d)
+    {
+        d->destroy(d->object);
+    }
+    destructors.clear();
+    resource.release();
+    allocatedBytes = 0;
+}
+
+std::size_t AnalysisArena::GetAllocatedBytes() const
+{
+    return allocatedBytes;
+}
@@ -24,27 +24,12 @@ limitations under the License.
 #include "cpp2cxx/CondParser.h"
 
 #include <algorithm>
-#include <fstream>
 #include <sstream>
+#include <utility>
 
-CondParser::CondParser(const std::filesystem::path& file_global_macros)
+CondParser::CondParser(GlobalMacros_t global_macros)
+        : macroList(std::move(global_macros))
 {
-    std::ifstream gMacros(file_global_macros, std::ios_base::in);
-    
-    if(!gMacros.is_open())
-    {
-        // FIXME: Communicate this error better.
-        return;
-    }
-
-    gMacros.seekg(0, std::ios::beg);
-
-    for(std::string fc, sc; std::getline(gMacros, fc), std::getline(gMacros, sc); )
-    {
-        macroList.insert({fc, sc});
-    }
-
-    gMacros.close();
 }
 
 void CondParser::ParseConditions(Node& tree_node, token_iterator t_it)
@@ -488,7 +473,7 @@ void CondParser::Expression8()
 
 bool CondParser::PPCheckIdentifier(const std::string& id_str)
 {
-    return macroList.contains(id_str);
+    return macroList->Contains(id_str);
 }
 
 token_iterator CondParser::GetTokenPosition()
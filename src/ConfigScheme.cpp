@@ -76,6 +76,32 @@ void ConfigScheme::SetBuildScheme(std::string const& make_command)
     pBuildScheme.makeCommand = make_command;
 }
 
+void ConfigScheme::SetFrontEndMode(std::string const& front_end_mode)
+{
+    pDemacroficationScheme.frontEndMode = front_end_mode;
+}
+
+void ConfigScheme::SetLexerBackend(std::string const& lexer_backend)
+{
+    pDemacroficationScheme.lexerBackend = lexer_backend;
+}
+
+void ConfigScheme::SetLexerThreads(std::size_t lexer_threads)
+{
+    pDemacroficationScheme.lexerThreads = lexer_threads;
+}
+
+void ConfigScheme::SetPrefixHeaders(std::vector<std::string> const& prefix_headers)
+{
+    pDemacroficationScheme.prefixHeaders = prefix_headers;
+}
+
+void ConfigScheme::SetPredefinedMacros(std::string const& predefined_macros, std::string const& cache_directory)
+{
+    pDemacroficationScheme.predefinedMacros = predefined_macros;
+    pDemacroficationScheme.predefinedMacroCache = cache_directory;
+}
+
 FileManagerScheme& ConfigScheme::GetFileManagerScheme()
 {
     return pFileManagerScheme;
@@ -27,132 +27,211 @@ limitations under the License.
 #include <fmt/core.h>
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
-Node* MacTree::GetParent(Node* const np)
+namespace
 {
-    return np->parent;
+
+/// the tokens of a file are lexed once, so the position of the identifier
+/// token of a definition is unique within the tree
+std::uint64_t DefinitionKey(token_type const& identifier)
+{
+    const auto& pos = identifier.get_position();
+    return (std::uint64_t{ pos.get_source() } << 32) | pos.get_offset();
 }
 
-Vertex_t MacTree::GetParent(Vertex_t const v)
+/// the end of the chain of the macros of a node
+constexpr std::uint32_t noMacro = UINT32_MAX;
+
+} // namespace
+
+MacTree::MacTree(AnalysisArena& analysis_arena)
+        : arena(analysis_arena)
 {
-    //in a uni-directed graph incoming edge can't be accessed
-    Node* cn = depGraph[v];
-    Node* pn = cn->parent;
+    // the root stands for the whole file and has no condition
+    AddNode(Node(), TokenSpan(), noNode);
+}
 
-    // FIXME: What if nothing is found here?
-    const auto nodeMap_iter = nodeMap.find(pn);
-    return nodeMap_iter->second;
+NodeIndex_t MacTree::AddNode(Node const& rn, TokenSpan condition, NodeIndex_t parentN)
+{
+    const auto n = static_cast<NodeIndex_t>(parents.size());
+    parents.push_back(noNode);
+    firstChildren.push_back(noNode);
+    lastChildren.push_back(noNode);
+    nextSiblings.push_back(noNode);
+    conditions.push_back(condition);
+    condCategories.push_back(rn.condCat);
+    firstMacros.push_back(noMacro);
+    lastMacros.push_back(noMacro);
+    if(parentN != noNode)
+    {
+        LinkChild(parentN, n);
+    }
+    return n;
+}
+
+void MacTree::LinkChild(NodeIndex_t parentN, NodeIndex_t childN)
+{
+    parents[childN] = parentN;
+    nextSiblings[childN] = noNode;
+    if(lastChildren[parentN] == noNode)
+    {
+        firstChildren[parentN] = childN;
+    }
+    else
+    {
+        nextSiblings[lastChildren[parentN]] = childN;
+    }
+    lastChildren[parentN] = childN;
 }
 
-Node const* MacTree::GetRoot() const
+void MacTree::UnlinkChild(NodeIndex_t childN)
 {
-    return depGraph[startVertex];
+    const NodeIndex_t parentN = parents[childN];
+    if(parentN == noNode)
+    {
+        return;
+    }
+    // the siblings are singly linked, the previous one is searched
+    NodeIndex_t prev = noNode;
+    for(NodeIndex_t n = firstChildren[parentN]; n != childN; n = nextSiblings[n])
+    {
+        prev = n;
+    }
+    (prev == noNode ? firstChildren[parentN] : nextSiblings[prev]) = nextSiblings[childN];
+    if(lastChildren[parentN] == childN)
+    {
+        lastChildren[parentN] = prev;
+    }
+    parents[childN] = noNode;
+    nextSiblings[childN] = noNode;
 }
-/*
-Node* MacTree::GetFirstChild(Vertex_t const currV)
+
+NodeIndex_t MacTree::GetRoot() const
 {
-  return depGraph([boost::out_edges(currV,depGraph)).first];
+    return 0;
 }
-*/
-std::pair<OutEdgeIterator_t, OutEdgeIterator_t> MacTree::GetSiblings(Vertex_t const vd)
+
+NodeIndex_t MacTree::GetCurrentNode() const
+{
+    return currNode;
+}
+
+NodeIndex_t MacTree::GetParent(NodeIndex_t n) const
 {
-    Vertex_t v = GetParent(vd);
-    return boost::out_edges(v, depGraph);
+    return parents[n];
 }
 
-std::pair<OutEdgeIterator_t, OutEdgeIterator_t> MacTree::GetChildren(Vertex_t const vd)
+NodeIndex_t MacTree::GetFirstChild(NodeIndex_t n) const
 {
-    return boost::out_edges(vd, depGraph);
+    return firstChildren[n];
+}
+
+NodeIndex_t MacTree::GetNextSibling(NodeIndex_t n) const
+{
+    return nextSiblings[n];
+}
+
+std::pair<ChildIterator, ChildIterator> MacTree::GetSiblings(NodeIndex_t n) const
+{
+    return GetChildren(GetParent(n));
+}
+
+std::pair<ChildIterator, ChildIterator> MacTree::GetChildren(NodeIndex_t n) const
+{
+    return { ChildIterator(this, firstChildren[n]), ChildIterator(this, noNode) };
 }
 
 int MacTree::GetNumNodes() const
 {
-    return nodeIndex;
+    return static_cast<int>(parents.size()) - 1;
 }
 
-bool MacTree::IsRoot(Vertex_t vd) const
+bool MacTree::IsRoot(NodeIndex_t n) const
 {
-    return vd == startVertex;
+    return n == GetRoot();
 }
 
-//sibling of the currently pointed vertex
-bool MacTree::MakeSibling(Node& rn)
+boost::wave::token_id MacTree::GetKey(NodeIndex_t n) const
+{
+    return conditions[n].empty() ? boost::wave::T_UNKNOWN : boost::wave::token_id(*conditions[n].first);
+}
+
+TokenSpan MacTree::GetCondition(NodeIndex_t n) const
 {
-    Vertex_t v_dummy{}; //faking
+    return conditions[n];
+}
 
-    // @TODO: Replace with smart pointer?
-    Node* pn = new Node;
-    *pn = rn;
-    if(IsRoot(currVertex))
+CondCategory MacTree::GetCondCategory(NodeIndex_t n) const
+{
+    return condCategories[n];
+}
+
+std::vector<PPMacro*> MacTree::GetMacros(NodeIndex_t n) const
+{
+    std::vector<PPMacro*> macros;
+    for(std::uint32_t m = firstMacros[n]; m != noMacro; m = nextMacros[m])
+    {
+        macros.push_back(linearOrder[m]);
+    }
+    return macros;
+}
+
+//sibling of the currently pointed vertex
+bool MacTree::MakeSibling(Node const& rn, TokenSpan condition)
+{
+    if(IsRoot(currNode))
     {
         // @TODO: Remove this.
         throw ExceptionHandler("No sibling for root vertex.\n");
     }
-    //this line should be after the previous assignment of *pn=rn !
-    Vertex_t u = GetParent(currVertex);
-    pn->parent = depGraph[u];
-    pn->nodeIndex = ++nodeIndex;
-    NodeMap_t::iterator nodeMap_iter;
-    //map::insert() returns pair<iterator,bool>
-    nodeMap_iter = nodeMap.insert(std::make_pair(pn, v_dummy)).first;
-    //add the pointer to node to the multimap
-    //and capturing the returned vertex descriptor
-    Vertex_t v = boost::add_vertex(nodeMap_iter->first, depGraph);
-    nodeMap_iter->second = v; //now assigning the vertex descriptor
-    //return if the edge was created or it was already there
-    //add edge returns a pair <edge_descriptor,bool>
-    //Vertex_t u = GetParent(currVertex);
-    const bool new_edge = boost::add_edge(u, v, depGraph).second;
-    currVertex = nodeMap_iter->second;
-
-    return new_edge;
+    currNode = AddNode(rn, condition, GetParent(currNode));
+    return true;
 }
 
 //child to the currently pointed vertex
-bool MacTree::MakeChild(Node& rn)
-{
-    Vertex_t v_dummy{}; //faking
-    // @TODO: Replace with smart pointer?
-    Node* pn = new Node;
-    *pn = rn;
-    //this line should be after the previous one!
-    pn->parent = depGraph[currVertex];
-    pn->nodeIndex = ++nodeIndex;
-    NodeMap_t::iterator nodeMap_iter;
-    nodeMap_iter = nodeMap.insert(std::make_pair(pn, v_dummy)).first;
-    Vertex_t v = boost::add_vertex(nodeMap_iter->first, depGraph);
-    nodeMap_iter->second = v; //now assigning the vertex descriptor
-    //return if the edge was created or it was already there
-    //add edge returns a pair <edge_descriptor,bool>
-    const bool new_edge = boost::add_edge(currVertex, v, depGraph).second;
-    currVertex = nodeMap_iter->second;
-
-    return new_edge;
+bool MacTree::MakeChild(Node const& rn, TokenSpan condition)
+{
+    currNode = AddNode(rn, condition, currNode);
+    return true;
 }
 
-bool MacTree::MakeChild(Vertex_t parentV, Vertex_t childV)
+bool MacTree::MakeChild(NodeIndex_t parentN, NodeIndex_t childN)
 {
-    currVertex = childV;
+    currNode = childN;
     //return if the edge was created or it was already there
-    return boost::add_edge(parentV, childV, depGraph).second;
+    if(parents[childN] == parentN || IsRoot(childN))
+    {
+        return false;
+    }
+    UnlinkChild(childN);
+    LinkChild(parentN, childN);
+    return true;
 }
 
-bool MacTree::MakeSibling(Vertex_t firstV, Vertex_t secondV)
+bool MacTree::MakeSibling(NodeIndex_t firstN, NodeIndex_t secondN)
 {
-    currVertex = secondV;
-    //return if the edge was created or it was already there
-    Vertex_t v = GetParent(firstV);
-    return boost::add_edge(v, secondV, depGraph).second;
+    if(IsRoot(firstN))
+    {
+        return false;
+    }
+    return MakeChild(GetParent(firstN), secondN);
 }
 
 void MacTree::PushBackMacro(PPMacro& mac)
 {
-    PPMacro* m_ptr = depGraph[currVertex]->PushBackMacro(mac);
+    PPMacro* m_ptr = arena.Create<PPMacro>(mac);
+    const auto m = static_cast<std::uint32_t>(linearOrder.size());
     linearOrder.push_back(m_ptr);
-    tokenMacroMap.insert({m_ptr->identifier, m_ptr});
+    nextMacros.push_back(noMacro);
+    (lastMacros[currNode] == noMacro ? firstMacros[currNode] : nextMacros[lastMacros[currNode]]) = m;
+    lastMacros[currNode] = m;
+    symbolMacroMap[m_ptr->identifier.get_symbol()].push_back(m_ptr);
+    definitionMap.emplace(DefinitionKey(m_ptr->identifier), m_ptr);
 }
 
 const DepList_t& MacTree::BuildMacroDependencyList()
@@ -165,12 +244,12 @@ const DepList_t& MacTree::BuildMacroDependencyList()
 
         for(auto&& anId : mp_iter->get_replacement_list_dep_idlist())
         {
-            auto tmm_iter = tokenMacroMap.find(anId);
+            MacroDefinitions_t const& definitions = GetMacro(anId);
 
             //check if the token was not found
-            if(tmm_iter != tokenMacroMap.end())
+            if(!definitions.empty())
             {
-                vec_mp.push_back(tmm_iter->second);
+                vec_mp.push_back(definitions.front());
             }
             else
             {
@@ -187,95 +266,138 @@ const DepList_t& MacTree::BuildMacroDependencyList()
 
 void MacTree::GotoParent()
 {
-    currVertex = GetParent(currVertex);
-}
-
-void MacTree::DeleteNodes()
-{
-    //for each out_edges call the delete
-    //vertices(g) returns the pair of vertex iterators
-    //the first one points to the first vertex
-    //the second points past the end of the last vertex
-    //dereferencing the vertex iterator gives the vertex object
-    for(auto vp = vertices(depGraph); vp.first != vp.second; ++vp.first)
+    if(!IsRoot(currNode))
     {
-        delete depGraph[*(vp.first)];
+        currNode = GetParent(currNode);
     }
 }
 
-bool MacTree::DeleteVertex(Vertex_t v)
+bool MacTree::DeleteVertex(NodeIndex_t n)
 {
-    //first delete all the macros in the node as they are allocated on the store
-    if(startVertex == v)
+    if(IsRoot(n))
     {
         return false;
     }
 
-    if(currVertex == v)
+    for(NodeIndex_t a = currNode; a != noNode; a = parents[a])
     {
-        currVertex = GetParent(v); //point to the parent now
+        if(a == n)
+        {
+            currNode = GetParent(n); //point to the parent now
+            break;
+        }
     }
-    //not deleting the node now,
-    //will delete the node during destruction via nodeMap
-    boost::clear_vertex(v, depGraph);
-    boost::remove_vertex(v, depGraph);
+    //the node stays in the arrays, only unreachable
+    UnlinkChild(n);
 
     return true;
 }
 
-PairMacroIter_t MacTree::GetMacro(token_type const& tok)
+MacroDefinitions_t const& MacTree::GetMacro(token_type const& tok) const
+{
+    static const MacroDefinitions_t no_definitions;
+
+    // only the tokens which can name a macro have a symbol
+    if(tok.get_symbol() == boost::wave::cpplexer::symbol_table::no_symbol)
+    {
+        return no_definitions;
+    }
+    const auto sm_iter = symbolMacroMap.find(tok.get_symbol());
+    return sm_iter == symbolMacroMap.end() ? no_definitions : sm_iter->second;
+}
+
+PPMacro* MacTree::GetDefinition(token_type const& identifier) const
 {
-    return tokenMacroMap.equal_range(tok);
+    const auto def_iter = definitionMap.find(DefinitionKey(identifier));
+    return def_iter == definitionMap.end() ? nullptr : def_iter->second;
 }
 
-bool MacTree::IsMacro(const token_type& tok)
+bool MacTree::IsMacro(const token_type& tok) const
 {
     //if there is atleast a macro with the token_type tok as identifier
-    return GetMacro(tok).first != GetMacro(tok).second;
+    return !GetMacro(tok).empty();
 }
 
 //checks the token to get the use case of macro
-void MacTree::CheckToken(const token_iterator& tok_iter)
+bool MacTree::CheckToken(const token_iterator& tok_iter)
 {
-    const PairMacroIter_t pm_iter = GetMacro(*tok_iter);
+    MacroDefinitions_t const& definitions = GetMacro(*tok_iter);
 
     //if there is no macro corresponding to this token
 
-    if(pm_iter.first == pm_iter.second)
+    if(definitions.empty())
     {
         //are we collecting tokens in a macro invocation
-        if(macroUseCaseState.DoneCollection())
-        {
-            return;
-        }
-        else
+        if(!macroUseCaseState.DoneCollection())
         {
             macroUseCaseState.PutToken(tok_iter);
         }
+        return false;
     }
-    else
+
+    /// @todo this token is a macro we are taking the first definition
+    /// *********collecting the args of function like macro **********
+    if(IsFunctionLike(*definitions.front()))
     {
-        /// @todo this token is a macro we are taking the first entry
-        /// of the multimap which keeps macro
-        /// *********collecting the args of function like macro **********
-        if(IsFunctionLike(*pm_iter.first->second))
-        {
-            macroUseCaseState.PutArgBegin(tok_iter, pm_iter.first->second);
-        }
+        macroUseCaseState.PutArgBegin(tok_iter, definitions.front());
     }
+
+    return std::any_of(definitions.begin(), definitions.end(),
+            [](PPMacro const* m_ptr) { return m_ptr->operation == PPOperation::define; });
+}
+
+NodeIndex_t MacTree::GetAncestor(int nesting_level) const
+{
+    std::vector<NodeIndex_t> path;
+    for(NodeIndex_t n = currNode; n != noNode; n = parents[n])
+    {
+        path.push_back(n);
+    }
+    if(nesting_level < 0 || static_cast<std::size_t>(nesting_level) >= path.size())
+    {
+        return noNode;
+    }
+    return path[path.size() - 1 - nesting_level];
 }
 
 //algorithms
-void MacTree::Dfs(Vertex_t const startV)
+void MacTree::Dfs(NodeIndex_t const startN, std::vector<NodeIndex_t>& order) const
 {
-    //boost::depth_first_search(depGraph);
+    // the explicit stack holds the next node to visit at each level
+    std::vector<NodeIndex_t> stack{ startN };
+    while(!stack.empty())
+    {
+        const NodeIndex_t n = stack.back();
+        stack.pop_back();
+        order.push_back(n);
+        if(n != startN && nextSiblings[n] != noNode)
+        {
+            stack.push_back(nextSiblings[n]);
+        }
+        if(firstChildren[n] != noNode)
+        {
+            stack.push_back(firstChildren[n]);
+        }
+    }
 }
 
-void MacTree::Bfs(Vertex_t const startV)
+void MacTree::Bfs(NodeIndex_t const startN, std::vector<NodeIndex_t>& order) const
 {
+    const std::size_t first = order.size();
+    order.push_back(startN);
+    for(std::size_t i = first; i < order.size(); ++i)
+    {
+        for(NodeIndex_t c = firstChildren[order[i]]; c != noNode; c = nextSiblings[c])
+        {
+            order.push_back(c);
+        }
+    }
 }
 
-void MacTree::TopSort(std::vector<Graph_t::vertex_descriptor>& topo_order)
+void MacTree::TopSort(std::vector<NodeIndex_t>& topo_order) const
 {
-    boost::topological_sort(depGraph, std::back_inserter(topo_order));
+    // the reverse of a preorder puts the descendants before the node
+    std::vector<NodeIndex_t> preorder;
+    Dfs(GetRoot(), preorder);
+    topo_order.insert(topo_order.end(), preorder.rbegin(), preorder.rend());
 }
@@ -26,7 +26,7 @@ limitations under the License.
 #include "cpp2cxx/FileManager.h"
 #include "cpp2cxx/ExceptionHandler.h"
 #include "cpp2cxx/FileManagerScheme.h"
-#include "cpp2cxx/Overseer.h" //observable
+#include "cpp2cxx/FileSession.h" //observable
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -107,21 +107,14 @@ void FileManager::UpdateFile(std::string_view file_str)
     }
 }
 
-// @TODO: Figure out where to increment the file index.
-void FileManager::UpdateFile(Overseer const& overseer)
+void FileManager::UpdateFile(FileSession const& session)
 {
+    outputFileIndex = session.GetFileIndex();
     auto output_file = GetCurrentOutputFile();
 
     if(fs::exists(output_file))
     {
-        std::ofstream fp(output_file, std::ios_base::out);
-
-        if(fp.is_open())
-        {
-            overseer.WriteOutputFile(fp);
-            fp.close();
-        }
-        else
+        if(!session.WriteOutputFile(output_file))
         {
             /// @brief if output file is null then the output will be
             /// printed on the screen
@@ -131,30 +124,31 @@ void FileManager::UpdateFile(Overseer const& overseer)
                     "Output shall be redirected to the standard output",
                     fileManagerScheme.outputFiles[outputFileIndex].string());
             WriteLog(error_msg);
-            overseer.WriteOutputFile(std::cout);
+            session.WriteOutputFile(std::cout);
         }
     }
     else
     {
         ///For no output file name output shall be
         ///redirected to the standard output";
-        // @TODO: Remove unsafe bounds here.
         std::string log_msg = fmt::format(
                 "For input file: {} no output file was found.\n"
                 "Output shall be directed to the standard output.",
-                fileManagerScheme.inputFiles[outputFileIndex].string());
+                session.GetFileName().string());
         WriteLog(log_msg);
-        overseer.WriteOutputFile(std::cout);
+        session.WriteOutputFile(std::cout);
     }
 }
 
 
 fs::path FileManager::GetCurrentOutputFile()
 {
-    // @TODO: Remove unsafe bounds here.
-    auto output_file_name = fileManagerScheme.outputFiles[outputFileIndex];
-    // ++outputFileIndex;
-    return output_file_name;
+    if(outputFileIndex >= fileManagerScheme.outputFiles.size())
+    {
+        return {};
+    }
+
+    return fileManagerScheme.outputFiles[outputFileIndex];
 }
 
 const std::vector<fs::path>& FileManager::GetSearchPaths() const
@@ -0,0 +1,288 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/FileSession.h"
+#include "cpp2cxx/DemacroficationScheme.h"
+#include "cpp2cxx/MacroPreScan.h"
+#include "cpp2cxx/Parser.h"
+#include "cpp2cxx/SourceBuffer.h"
+
+#include "clang_interface/FrontEndContext.hpp"
+
+#include "general_utilities/file_type.hpp"
+
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+FileSession::FileSession(std::size_t file_index, std::filesystem::path file_name,
+        DemacroficationScheme const& demacrofication_scheme, GlobalMacros_t const& global_macros,
+        FrontEndContext* front_end)
+        : fileIndex(file_index),
+          fileName(std::move(file_name)),
+          demacroficationScheme(demacrofication_scheme),
+          frontEnd(front_end),
+          source(fileName),
+          pParser(std::make_unique<Parser>(demacrofication_scheme, logStream, global_macros,
+                  &analysisArena)),
+          scopeClassifier(front_end != nullptr ? lexerMacroStat : ASTMacroStat)
+{
+}
+
+void FileSession::Run(bool demacrofy)
+{
+    try
+    {
+        GenerateExternalASTHandler();
+        RunParser();
+
+        if(clangSkipped)
+        {
+            logStream << "  - log: clang front end skipped, no macro needs it\n";
+        }
+
+        if(demacrofy)
+        {
+            RunDemacrofier();
+            RunDependencyAnalyzer();
+        }
+    }
+    catch(...)
+    {
+        error = std::current_exception();
+    }
+
+    ReleaseParser();
+}
+
+std::size_t FileSession::GetFileIndex() const
+{
+    return fileIndex;
+}
+
+const std::filesystem::path& FileSession::GetFileName() const
+{
+    return fileName;
+}
+
+bool FileSession::IsParsed() const
+{
+    return parsed;
+}
+
+bool FileSession::IsDemacrofied() const
+{
+    return demacrofied;
+}
+
+bool FileSession::HasError() const
+{
+    return error != nullptr;
+}
+
+void FileSession::RethrowError() const
+{
+    if(error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+std::string FileSession::GetLog() const
+{
+    return logStream.str();
+}
+
+std::string FileSession::GetStat() const
+{
+    return statStream.str();
+}
+
+std::size_t FileSession::GetMacroCount() const
+{
+    return macroCount;
+}
+
+std::size_t FileSession::GetFunctionLikeCount() const
+{
+    return functionLikeCount;
+}
+
+std::size_t FileSession::GetObjectLikeCount() const
+{
+    return objectLikeCount;
+}
+
+const std::vector<MacroStat>& FileSession::GetMacroStats() const
+{
+    return macroStats;
+}
+
+bool FileSession::IsClangParsed() const
+{
+    return clangParsed;
+}
+
+bool FileSession::IsClangSkipped() const
+{
+    return clangSkipped;
+}
+
+bool FileSession::UsedPrefixPCH() const
+{
+    return usedPrefixPCH;
+}
+
+std::size_t FileSession::GetSourceBytes() const
+{
+    return source.GetContents().size();
+}
+
+std::size_t FileSession::GetSkippedSourceBytes() const
+{
+    return skippedSourceBytes;
+}
+
+std::size_t FileSession::GetAnalysisArenaBytes() const
+{
+    return analysisArenaBytes;
+}
+
+std::chrono::nanoseconds FileSession::GetClangTime() const
+{
+    return clangTime;
+}
+
+std::chrono::nanoseconds FileSession::GetPreScanTime() const
+{
+    return preScanTime;
+}
+
+const ScopeAgreement& FileSession::GetScopeAgreement() const
+{
+    return scopeAgreement;
+}
+
+void FileSession::WriteOutputFile(std::ostream& os) const
+{
+    demacrofiedPlan.Write(os, source.GetContents());
+}
+
+bool FileSession::WriteOutputFile(const std::filesystem::path& output_file) const
+{
+    return demacrofiedPlan.WriteFile(output_file, source.GetContents());
+}
+
+void FileSession::GenerateExternalASTHandler()
+{
+    /// generally the function definitions are not in header files. This has been done to make things faster and minimize
+    /// clang errors. As there are cases where header files are not self contained e.g. poco-1.4.3p1/XML$ vi src/xmlrole.h
+    ///
+    if(general_utilities::isHeaderFile(fileName.string()))
+    {
+        return;
+    }
+
+    /// without a front end the parser classifies the scopes from the tokens,
+    /// the parser reports the files which couldn't be opened
+    if(frontEnd == nullptr || !source.IsOpen())
+    {
+        return;
+    }
+
+    /// the clang information is only needed for some of the macros,
+    /// find out if this file has any of them before paying for the front end
+    const auto scan_start = std::chrono::steady_clock::now();
+
+    const PreScanResult pre_scan =
+            PreScanMacros(source.GetContents(), source.GetPosition(),
+                    ParseLexerBackend(demacroficationScheme.lexerBackend));
+
+    const auto clang_start = std::chrono::steady_clock::now();
+    preScanTime = clang_start - scan_start;
+
+    if(!pre_scan.needsClang)
+    {
+        clangSkipped = true;
+        return;
+    }
+
+    ASTMacroStat = frontEnd->ParseFile(fileName.string(), source.GetContents());
+    clangTime = std::chrono::steady_clock::now() - clang_start;
+    clangParsed = true;
+    usedPrefixPCH = frontEnd->UsedPrefixPCH();
+}
+
+void FileSession::RunParser()
+{
+    /// the classifier provides the scopes without a front end, with one it is
+    /// only compared against clang. Without the classifier the parser lexes
+    /// only the relevant spans of the file.
+    if(frontEnd == nullptr || clangParsed)
+    {
+        pParser->SetScopeClassifier(&scopeClassifier);
+    }
+
+    /// pass the data collected from clang front end
+    pParser->Parse(fileName, source, &ASTMacroStat, nullptr);
+    parsed = true;
+
+    if(clangParsed)
+    {
+        scopeAgreement = CompareScopeClassification(ASTMacroStat, lexerMacroStat);
+    }
+}
+
+void FileSession::RunDemacrofier()
+{
+    pParser->Demacrofy(statStream, demacroficationScheme.multipleDefinitions);
+
+    // the source is kept by the session, so only the edits are kept
+    demacrofiedPlan = pParser->TakeSplicePlan();
+    demacrofied = true;
+}
+
+void FileSession::RunDependencyAnalyzer()
+{
+    pParser->PPAnalyzeMacroDependency(logStream);
+}
+
+void FileSession::ReleaseParser()
+{
+    if(parsed)
+    {
+        macroCount = pParser->GetMacroCount();
+        functionLikeCount = pParser->GetFunctionLikeCount();
+        objectLikeCount = pParser->GetObjectLikeCount();
+        macroStats = pParser->GetMacroStats();
+        skippedSourceBytes = pParser->GetSkippedSourceBytes();
+    }
+    analysisArenaBytes = analysisArena.GetAllocatedBytes();
+
+    // the tree of the file is released in one go, the session is kept
+    // until it is merged only for its results
+    pParser.reset();
+    analysisArena.Release();
+    source.ReleaseLineIndex();
+}
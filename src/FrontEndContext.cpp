@@ -0,0 +1,275 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+          
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "clang_interface/FrontEndContext.hpp"
+
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/FrontendOptions.h"
+#include "clang/Lex/PreprocessorOptions.h"
+
+#include <fmt/ostream.h>
+
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+/// returns the headers of the include directives at the start of the file,
+/// at most max_count of them, with true for the ones included with <>.
+/// Blank lines and comments are skipped, anything else ends the list.
+std::vector<std::pair<std::string, bool>> LeadingIncludes(std::string_view contents, std::size_t max_count)
+{
+    std::vector<std::pair<std::string, bool>> includes;
+    bool in_comment = false;
+
+    auto skip_space = [](std::string_view& sv) {
+        const auto pos = sv.find_first_not_of(" \t\r");
+        sv.remove_prefix(pos == std::string_view::npos ? sv.size() : pos);
+    };
+
+    while(includes.size() < max_count && !contents.empty())
+    {
+        const auto line_end = contents.find('\n');
+        std::string_view rest = contents.substr(0, line_end);
+        contents.remove_prefix(line_end == std::string_view::npos ? contents.size() : line_end + 1);
+
+        while(true)
+        {
+            skip_space(rest);
+            if(in_comment)
+            {
+                const auto end = rest.find("*/");
+                if(end == std::string_view::npos)
+                {
+                    rest = {};
+                    break;
+                }
+                rest.remove_prefix(end + 2);
+                in_comment = false;
+            }
+            else if(rest.substr(0, 2) == "/*")
+            {
+                rest.remove_prefix(2);
+                in_comment = true;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if(rest.empty() || rest.substr(0, 2) == "//")
+        {
+            continue;
+        }
+
+        if(rest.front() != '#')
+        {
+            break;
+        }
+        rest.remove_prefix(1);
+        skip_space(rest);
+
+        if(rest.substr(0, 7) != "include")
+        {
+            break;
+        }
+        rest.remove_prefix(7);
+        skip_space(rest);
+
+        const bool angled = !rest.empty() && rest.front() == '<';
+        if(rest.empty() || (!angled && rest.front() != '"'))
+        {
+            break;
+        }
+
+        const auto end = rest.find(angled ? '>' : '"', 1);
+        if(end == std::string_view::npos)
+        {
+            break;
+        }
+        includes.emplace_back(std::string(rest.substr(1, end - 1)), angled);
+    }
+
+    return includes;
+}
+
+/// finds the included file the way the preprocessor does for the
+/// directories it knows about: the directory of the includer for the
+/// quoted includes, then the search paths
+std::optional<fs::path> ResolveInclude(const std::string& header, bool angled,
+        const fs::path& includer_dir, const std::vector<fs::path>& search_paths)
+{
+    std::error_code ec;
+
+    if(!angled && fs::exists(includer_dir / header, ec))
+    {
+        return fs::weakly_canonical(includer_dir / header, ec);
+    }
+
+    for(const auto& search_path : search_paths)
+    {
+        if(fs::exists(search_path / header, ec))
+        {
+            return fs::weakly_canonical(search_path / header, ec);
+        }
+    }
+
+    return std::nullopt;
+}
+} // namespace
+
+bool BuildPrefixPCH(const std::vector<fs::path>& search_paths, PrefixPCH const& prefix_pch)
+{
+    {
+        std::ofstream prefix(prefix_pch.prefixFile);
+        for(std::size_t i = 0; i < prefix_pch.headers.size(); ++i)
+        {
+            if(prefix_pch.isSystemHeader[i])
+            {
+                fmt::print(prefix, "#include <{}>\n", prefix_pch.headers[i].generic_string());
+            }
+            else
+            {
+                fmt::print(prefix, "#include \"{}\"\n", prefix_pch.headers[i].generic_string());
+            }
+        }
+    }
+
+    // the same options as for the translation units, otherwise clang
+    // rejects the PCH when loading it
+    clang::CompilerInstance pch_ci(std::make_shared<clang::PCHContainerOperations>(), nullptr);
+    MyASTConsumer ast_consumer;
+    ast_consumer.InitializeCI(pch_ci, search_paths);
+
+    // the action creates its target from the invocation
+    pch_ci.getTargetOpts().Triple = pch_ci.getTarget().getTriple().str();
+
+    clang::FrontendOptions& FEOpts = pch_ci.getFrontendOpts();
+    FEOpts.Inputs.clear();
+    FEOpts.Inputs.emplace_back(prefix_pch.prefixFile.string(), clang::InputKind(clang::Language::CXX));
+    FEOpts.OutputFile = prefix_pch.pchFile.string();
+    FEOpts.ProgramAction = clang::frontend::GeneratePCH;
+
+    clang::GeneratePCHAction action;
+    return pch_ci.ExecuteAction(action) && !pch_ci.getDiagnostics().hasErrorOccurred();
+}
+
+ClangPredefinedMacros::ClangPredefinedMacros()
+        : ci(std::make_shared<clang::PCHContainerOperations>(), nullptr)
+{
+    astConsumer.InitializeCI(ci, {});
+}
+
+std::string ClangPredefinedMacros::GetConfiguration() const
+{
+    return astConsumer.GetConfiguration();
+}
+
+std::string ClangPredefinedMacros::GetDefines()
+{
+    return astConsumer.GetPredefines();
+}
+
+FrontEndContext::FrontEndContext(const std::vector<fs::path>& search_paths, FrontEndMode mode,
+        PrefixPCH const* prefix_pch)
+        : ci(std::make_shared<clang::PCHContainerOperations>(), nullptr),
+          frontEndMode(mode),
+          searchPaths(search_paths),
+          prefixPCH(prefix_pch)
+{
+    astConsumer.InitializeCI(ci, search_paths);
+}
+
+ASTMacroStat_t FrontEndContext::ParseFile(const std::string& file_name, std::string_view contents)
+{
+    // picked up by MyASTConsumer when it sets up the translation unit
+    usedPrefixPCH = prefixPCH != nullptr && StartsWithPrefixHeaders(file_name, contents);
+    ci.getPreprocessorOpts().ImplicitPCHInclude = usedPrefixPCH ? prefixPCH->pchFile.string() : std::string();
+
+    if(frontEndMode == FrontEndMode::preprocessor)
+    {
+        astConsumer.PreprocessContent(file_name, contents);
+    }
+    else
+    {
+        astConsumer.DumpContent(file_name, contents);
+    }
+    ++parsedFileCount;
+
+    astConsumer.VerifyMacroScope(true);
+    return astConsumer.GetMacroStat();
+}
+
+std::size_t FrontEndContext::GetParsedFileCount() const
+{
+    return parsedFileCount;
+}
+
+bool FrontEndContext::UsedPrefixPCH() const
+{
+    return usedPrefixPCH;
+}
+
+bool FrontEndContext::StartsWithPrefixHeaders(const std::string& file_name, std::string_view contents) const
+{
+    const auto& headers = prefixPCH->headers;
+    const auto includes = LeadingIncludes(contents, headers.size());
+
+    if(includes.size() != headers.size())
+    {
+        return false;
+    }
+
+    const fs::path includer_dir = fs::path(file_name).parent_path();
+
+    for(std::size_t i = 0; i < headers.size(); ++i)
+    {
+        const auto& [header, angled] = includes[i];
+
+        if(prefixPCH->isSystemHeader[i])
+        {
+            if(!angled || header != headers[i].generic_string())
+            {
+                return false;
+            }
+            continue;
+        }
+
+        const auto resolved = ResolveInclude(header, angled, includer_dir, searchPaths);
+        if(!resolved || *resolved != headers[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,1009 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/HandWrittenLexer.h"
+
+#include "slex/cpp_slex_keywords.hpp"
+
+#include <boost/wave/cpplexer/convert_trigraphs.hpp>
+#include <boost/wave/cpplexer/cpplexer_exceptions.hpp>
+#include <boost/wave/cpplexer/validate_universal_char.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace
+{
+using boost::wave::token_id;
+
+bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool IsOctalDigit(char c)
+{
+    return c >= '0' && c <= '7';
+}
+
+bool IsHexDigit(char c)
+{
+    return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+/// letters, digits and underscore (NONDIGIT and DIGIT of the pp-number)
+bool IsAlnum(char c)
+{
+    return IsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr std::array<bool, 256> MakeIdentTable()
+{
+    std::array<bool, 256> table{};
+    for(int c = 0; c < 256; ++c)
+    {
+        table[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                   || c == '_';
+    }
+#if BOOST_WAVE_USE_STRICT_LEXER == 0
+    table['$'] = true;
+#endif
+    return table;
+}
+
+constexpr std::array<bool, 256> identTable = MakeIdentTable();
+
+bool IsIdentChar(char c)
+{
+    return identTable[static_cast<unsigned char>(c)];
+}
+
+bool At(char const* p, char const* last, std::string_view s)
+{
+    return static_cast<std::size_t>(last - p) >= s.size() && std::equal(s.begin(), s.end(), p);
+}
+
+/// @brief a backslash or the ??/ trigraph, returns its end or nullptr
+char const* MatchBackslash(char const* p, char const* last)
+{
+    if(p != last && *p == '\\')
+    {
+        return p + 1;
+    }
+    return At(p, last, "?\?/") ? p + 3 : nullptr;
+}
+
+/// @brief \\u and four or \\U and eight hex digits
+char const* MatchUniversalChar(char const* p, char const* last)
+{
+    p = MatchBackslash(p, last);
+    if(p == nullptr || p == last || (*p != 'u' && *p != 'U'))
+    {
+        return nullptr;
+    }
+    const std::ptrdiff_t digits = *p++ == 'u' ? 4 : 8;
+    if(last - p < digits || !std::all_of(p, p + digits, IsHexDigit))
+    {
+        return nullptr;
+    }
+    return p + digits;
+}
+
+char const* MatchIdentifier(char const* p, char const* last)
+{
+    while(true)
+    {
+        while(p != last && IsIdentChar(*p))
+        {
+            ++p;
+        }
+        if(p == last || (*p != '\\' && *p != '?'))
+        {
+            return p;
+        }
+        char const* const q = MatchUniversalChar(p, last);
+        if(q == nullptr)
+        {
+            return p;
+        }
+        p = q;
+    }
+}
+
+/// @brief a c comment from the /* at p, nullptr when it is not closed
+char const* MatchCComment(char const* p, char const* last)
+{
+    const std::string_view rest(p + 2, last - p - 2);
+    const auto close = rest.find("*/");
+    return close == std::string_view::npos ? nullptr : p + 2 + close + 2;
+}
+
+/// @brief a c++ comment from the // at p including the newline, nullptr
+/// when the file ends before a newline
+char const* MatchCppComment(char const* p, char const* last)
+{
+    p = std::find_if(p + 2, last, [](char c) { return c == '\n' || c == '\r'; });
+    if(p == last)
+    {
+        return nullptr;
+    }
+    return (*p == '\r' && p + 1 != last && p[1] == '\n') ? p + 2 : p + 1;
+}
+
+/// @brief blanks and c comments between the # and the directive name
+char const* MatchPpSpace(char const* p, char const* last)
+{
+    while(p != last)
+    {
+        if(*p == ' ' || *p == '\t')
+        {
+            ++p;
+        }
+        else if(At(p, last, "/*"))
+        {
+            char const* const q = MatchCComment(p, last);
+            if(q == nullptr)
+            {
+                break;
+            }
+            p = q;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return p;
+}
+
+/// @brief [eE][-+]?[0-9]+
+char const* MatchExponent(char const* p, char const* last)
+{
+    if(p == last || (*p != 'e' && *p != 'E'))
+    {
+        return nullptr;
+    }
+    if(++p != last && (*p == '-' || *p == '+'))
+    {
+        ++p;
+    }
+    char const* const digits = p;
+    while(p != last && IsDigit(*p))
+    {
+        ++p;
+    }
+    return p == digits ? nullptr : p;
+}
+
+/// @brief [fF][lL]? or [lL][fF]?
+char const* MatchFloatSuffix(char const* p, char const* last)
+{
+    auto is = [last](char const* q, char c) { return q != last && (*q == c || *q == c - 'a' + 'A'); };
+    if(is(p, 'f'))
+    {
+        return is(p + 1, 'l') ? p + 2 : p + 1;
+    }
+    if(is(p, 'l'))
+    {
+        return is(p + 1, 'f') ? p + 2 : p + 1;
+    }
+    return p;
+}
+
+/// @brief MatchQuoted for a literal with a ??/, which may be a backslash
+/// or three characters: the literal is matched as the set of states the
+/// slex dfa can be in
+char const* MatchQuotedTrigraphs(char const* p, char const* last, char quote, bool raw, bool non_empty)
+{
+    // the states: no character yet, after a character, after a backslash,
+    // after \x and waiting for the k-th last hex digit of \u or \U
+    enum : unsigned
+    {
+        first = 1u << 0,
+        normal = 1u << 1,
+        escape = 1u << 2,
+        hex = 1u << 3
+    };
+    auto universal = [](int k) { return 1u << (3 + k); };
+
+    // the states at the next 4 positions, ??/ moves 3 positions at once
+    std::array<unsigned, 4> states{};
+    states[1 % 4] = non_empty ? first : normal;
+    char const* accepted = nullptr;
+    unsigned pending = 1;
+
+    for(char const* q = p + 1; q != last && pending != 0; ++q)
+    {
+        const std::size_t i = static_cast<std::size_t>(q - p);
+        const unsigned s = std::exchange(states[i % 4], 0u);
+        auto add = [&](std::size_t offset, unsigned state) {
+            if(q + offset <= last)
+            {
+                states[(i + offset) % 4] |= state;
+            }
+        };
+        const char c = *q;
+
+        if(s & (first | normal))
+        {
+            if(c == quote)
+            {
+                if(s & normal)
+                {
+                    accepted = q + 1;
+                }
+            }
+            else if(c == '\\')
+            {
+                add(1, escape);
+            }
+            else if(!raw && (c == '\n' || c == '\r'))
+            {
+            }
+            else
+            {
+                add(1, normal);
+                if(At(q, last, "?\?/"))
+                {
+                    add(3, escape);
+                }
+            }
+        }
+        if(s & escape)
+        {
+            switch(c)
+            {
+            case 'a': case 'b': case 'f': case 'n': case 'r': case 't': case 'v':
+            case '\'': case '"': case '\\':
+            case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+                add(1, normal);
+                break;
+            case '?':
+                add(1, normal);
+                if(At(q, last, "?\?/"))
+                {
+                    add(3, normal);
+                }
+                break;
+            case 'x':
+                add(1, hex);
+                break;
+            case 'u':
+                add(1, universal(4));
+                break;
+            case 'U':
+                add(1, universal(8));
+                break;
+            default:
+                break;
+            }
+        }
+        if(IsHexDigit(c))
+        {
+            if(s & hex)
+            {
+                add(1, normal);
+            }
+            for(int k = 1; k <= 8; ++k)
+            {
+                if(s & universal(k))
+                {
+                    add(1, k == 1 ? normal : universal(k - 1));
+                }
+            }
+        }
+
+        pending = states[0] | states[1] | states[2] | states[3];
+    }
+    return accepted;
+}
+
+/**
+ * @brief the quoted part of a character, string or raw string literal from
+ * the opening quote at p, the end of the longest match or nullptr.
+ * With a real backslash every escape sequence is unambiguous, so the
+ * first closing quote ends the literal.
+ */
+char const* MatchQuoted(char const* p, char const* last, char quote, bool raw, bool non_empty)
+{
+    char const* q = p + 1;
+    if(non_empty && q != last && *q == quote)
+    {
+        return nullptr;
+    }
+    while(q != last)
+    {
+        const char c = *q;
+        if(c == quote)
+        {
+            return q + 1;
+        }
+        if(c == '\\')
+        {
+            if(++q == last)
+            {
+                return nullptr;
+            }
+            switch(*q)
+            {
+            case 'a': case 'b': case 'f': case 'n': case 'r': case 't': case 'v':
+            case '?': case '\'': case '"': case '\\':
+            case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+                // the octal and hex digits which follow are ordinary characters
+                ++q;
+                break;
+            case 'x':
+                if(++q == last || !IsHexDigit(*q))
+                {
+                    return nullptr;
+                }
+                break;
+            case 'u':
+            case 'U':
+            {
+                const std::ptrdiff_t digits = *q++ == 'u' ? 4 : 8;
+                if(last - q < digits || !std::all_of(q, q + digits, IsHexDigit))
+                {
+                    return nullptr;
+                }
+                q += digits;
+                break;
+            }
+            default:
+                return nullptr;
+            }
+        }
+        else if(!raw && (c == '\n' || c == '\r'))
+        {
+            return nullptr;
+        }
+        else if(c == '?' && At(q, last, "?\?/"))
+        {
+            return MatchQuotedTrigraphs(p, last, quote, raw, non_empty);
+        }
+        else
+        {
+            ++q;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @struct Directive
+ */
+struct Directive
+{
+    std::string_view name;
+    token_id id;
+};
+
+constexpr Directive directives[] = {
+    { "define", boost::wave::T_PP_DEFINE },
+    { "if", boost::wave::T_PP_IF },
+    { "ifdef", boost::wave::T_PP_IFDEF },
+    { "ifndef", boost::wave::T_PP_IFNDEF },
+    { "else", boost::wave::T_PP_ELSE },
+    { "elif", boost::wave::T_PP_ELIF },
+    { "endif", boost::wave::T_PP_ENDIF },
+    { "error", boost::wave::T_PP_ERROR },
+    { "line", boost::wave::T_PP_LINE },
+    { "pragma", boost::wave::T_PP_PRAGMA },
+    { "undef", boost::wave::T_PP_UNDEF },
+    { "warning", boost::wave::T_PP_WARNING },
+#if BOOST_WAVE_SUPPORT_MS_EXTENSIONS != 0
+    { "region", boost::wave::T_MSEXT_PP_REGION },
+    { "endregion", boost::wave::T_MSEXT_PP_ENDREGION },
+#endif
+};
+
+/**
+ * @class HandWrittenLexer
+ * @brief the rules are those of the slex lexer (cpp_slex_lexer.hpp): the
+ * longest match wins, so e.g. #ifdefined is #ifdef followed by ined and a
+ * // comment at the end of a file without a newline is lexed as two
+ * divisions. The tokens are post processed like in slex_functor::get.
+ */
+class HandWrittenLexer : public lexer_interface
+{
+public:
+    HandWrittenLexer(char const* first, char const* last, position_type const& pos,
+            boost::wave::language_support language)
+            : cur(first),
+              last(last),
+              origin(first),
+              base(pos.indexed(first, last)),
+              language(language),
+              c99(boost::wave::need_c99(language)),
+#if BOOST_WAVE_SUPPORT_CPP0X != 0
+              cpp0x(boost::wave::need_cpp0x(language)),
+#endif
+              ppNumbers(boost::wave::need_prefer_pp_numbers(language))
+    {
+    }
+
+    token_type& get(token_type& result) override;
+
+    void set_position(position_type const& new_pos) override
+    {
+        // changes the file name and line number only, the rest of the input
+        // is indexed again from there
+        base = Position(cur).reindexed(new_pos.get_file(), new_pos.get_line(), cur, last);
+        origin = cur;
+    }
+
+#if BOOST_WAVE_SUPPORT_PRAGMA_ONCE != 0
+    // cpp2cxx does not ask for the include guards
+    bool has_include_guards(std::string&) const override
+    {
+        return false;
+    }
+#endif
+
+private:
+    /// @brief matches the token at cur, sets tokenEnd
+    token_id Match();
+
+    token_id MatchNumber(char const* p);
+    token_id MatchPound(char const* directive, token_id pound, char const* pound_pound);
+    token_id MatchLiteral(char const* p, char const* quote);
+
+    token_id Token(token_id id, char const* end)
+    {
+        tokenEnd = end;
+        return id;
+    }
+
+    /// @brief the position of p, an offset into the line index of base
+    position_type Position(char const* p) const
+    {
+        return base.at_offset(base.get_offset() + static_cast<std::uint32_t>(p - origin));
+    }
+
+    char const* cur;
+    char const* last;
+    char const* tokenEnd{ nullptr };
+    /// the input at the offset of base
+    char const* origin;
+    position_type base;
+    boost::wave::language_support language;
+    bool c99;
+    bool cpp0x{ false };
+    bool ppNumbers;
+    bool atEof{ false };
+};
+
+token_type& HandWrittenLexer::get(token_type& result)
+{
+    using namespace boost::wave;
+
+    while(!atEof)
+    {
+        if(cur == last)
+        {
+            atEof = true;
+            return result = token_type(T_EOF, token_type::string_type(), Position(cur));
+        }
+
+        token_id id = Match();
+        const position_type start = Position(cur);
+        token_type::string_type value(cur, tokenEnd);
+        cur = tokenEnd;
+
+        switch(id)
+        {
+        case T_IDENTIFIER:
+            id = cpplexer::slex::classify_identifier(value.data(), value.size(), language);
+            // only a universal character can be invalid, the position is
+            // resolved for the error message only
+            if(id == T_IDENTIFIER && !need_no_character_validation(language)
+                    && value.find('\\') != token_type::string_type::npos)
+            {
+                cpplexer::impl::validate_identifier_name(
+                        value, start.get_line(), start.get_column(), start.get_file());
+            }
+            break;
+
+        case T_CHARLIT:
+        case T_STRINGLIT:
+        case T_RAWSTRINGLIT:
+            if(need_convert_trigraphs(language))
+            {
+                value = cpplexer::impl::convert_trigraphs(value);
+            }
+            if(!need_no_character_validation(language)
+                    && value.find('\\') != token_type::string_type::npos)
+            {
+                cpplexer::impl::validate_literal(
+                        value, start.get_line(), start.get_column(), start.get_file());
+            }
+            break;
+
+        case T_LONGINTLIT:
+            if(!need_long_long(language))
+            {
+                BOOST_WAVE_LEXER_THROW(cpplexer::lexing_exception, invalid_long_long_literal, value,
+                        start.get_line(), start.get_column(), start.get_file().c_str());
+            }
+            break;
+
+        case T_PP_HHEADER:
+        case T_PP_QHEADER:
+        case T_PP_INCLUDE:
+#if BOOST_WAVE_SUPPORT_INCLUDE_NEXT != 0
+            if(value.compare(value.find("include"), 12, "include_next", 12) == 0)
+            {
+                id = token_id(static_cast<unsigned>(id) | AltTokenType);
+            }
+#endif
+            break;
+
+        case T_CONTLINE:
+            if(!need_emit_contnewlines(language))
+            {
+                continue;
+            }
+            break;
+
+        case T_OR_TRIGRAPH:
+        case T_XOR_TRIGRAPH:
+        case T_LEFTBRACE_TRIGRAPH:
+        case T_RIGHTBRACE_TRIGRAPH:
+        case T_LEFTBRACKET_TRIGRAPH:
+        case T_RIGHTBRACKET_TRIGRAPH:
+        case T_COMPL_TRIGRAPH:
+        case T_POUND_TRIGRAPH:
+        case T_ANY_TRIGRAPH:
+            if(need_convert_trigraphs(language))
+            {
+                value = cpplexer::impl::convert_trigraph(value);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        return result = token_type(id, value, start);
+    }
+    return result = token_type(); // T_EOI
+}
+
+token_id HandWrittenLexer::Match()
+{
+    using namespace boost::wave;
+
+    char const* const p = cur;
+    const auto next = [this, p](std::ptrdiff_t i) { return last - p > i ? p[i] : '\0'; };
+    const bool cpp = !c99;
+
+    switch(*p)
+    {
+    case ' ':
+    case '\t':
+    case '\v':
+    case '\f':
+        return Token(T_SPACE, std::find_if(p + 1, last, [](char c) {
+            return c != ' ' && c != '\t' && c != '\v' && c != '\f';
+        }));
+    case '\n':
+        return Token(T_NEWLINE, p + 1);
+    case '\r':
+        return Token(T_NEWLINE, next(1) == '\n' ? p + 2 : p + 1);
+
+    case '&':
+        if(next(1) == '&')
+            return Token(T_ANDAND, p + 2);
+        if(next(1) == '=')
+            return Token(T_ANDASSIGN, p + 2);
+        return Token(T_AND, p + 1);
+    case '|':
+        if(At(p + 1, last, "?\?!"))
+            return Token(T_OROR_TRIGRAPH, p + 4);
+        if(next(1) == '|')
+            return Token(T_OROR, p + 2);
+        if(next(1) == '=')
+            return Token(T_ORASSIGN, p + 2);
+        return Token(T_OR, p + 1);
+    case '^':
+        if(next(1) == '=')
+            return Token(T_XORASSIGN, p + 2);
+        return Token(T_XOR, p + 1);
+    case '=':
+        if(next(1) == '=')
+            return Token(T_EQUAL, p + 2);
+        return Token(T_ASSIGN, p + 1);
+    case '!':
+        if(next(1) == '=')
+            return Token(T_NOTEQUAL, p + 2);
+        return Token(T_NOT, p + 1);
+    case '+':
+        if(next(1) == '+')
+            return Token(T_PLUSPLUS, p + 2);
+        if(next(1) == '=')
+            return Token(T_PLUSASSIGN, p + 2);
+        return Token(T_PLUS, p + 1);
+    case '-':
+        if(next(1) == '>')
+        {
+            if(cpp && next(2) == '*')
+                return Token(T_ARROWSTAR, p + 3);
+            return Token(T_ARROW, p + 2);
+        }
+        if(next(1) == '-')
+            return Token(T_MINUSMINUS, p + 2);
+        if(next(1) == '=')
+            return Token(T_MINUSASSIGN, p + 2);
+        return Token(T_MINUS, p + 1);
+    case '*':
+        if(next(1) == '=')
+            return Token(T_STARASSIGN, p + 2);
+        return Token(T_STAR, p + 1);
+    case '<':
+        if(next(1) == '<')
+            return next(2) == '=' ? Token(T_SHIFTLEFTASSIGN, p + 3) : Token(T_SHIFTLEFT, p + 2);
+        if(next(1) == '=')
+            return Token(T_LESSEQUAL, p + 2);
+        if(next(1) == '%')
+            return Token(T_LEFTBRACE_ALT, p + 2);
+        if(next(1) == ':')
+            return Token(T_LEFTBRACKET_ALT, p + 2);
+        return Token(T_LESS, p + 1);
+    case '>':
+        if(next(1) == '>')
+            return next(2) == '=' ? Token(T_SHIFTRIGHTASSIGN, p + 3) : Token(T_SHIFTRIGHT, p + 2);
+        if(next(1) == '=')
+            return Token(T_GREATEREQUAL, p + 2);
+        return Token(T_GREATER, p + 1);
+    case ':':
+        if(cpp && next(1) == ':')
+            return Token(T_COLON_COLON, p + 2);
+        if(next(1) == '>')
+            return Token(T_RIGHTBRACKET_ALT, p + 2);
+        return Token(T_COLON, p + 1);
+    case '%':
+        if(next(1) == ':')
+            return MatchPound(p + 2, T_POUND_ALT, At(p + 2, last, "%:") ? p + 4 : nullptr);
+        if(next(1) == '=')
+            return Token(T_PERCENTASSIGN, p + 2);
+        if(next(1) == '>')
+            return Token(T_RIGHTBRACE_ALT, p + 2);
+        return Token(T_PERCENT, p + 1);
+    case '#':
+        return MatchPound(p + 1, T_POUND, next(1) == '#' ? p + 2 : nullptr);
+    case '.':
+        if(IsDigit(next(1)))
+            return MatchNumber(p);
+        if(next(1) == '.' && next(2) == '.')
+            return Token(T_ELLIPSIS, p + 3);
+        if(cpp && next(1) == '*')
+            return Token(T_DOTSTAR, p + 2);
+        return Token(T_DOT, p + 1);
+    case '/':
+        if(next(1) == '*')
+        {
+            if(char const* const end = MatchCComment(p, last))
+                return Token(T_CCOMMENT, end);
+        }
+        else if(next(1) == '/')
+        {
+            if(char const* const end = MatchCppComment(p, last))
+                return Token(T_CPPCOMMENT, end);
+        }
+        else if(next(1) == '=')
+        {
+            return Token(T_DIVIDEASSIGN, p + 2);
+        }
+        return Token(T_DIVIDE, p + 1);
+    case '?':
+        if(next(1) != '?')
+            return Token(T_QUESTION_MARK, p + 1);
+        switch(next(2))
+        {
+        case '=':
+            return MatchPound(p + 3, T_POUND_TRIGRAPH, At(p + 3, last, "?\?=") ? p + 6 : nullptr);
+        case '/':
+            if(char const* const end = MatchUniversalChar(p, last))
+                return Token(T_IDENTIFIER, MatchIdentifier(end, last));
+            return Token(T_ANY_TRIGRAPH, p + 3);
+        case '\'':
+            return next(3) == '=' ? Token(T_XORASSIGN_TRIGRAPH, p + 4) : Token(T_XOR_TRIGRAPH, p + 3);
+        case '!':
+            if(At(p + 3, last, "?\?!"))
+                return Token(T_OROR_TRIGRAPH, p + 6);
+            if(next(3) == '|')
+                return Token(T_OROR_TRIGRAPH, p + 4);
+            if(next(3) == '=')
+                return Token(T_ORASSIGN_TRIGRAPH, p + 4);
+            return Token(T_OR_TRIGRAPH, p + 3);
+        case '<':
+            return Token(T_LEFTBRACE_TRIGRAPH, p + 3);
+        case '>':
+            return Token(T_RIGHTBRACE_TRIGRAPH, p + 3);
+        case '(':
+            return Token(T_LEFTBRACKET_TRIGRAPH, p + 3);
+        case ')':
+            return Token(T_RIGHTBRACKET_TRIGRAPH, p + 3);
+        case '-':
+            return Token(T_COMPL_TRIGRAPH, p + 3);
+        default:
+            return Token(T_QUESTION_MARK, p + 1);
+        }
+    case '\\':
+        if(next(1) == '\n')
+            return Token(T_CONTLINE, p + 2);
+        if(char const* const end = MatchUniversalChar(p, last))
+            return Token(T_IDENTIFIER, MatchIdentifier(end, last));
+        return Token(T_ANY, p + 1);
+
+    case ',':
+        return Token(T_COMMA, p + 1);
+    case ';':
+        return Token(T_SEMICOLON, p + 1);
+    case '(':
+        return Token(T_LEFTPAREN, p + 1);
+    case ')':
+        return Token(T_RIGHTPAREN, p + 1);
+    case '[':
+        return Token(T_LEFTBRACKET, p + 1);
+    case ']':
+        return Token(T_RIGHTBRACKET, p + 1);
+    case '{':
+        return Token(T_LEFTBRACE, p + 1);
+    case '}':
+        return Token(T_RIGHTBRACE, p + 1);
+    case '~':
+        return Token(T_COMPL, p + 1);
+
+    case '\'':
+    case '"':
+        return MatchLiteral(p, p);
+
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return MatchNumber(p);
+
+    case 'L':
+        if(next(1) == '\'' || next(1) == '"' || (cpp0x && next(1) == 'R' && next(2) == '"'))
+            return MatchLiteral(p, p + 1);
+        break;
+    case 'R':
+        if(cpp0x && next(1) == '"')
+            return MatchLiteral(p, p + 1);
+        break;
+    case 'u':
+    case 'U':
+        if(cpp0x)
+        {
+            char const* q = p + 1;
+            if(*p == 'u' && next(1) == '8')
+                ++q;
+            if(q != last && *q == 'R' && q + 1 != last && q[1] == '"')
+                return MatchLiteral(p, q + 1);
+            if(q != last && (*q == '\'' || *q == '"'))
+                return MatchLiteral(p, q);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    if(IsIdentChar(*p))
+    {
+        return Token(T_IDENTIFIER, MatchIdentifier(p + 1, last));
+    }
+    return Token(T_ANY, p + 1);
+}
+
+/// the # (or %: or ??=) is followed by blanks and the name of a directive
+/// or it is the #, or the ## when pound_pound is set
+token_id HandWrittenLexer::MatchPound(char const* directive, token_id pound, char const* pound_pound)
+{
+    using namespace boost::wave;
+
+    if(pound_pound != nullptr)
+    {
+        return Token(token_id(pound == T_POUND         ? T_POUND_POUND
+                              : pound == T_POUND_ALT ? T_POUND_POUND_ALT
+                                                     : T_POUND_POUND_TRIGRAPH),
+                pound_pound);
+    }
+
+    char const* const name = MatchPpSpace(directive, last);
+    token_id id = pound;
+    char const* end = directive;
+
+    for(auto const& d : directives)
+    {
+        if(name + d.name.size() > end && At(name, last, d.name))
+        {
+            id = d.id;
+            end = name + d.name.size();
+        }
+    }
+
+    if(At(name, last, "include"))
+    {
+        char const* q = name + 7;
+#if BOOST_WAVE_SUPPORT_INCLUDE_NEXT != 0
+        if(At(q, last, "_next"))
+        {
+            q += 5;
+        }
+#endif
+        q = MatchPpSpace(q, last);
+        if(q != last && (*q == '"' || *q == '<'))
+        {
+            const char close = *q == '"' ? '"' : '>';
+            char const* const header_end = std::find_if(q + 1, last,
+                    [close](char c) { return c == close || c == '\n' || c == '\r'; });
+            if(header_end != last && *header_end == close && header_end != q + 1)
+            {
+                return Token(close == '"' ? T_PP_QHEADER : T_PP_HHEADER, header_end + 1);
+            }
+        }
+        return Token(T_PP_INCLUDE, q);
+    }
+    return Token(id, end);
+}
+
+/// [0-9] or .[0-9] starts a pp-number when they are preferred, an integer
+/// or floating literal otherwise, whichever is longer
+token_id HandWrittenLexer::MatchNumber(char const* p)
+{
+    using namespace boost::wave;
+
+    if(ppNumbers)
+    {
+        char const* q = *p == '.' ? p + 2 : p + 1;
+        while(q != last && (IsAlnum(*q) || *q == '.'))
+        {
+            if((*q == 'e' || *q == 'E') && q + 1 != last && (q[1] == '-' || q[1] == '+'))
+            {
+                ++q;
+            }
+            ++q;
+        }
+        return Token(T_PP_NUMBER, q);
+    }
+
+    // the floating literal
+    char const* float_end = nullptr;
+    char const* q = p;
+    while(q != last && IsDigit(*q))
+    {
+        ++q;
+    }
+    if(q != last && *q == '.')
+    {
+        char const* r = q + 1;
+        while(r != last && IsDigit(*r))
+        {
+            ++r;
+        }
+        if(q != p || r != q + 1)
+        {
+            if(char const* const e = MatchExponent(r, last))
+            {
+                r = e;
+            }
+            float_end = MatchFloatSuffix(r, last);
+        }
+    }
+    else if(char const* const e = MatchExponent(q, last); e != nullptr && q != p)
+    {
+        float_end = MatchFloatSuffix(e, last);
+    }
+
+    if(*p == '.')
+    {
+        return Token(T_FLOATLIT, float_end);
+    }
+
+    // the integer literal
+    if(*p == '0' && last - p > 2 && (p[1] == 'x' || p[1] == 'X') && IsHexDigit(p[2]))
+    {
+        q = p + 2;
+        while(q != last && IsHexDigit(*q))
+        {
+            ++q;
+        }
+    }
+    else
+    {
+        q = p + 1;
+        while(q != last && (*p == '0' ? IsOctalDigit(*q) : IsDigit(*q)))
+        {
+            ++q;
+        }
+    }
+
+    auto is = [this](char const* r, char c) { return r < last && (*r == c || *r == c - 'a' + 'A'); };
+    char const* int_end = q;
+    char const* long_end = nullptr;
+    if(is(q, 'u'))
+    {
+        int_end = is(q + 1, 'l') ? q + 2 : q + 1;
+        if(is(q + 1, 'l') && is(q + 2, 'l'))
+        {
+            long_end = q + 3;
+        }
+    }
+    else if(is(q, 'l'))
+    {
+        int_end = is(q + 1, 'u') ? q + 2 : q + 1;
+        if(is(q + 1, 'l'))
+        {
+            long_end = is(q + 2, 'u') ? q + 3 : q + 2;
+        }
+    }
+#if BOOST_WAVE_SUPPORT_MS_EXTENSIONS != 0
+    else if(At(q, last, "i64"))
+    {
+        long_end = q + 3;
+    }
+#endif
+
+    if(float_end != nullptr && float_end > int_end && (long_end == nullptr || float_end > long_end))
+    {
+        return Token(T_FLOATLIT, float_end);
+    }
+    if(long_end != nullptr && long_end > int_end)
+    {
+        return Token(T_LONGINTLIT, long_end);
+    }
+    return Token(T_INTLIT, int_end);
+}
+
+/// a character, string or raw string literal with the prefix [p, quote),
+/// a prefix without a literal is an identifier and a quote alone is T_ANY
+token_id HandWrittenLexer::MatchLiteral(char const* p, char const* quote)
+{
+    using namespace boost::wave;
+
+    const bool raw = quote != p && quote[-1] == 'R';
+    if(char const* const end = MatchQuoted(quote, last, *quote, raw, *quote == '\'' && !raw))
+    {
+        if(raw)
+        {
+            return Token(T_RAWSTRINGLIT, end);
+        }
+        return Token(*quote == '\'' ? T_CHARLIT : T_STRINGLIT, end);
+    }
+    if(quote == p)
+    {
+        return Token(T_ANY, p + 1);
+    }
+    return Token(T_IDENTIFIER, MatchIdentifier(p + 1, last));
+}
+} // namespace
+
+lexer_interface* NewHandWrittenLexer(char const* first, char const* last, position_type const& pos,
+        boost::wave::language_support language)
+{
+    return new HandWrittenLexer(first, last, pos, language);
+}
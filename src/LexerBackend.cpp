@@ -0,0 +1,213 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/LexerBackend.h"
+
+#include "cpp2cxx/ExceptionHandler.h"
+#include "cpp2cxx/HandWrittenLexer.h"
+
+#include <boost/wave/cpplexer/cpp_lex_interface_generator.hpp>
+#include <boost/wave/cpplexer/cpp_lex_token.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+/// @brief the length of the text at the start of rest which is value, a
+/// newline of value may be a "\r\n" there; npos when it is not value
+std::size_t MatchedLength(std::string_view rest, std::string_view value)
+{
+    std::size_t i = 0;
+    for(const char c : value)
+    {
+        if(c == '\n' && rest.compare(i, 2, "\r\n") == 0)
+        {
+            i += 2;
+            continue;
+        }
+        if(i == rest.size() || rest[i] != c)
+        {
+            return std::string_view::npos;
+        }
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * @class WaveLexer
+ * @brief the stock Wave (re2c) lexer, its tokens are converted to token_type
+ * and located by their offsets into the input, so the columns of the tokens
+ * count the tabs like the other lexers and the SplicePlan can cut the input
+ * at them
+ */
+class WaveLexer : public lexer_interface
+{
+    using wave_token_type = boost::wave::cpplexer::lex_token<>;
+    using wave_position_type = wave_token_type::position_type;
+    using wave_lexer_type = boost::wave::cpplexer::lex_input_interface<wave_token_type>;
+
+public:
+    WaveLexer(char const* first, char const* last, position_type const& pos,
+            boost::wave::language_support language)
+            : origin(first),
+              last(last),
+              base(pos.indexed(first, last)),
+              next(base),
+              lexer(boost::wave::cpplexer::new_lexer_gen<char const*>::new_lexer(first, last,
+                      wave_position_type(base.get_file(), base.get_line(), base.get_column()), language))
+    {
+    }
+
+    token_type& get(token_type& result) override
+    {
+        wave_token_type token;
+        lexer->get(token);
+
+        const auto id = boost::wave::token_id(token);
+        if(id == boost::wave::T_EOI)
+        {
+            return result = token_type();
+        }
+        const auto [offset, length] = Locate(token);
+        result = token_type(id, token.get_value(), base.at_offset(offset));
+        next = base.at_offset(offset + length);
+        return result;
+    }
+
+    // the rest of the input is indexed again from the end of the last token
+    void set_position(position_type const& new_pos) override
+    {
+        char const* const first = origin + (next.get_offset() - base.get_offset());
+        const std::size_t column = next.get_column();
+        base = next.reindexed(new_pos.get_file(), new_pos.get_line(), first, last);
+        next = base;
+        origin = first;
+        lexer->set_position(wave_position_type(new_pos.get_file(), new_pos.get_line(), column));
+    }
+
+#if BOOST_WAVE_SUPPORT_PRAGMA_ONCE != 0
+    bool has_include_guards(std::string& guard_name) const override
+    {
+        return lexer->has_include_guards(guard_name);
+    }
+#endif
+
+private:
+    /// @brief the offset and the length in the input of the token. Its value
+    /// is the text of the input (a newline may be a "\r\n" there) and starts
+    /// at the end of the last token, or after the backslash newlines Wave did
+    /// not return as T_CONTLINE. The lines and columns of Wave don't count the
+    /// bytes of those, they are only used when the value is not found.
+    std::pair<std::uint32_t, std::uint32_t> Locate(wave_token_type const& token) const
+    {
+        const auto from = static_cast<std::size_t>(next.get_offset() - base.get_offset());
+        const std::string_view rest(origin + from, static_cast<std::size_t>(last - origin) - from);
+        const std::string_view value(token.get_value().c_str(), token.get_value().size());
+
+        std::size_t at = 0;
+        while(true)
+        {
+            if(const std::size_t length = MatchedLength(rest.substr(at), value); length != std::string_view::npos)
+            {
+                return { next.get_offset() + static_cast<std::uint32_t>(at), static_cast<std::uint32_t>(length) };
+            }
+
+            if(rest.compare(at, 2, "\\\n") == 0)
+            {
+                at += 2;
+            }
+            else if(rest.compare(at, 3, "\\\r\n") == 0)
+            {
+                at += 3;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        const position_type pos =
+                base.at_line_column(token.get_position().get_line(), token.get_position().get_column());
+        return { pos.get_offset(), static_cast<std::uint32_t>(value.size()) };
+    }
+
+    /// the input at the offset of base
+    char const* origin;
+    char const* last;
+    position_type base;
+    /// the end of the last token
+    position_type next;
+    std::unique_ptr<wave_lexer_type> lexer;
+};
+} // namespace
+
+LexerBackend ParseLexerBackend(std::string const& name)
+{
+    if(name == "slex")
+    {
+        return LexerBackend::slex;
+    }
+    if(name == "slex-classes")
+    {
+        return LexerBackend::slexByteClasses;
+    }
+    if(name == "hand")
+    {
+        return LexerBackend::handWritten;
+    }
+    if(name == "wave")
+    {
+        return LexerBackend::wave;
+    }
+    throw ExceptionHandler("unknown lexer: " + name + ", expected slex, slex-classes, hand or wave\n");
+}
+
+lexer_interface* NewLexer(LexerBackend backend, char const* first, char const* last,
+        position_type const& pos, boost::wave::language_support language)
+{
+    switch(backend)
+    {
+    case LexerBackend::slexByteClasses:
+        return boost::wave::cpplexer::slex::new_lexer_gen<char const*>::new_lexer(
+                first, last, pos, language, boost::spirit::classic::dfa_layout::byte_classes);
+    case LexerBackend::handWritten:
+        return NewHandWrittenLexer(first, last, pos, language);
+    case LexerBackend::wave:
+        return new WaveLexer(first, last, pos, language);
+    case LexerBackend::slex:
+    default:
+        return boost::wave::cpplexer::slex::new_lexer_gen<char const*>::new_lexer(
+                first, last, pos, language);
+    }
+}
+
+lexer_iterator MakeLexerIterator(LexerBackend backend, std::string_view contents,
+        position_type const& pos, boost::wave::language_support language)
+{
+    return lexer_iterator(
+            NewLexer(backend, contents.data(), contents.data() + contents.size(), pos, language));
+}
@@ -0,0 +1,222 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/LexerScopeClassifier.h"
+
+#include <algorithm>
+#include <set>
+
+namespace
+{
+bool IsLeftBrace(boost::wave::token_id id)
+{
+    return id == boost::wave::T_LEFTBRACE || id == boost::wave::T_LEFTBRACE_ALT
+           || id == boost::wave::T_LEFTBRACE_TRIGRAPH;
+}
+
+bool IsRightBrace(boost::wave::token_id id)
+{
+    return id == boost::wave::T_RIGHTBRACE || id == boost::wave::T_RIGHTBRACE_ALT
+           || id == boost::wave::T_RIGHTBRACE_TRIGRAPH;
+}
+} // namespace
+
+LexerScopeClassifier::LexerScopeClassifier(ASTMacroStat_t& macro_stat)
+        : macroStat(macro_stat)
+{
+}
+
+void LexerScopeClassifier::PutToken(token_type const& tok)
+{
+    using namespace boost::wave;
+
+    const auto id = token_id(tok);
+
+    if(insideFunction)
+    {
+        if(IsLeftBrace(id))
+        {
+            braces.push_back(BraceKind::block);
+        }
+        else if(IsRightBrace(id))
+        {
+            if(braces.back() == BraceKind::function)
+            {
+                insideFunction = false;
+            }
+            braces.pop_back();
+        }
+        return;
+    }
+
+    switch(id)
+    {
+    case T_LEFTPAREN:
+        ++parenDepth;
+        return;
+    case T_RIGHTPAREN:
+        if(parenDepth > 0 && --parenDepth == 0)
+        {
+            afterParen = true;
+        }
+        return;
+    default:
+        break;
+    }
+
+    if(parenDepth > 0)
+    {
+        return;
+    }
+
+    switch(id)
+    {
+    case T_CLASS:
+    case T_STRUCT:
+    case T_UNION:
+        classHead = true;
+        scopeHead = true;
+        break;
+    case T_NAMESPACE:
+    case T_ENUM:
+    case T_EXTERN:
+        scopeHead = true;
+        break;
+    case T_LEFTBRACE:
+    case T_LEFTBRACE_ALT:
+    case T_LEFTBRACE_TRIGRAPH:
+        // checked first, the head of a function may also contain
+        // a class-key e.g. struct S* f() {
+        if(afterParen)
+        {
+            braces.push_back(BraceKind::function);
+            insideFunction = true;
+        }
+        else if(classHead)
+        {
+            braces.push_back(BraceKind::class_scope);
+        }
+        else if(scopeHead)
+        {
+            braces.push_back(BraceKind::scope);
+        }
+        else
+        {
+            // e.g. brace initialization of a variable
+            braces.push_back(BraceKind::block);
+        }
+        afterParen = false;
+        scopeHead = false;
+        classHead = false;
+        break;
+    case T_RIGHTBRACE:
+    case T_RIGHTBRACE_ALT:
+    case T_RIGHTBRACE_TRIGRAPH:
+        if(!braces.empty())
+        {
+            braces.pop_back();
+        }
+        [[fallthrough]];
+    case T_SEMICOLON:
+    case T_ASSIGN:
+        afterParen = false;
+        scopeHead = false;
+        classHead = false;
+        break;
+    default:
+        break;
+    }
+}
+
+void LexerScopeClassifier::MacroDefined(token_type const& identifier)
+{
+    CollectedMacroInfo cmi;
+    cmi.defined_line = identifier.get_position().get_line();
+    cmi.op = PPOperation::define;
+    cmi.s_cat = GetCurrentScope();
+    macroStat[identifier.get_value()] = cmi;
+}
+
+void LexerScopeClassifier::MacroInvoked(token_type const& identifier)
+{
+    macroStat[identifier.get_value()].invoked_lines.push_back(identifier.get_position().get_line());
+}
+
+MacroScopeCategory LexerScopeClassifier::GetCurrentScope() const
+{
+    if(insideFunction)
+    {
+        return MacroScopeCategory::inside_function;
+    }
+
+    if(!braces.empty() && braces.back() == BraceKind::class_scope)
+    {
+        return MacroScopeCategory::inside_class;
+    }
+
+    return MacroScopeCategory::local;
+}
+
+ScopeAgreement& ScopeAgreement::operator+=(ScopeAgreement const& other)
+{
+    macros += other.macros;
+    scopeMatches += other.scopeMatches;
+    invocationMatches += other.invocationMatches;
+    return *this;
+}
+
+ScopeAgreement CompareScopeClassification(
+        ASTMacroStat_t const& clang_stat, ASTMacroStat_t const& lexer_stat)
+{
+    ScopeAgreement agreement;
+
+    for(auto&& [name, clang_info] : clang_stat)
+    {
+        ++agreement.macros;
+
+        const auto lexer_iter = lexer_stat.find(name);
+        if(lexer_iter == lexer_stat.end())
+        {
+            continue;
+        }
+
+        const auto& lexer_info = lexer_iter->second;
+        if((clang_info.s_cat == MacroScopeCategory::inside_function)
+                == (lexer_info.s_cat == MacroScopeCategory::inside_function))
+        {
+            ++agreement.scopeMatches;
+        }
+
+        // clang may report several expansions on the same line
+        const std::set<std::size_t> clang_lines(
+                clang_info.invoked_lines.begin(), clang_info.invoked_lines.end());
+        const std::set<std::size_t> lexer_lines(
+                lexer_info.invoked_lines.begin(), lexer_info.invoked_lines.end());
+        if(clang_lines == lexer_lines)
+        {
+            ++agreement.invocationMatches;
+        }
+    }
+
+    return agreement;
+}
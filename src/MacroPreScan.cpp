@@ -0,0 +1,164 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/MacroPreScan.h"
+
+#include <string>
+
+namespace
+{
+/// same categories which make the RlParser set the statement, assignment
+/// or braces type of a replacement list
+bool IsPostponedToken(boost::wave::token_id id)
+{
+    using namespace boost::wave;
+    switch(id)
+    {
+    case T_SEMICOLON:
+    case T_LEFTBRACE:
+    case T_LEFTBRACE_ALT:
+    case T_LEFTBRACE_TRIGRAPH:
+    case T_RIGHTBRACE:
+    case T_RIGHTBRACE_ALT:
+    case T_RIGHTBRACE_TRIGRAPH:
+    case T_ASSIGN:
+    case T_ANDASSIGN:
+    case T_ANDASSIGN_ALT:
+    case T_DIVIDEASSIGN:
+    case T_MINUSASSIGN:
+    case T_STARASSIGN:
+    case T_PERCENTASSIGN:
+    case T_PLUSASSIGN:
+    case T_ORASSIGN:
+    case T_ORASSIGN_ALT:
+    case T_ORASSIGN_TRIGRAPH:
+    case T_XOR_TRIGRAPH: // RlParser::Assignment takes ??' as an assignment
+    case T_XORASSIGN:
+    case T_XORASSIGN_ALT:
+    case T_XORASSIGN_TRIGRAPH:
+    case T_SHIFTLEFTASSIGN:
+    case T_SHIFTRIGHTASSIGN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool IsWhiteSpace(boost::wave::token_id id)
+{
+    return id == boost::wave::T_SPACE || id == boost::wave::T_SPACE2
+           || id == boost::wave::T_CCOMMENT;
+}
+} // namespace
+
+PreScanResult PreScanMacros(std::string_view file_str, position_type const& pos, LexerBackend backend)
+{
+    using namespace boost::wave;
+
+    PreScanResult result;
+    // brace nesting of the code outside the directives, a macro defined
+    // at a nesting level > 0 may be inside a function
+    int nesting_level = 0;
+
+    try
+    {
+        lexer_iterator it = MakeLexerIterator(backend, file_str, pos,
+                language_support(support_cpp | support_option_long_long
+                                 | support_option_emit_contnewlines));
+        const lexer_iterator it_end;
+
+        while(it != it_end)
+        {
+            switch(auto id = token_id(*it); id)
+            {
+            case T_LEFTBRACE:
+            case T_LEFTBRACE_ALT:
+            case T_LEFTBRACE_TRIGRAPH:
+                ++nesting_level;
+                break;
+            case T_RIGHTBRACE:
+            case T_RIGHTBRACE_ALT:
+            case T_RIGHTBRACE_TRIGRAPH:
+                // unbalanced braces (e.g. in #if/#else branches) make the
+                // nesting unreliable, leave the decision to clang
+                if(--nesting_level < 0)
+                {
+                    result.needsClang = true;
+                    return result;
+                }
+                break;
+            case T_PP_DEFINE:
+            {
+                ++result.defineCount;
+                if(nesting_level > 0)
+                {
+                    result.needsClang = true;
+                    return result;
+                }
+
+                //skip the spaces up to the identifier and then the identifier
+                do
+                {
+                    ++it;
+                } while(it != it_end && IsWhiteSpace(token_id(*it)));
+
+                if(it != it_end)
+                {
+                    ++it;
+                }
+
+                const bool function_like = it != it_end && token_id(*it) == T_LEFTPAREN;
+
+                for(; it != it_end; ++it)
+                {
+                    id = token_id(*it);
+                    if(id == T_NEWLINE || id == T_CPPCOMMENT)
+                    {
+                        break;
+                    }
+                    if(!function_like && IsPostponedToken(id))
+                    {
+                        result.needsClang = true;
+                        return result;
+                    }
+                }
+                // the newline (or the comment including it) ends the directive
+                break;
+            }
+            default:
+                break;
+            }
+
+            if(it != it_end)
+            {
+                ++it;
+            }
+        }
+    }
+    catch(boost::wave::cpplexer::lexing_exception const&)
+    {
+        result.needsClang = true;
+    }
+
+    return result;
+}
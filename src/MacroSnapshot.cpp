@@ -0,0 +1,361 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/MacroSnapshot.h"
+#include "cpp2cxx/ExceptionHandler.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+
+constexpr char snapshotMagic[8] = { 'c', 'p', 'p', '2', 'c', 'x', 'x', 'M' };
+constexpr std::uint32_t snapshotByteOrder = 0x01020304;
+constexpr std::uint32_t snapshotVersion = 1;
+
+/// @brief FNV-1a, the hashes are stored so they must not change between runs
+std::uint32_t HashName(std::string_view name)
+{
+    std::uint32_t hash = 2166136261u;
+    for(const char c : name)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/// @brief a power of two with at most half of the slots used
+std::uint32_t SlotCount(std::size_t entry_count)
+{
+    std::uint32_t slot_count = 1;
+    while(slot_count < 2 * entry_count)
+    {
+        slot_count <<= 1;
+    }
+    return slot_count;
+}
+
+} // namespace
+
+struct MacroSnapshot::Header
+{
+    char magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t slotCount;
+    std::uint32_t stringsSize;
+    std::uint32_t reserved;
+};
+
+struct MacroSnapshot::Entry
+{
+    std::uint32_t nameOffset;
+    std::uint32_t nameSize;
+    std::uint32_t replacementOffset;
+    std::uint32_t replacementSize;
+    std::uint32_t hash;
+};
+
+struct MacroSnapshot::Mapping
+{
+    explicit Mapping(const std::filesystem::path& snapshot_file)
+            : file(snapshot_file.string().c_str(), boost::interprocess::read_only),
+              region(file, boost::interprocess::read_only)
+    {
+    }
+
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+};
+
+namespace
+{
+
+/// @brief the bytes of the snapshot of the macros, in 8 byte words so
+/// that the entries and slots are aligned when used in place
+std::vector<std::uint64_t> Serialize(MacroList_t const& macros)
+{
+    constexpr std::size_t header_size = 8 * sizeof(std::uint32_t);
+    constexpr std::size_t entry_size = 5 * sizeof(std::uint32_t);
+
+    const std::size_t entry_count = macros.size();
+    const std::uint32_t slot_count = SlotCount(entry_count);
+    std::size_t strings_size = 0;
+    for(auto const& [name, replacement] : macros)
+    {
+        strings_size += name.size() + replacement.size();
+    }
+    if(strings_size > UINT32_MAX || entry_count > UINT32_MAX / 2)
+    {
+        throw ExceptionHandler("global macros are too large for a snapshot");
+    }
+
+    const std::size_t entries_offset = header_size;
+    const std::size_t slots_offset = entries_offset + entry_count * entry_size;
+    const std::size_t strings_offset = slots_offset + slot_count * sizeof(std::uint32_t);
+    const std::size_t total_size = strings_offset + strings_size;
+
+    std::vector<std::uint64_t> words((total_size + 7) / 8, 0);
+    char* bytes = reinterpret_cast<char*>(words.data());
+
+    auto put = [bytes](std::size_t offset, std::uint32_t value) {
+        std::memcpy(bytes + offset, &value, sizeof(value));
+    };
+
+    std::memcpy(bytes, snapshotMagic, sizeof(snapshotMagic));
+    put(8, snapshotByteOrder);
+    put(12, snapshotVersion);
+    put(16, static_cast<std::uint32_t>(entry_count));
+    put(20, slot_count);
+    put(24, static_cast<std::uint32_t>(strings_size));
+
+    // std::map iterates in sorted order, which is the order of the entries
+    std::uint32_t index = 0;
+    std::uint32_t string_offset = 0;
+    for(auto const& [name, replacement] : macros)
+    {
+        const std::uint32_t hash = HashName(name);
+        const std::size_t entry = entries_offset + index * entry_size;
+
+        put(entry, string_offset);
+        put(entry + 4, static_cast<std::uint32_t>(name.size()));
+        std::memcpy(bytes + strings_offset + string_offset, name.data(), name.size());
+        string_offset += static_cast<std::uint32_t>(name.size());
+
+        put(entry + 8, string_offset);
+        put(entry + 12, static_cast<std::uint32_t>(replacement.size()));
+        std::memcpy(bytes + strings_offset + string_offset, replacement.data(), replacement.size());
+        string_offset += static_cast<std::uint32_t>(replacement.size());
+
+        put(entry + 16, hash);
+
+        std::uint32_t slot = hash & (slot_count - 1);
+        for(std::uint32_t used; std::memcpy(&used, bytes + slots_offset + slot * 4, 4), used != 0;)
+        {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        put(slots_offset + slot * 4, index + 1);
+        ++index;
+    }
+
+    return words;
+}
+
+} // namespace
+
+std::shared_ptr<MacroSnapshot const> MacroSnapshot::Map(const std::filesystem::path& snapshot_file)
+{
+    std::shared_ptr<MacroSnapshot> snapshot(new MacroSnapshot);
+    try
+    {
+        snapshot->mapping = std::make_unique<Mapping>(snapshot_file);
+    }
+    catch(boost::interprocess::interprocess_exception& e)
+    {
+        throw ExceptionHandler("global macro snapshot: " + snapshot_file.string()
+                               + " could not be mapped: " + e.what());
+    }
+    snapshot->Attach(static_cast<char const*>(snapshot->mapping->region.get_address()),
+            snapshot->mapping->region.get_size());
+    return snapshot;
+}
+
+std::shared_ptr<MacroSnapshot const> MacroSnapshot::Build(MacroList_t const& macros)
+{
+    std::shared_ptr<MacroSnapshot> snapshot(new MacroSnapshot);
+    snapshot->ownedBytes = Serialize(macros);
+    snapshot->Attach(reinterpret_cast<char const*>(snapshot->ownedBytes.data()),
+            snapshot->ownedBytes.size() * sizeof(std::uint64_t));
+    return snapshot;
+}
+
+bool MacroSnapshot::Write(const std::filesystem::path& snapshot_file, MacroList_t const& macros)
+{
+    const auto words = Serialize(macros);
+
+    // written aside and renamed, so that another instance never maps
+    // a half written snapshot
+    std::filesystem::path temp_file = snapshot_file;
+    temp_file += ".tmp";
+    {
+        std::ofstream out(temp_file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if(!out.is_open())
+        {
+            return false;
+        }
+        out.write(reinterpret_cast<char const*>(words.data()),
+                static_cast<std::streamsize>(words.size() * sizeof(std::uint64_t)));
+        if(!out.good())
+        {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_file, snapshot_file, ec);
+    if(ec)
+    {
+        std::filesystem::remove(temp_file, ec);
+        return false;
+    }
+    return true;
+}
+
+bool MacroSnapshot::IsSnapshotFile(const std::filesystem::path& file_name)
+{
+    std::ifstream in(file_name, std::ios_base::in | std::ios_base::binary);
+    Header header{};
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    return std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) == 0
+           && header.byteOrder == snapshotByteOrder && header.version == snapshotVersion;
+}
+
+std::filesystem::path MacroSnapshot::GetCacheFile(const std::filesystem::path& macro_file)
+{
+    std::filesystem::path cache_file = macro_file;
+    return cache_file += ".snapshot";
+}
+
+bool MacroSnapshot::IsCacheFresh(const std::filesystem::path& cache_file,
+        const std::filesystem::path& macro_file)
+{
+    std::error_code ec;
+    const auto cache_time = std::filesystem::last_write_time(cache_file, ec);
+    if(ec)
+    {
+        return false;
+    }
+    const auto macro_time = std::filesystem::last_write_time(macro_file, ec);
+    return !ec && cache_time >= macro_time && IsSnapshotFile(cache_file);
+}
+
+MacroSnapshot::~MacroSnapshot() = default;
+
+void MacroSnapshot::Attach(char const* data, std::size_t size)
+{
+    static_assert(sizeof(Header) == 8 * sizeof(std::uint32_t), "layout written by Serialize");
+    static_assert(sizeof(Entry) == 5 * sizeof(std::uint32_t), "layout written by Serialize");
+
+    Header header{};
+    if(size < sizeof(header))
+    {
+        throw ExceptionHandler("global macro snapshot is truncated");
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if(std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0
+            || header.byteOrder != snapshotByteOrder || header.version != snapshotVersion)
+    {
+        throw ExceptionHandler("not a global macro snapshot of this version and byte order");
+    }
+    if(header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0
+            || header.slotCount < header.entryCount)
+    {
+        throw ExceptionHandler("global macro snapshot has a corrupt hash index");
+    }
+
+    const std::size_t entries_offset = sizeof(Header);
+    const std::size_t slots_offset = entries_offset + std::size_t{ header.entryCount } * sizeof(Entry);
+    const std::size_t strings_offset = slots_offset + std::size_t{ header.slotCount } * sizeof(std::uint32_t);
+    if(strings_offset + header.stringsSize > size)
+    {
+        throw ExceptionHandler("global macro snapshot is truncated");
+    }
+
+    entries = reinterpret_cast<Entry const*>(data + entries_offset);
+    entryCount = header.entryCount;
+    slots = reinterpret_cast<std::uint32_t const*>(data + slots_offset);
+    slotMask = header.slotCount - 1;
+    strings = data + strings_offset;
+    stringsSize = header.stringsSize;
+}
+
+std::string_view MacroSnapshot::GetString(std::uint32_t offset, std::uint32_t size) const
+{
+    // the entries are checked when used, not when the snapshot is mapped
+    if(std::size_t{ offset } + size > stringsSize)
+    {
+        throw ExceptionHandler("global macro snapshot has a corrupt entry");
+    }
+    return { strings + offset, size };
+}
+
+bool MacroSnapshot::Contains(std::string_view name) const
+{
+    return Find(name).has_value();
+}
+
+std::optional<std::string_view> MacroSnapshot::Find(std::string_view name) const
+{
+    const std::uint32_t hash = HashName(name);
+    for(std::uint32_t slot = hash & slotMask, probes = 0; probes <= slotMask;
+            slot = (slot + 1) & slotMask, ++probes)
+    {
+        const std::uint32_t index = slots[slot];
+        if(index == 0 || index > entryCount)
+        {
+            break;
+        }
+        Entry const& entry = entries[index - 1];
+        if(entry.hash == hash && GetString(entry.nameOffset, entry.nameSize) == name)
+        {
+            return GetString(entry.replacementOffset, entry.replacementSize);
+        }
+    }
+    return std::nullopt;
+}
+
+std::size_t MacroSnapshot::size() const
+{
+    return entryCount;
+}
+
+std::string_view MacroSnapshot::GetName(std::size_t index) const
+{
+    return GetString(entries[index].nameOffset, entries[index].nameSize);
+}
+
+std::string_view MacroSnapshot::GetReplacement(std::size_t index) const
+{
+    return GetString(entries[index].replacementOffset, entries[index].replacementSize);
+}
+
+MacroList_t MacroSnapshot::ToMacroList() const
+{
+    MacroList_t macros;
+    for(std::size_t index = 0; index < entryCount; ++index)
+    {
+        macros.emplace_hint(macros.end(), GetName(index), GetReplacement(index));
+    }
+    return macros;
+}
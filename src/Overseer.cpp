@@ -21,27 +21,52 @@ limitations under the License.
 */
 
 #include "cpp2cxx/Overseer.h"
-#include "cpp2cxx/DepGraph.h"
 #include "cpp2cxx/ExceptionHandler.h"
 #include "cpp2cxx/FileManager.h"
+#include "cpp2cxx/FileSession.h"
+#include "cpp2cxx/MacroStat.h"
 #include "cpp2cxx/Parser.h"
 
-#include "general_utilities/file_type.hpp"
+#include "clang_interface/FrontEndContext.hpp"
+
+#include "general_utilities/process_memory.hpp"
 
 #include <fmt/ostream.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 Overseer::Overseer(ConfigScheme&& config_scheme)
         : configScheme(config_scheme),
           pFileManager(std::make_unique<FileManager>(
                   GetFileManagerScheme(), GetDemacroficationScheme())),
-          pParser(std::make_unique<Parser>(
-                  GetDemacroficationScheme(), GetLogFile(), GetMacroStatFile()))
+          pParser(std::make_unique<Parser>(GetDemacroficationScheme(), GetLogFile()))
 {
 }
 
+Overseer::~Overseer()
+{
+    // the front ends may still hold the PCH open
+    frontEnds.clear();
+
+    if(prefixPCH)
+    {
+        std::error_code ec;
+        std::filesystem::remove(prefixPCH->pchFile, ec);
+        std::filesystem::remove(prefixPCH->prefixFile, ec);
+    }
+}
+
 void Overseer::ConfigureFileManager()
 {
     pFileManager->Configure(configScheme.GetFileManagerScheme());
@@ -62,87 +87,335 @@ void Overseer::ConfigureFileManager()
   * 10. catch any errors
   */
 
-void Overseer::StartProcessing(bool demacrofy)
-{   
+void Overseer::StartProcessing(bool demacrofy, std::size_t jobs)
+{
     /// @todo after demacrofication maintain a list of all the macro
     /// identities so that each identifier can be defined in the make file
     /// and subsequently compiled
+    if(jobs == 0)
+    {
+        jobs = std::thread::hardware_concurrency();
+    }
+
+    jobs = std::min(jobs, GetInputFiles().size());
+    InitializeFrontEnds(jobs);
+
+    if(jobs <= 1)
+    {
+        ProcessSerially(demacrofy);
+    }
+    else
+    {
+        ProcessInParallel(demacrofy, jobs);
+    }
+
+    PrintFrontEndStats();
+}
+
+void Overseer::InitializeFrontEnds(std::size_t jobs)
+{
+    // the scopes are classified from the tokens, clang is not needed
+    if(GetDemacroficationScheme().frontEndMode == "lexer")
+    {
+        return;
+    }
+
+    const FrontEndMode mode = GetDemacroficationScheme().frontEndMode == "preprocessor"
+                                      ? FrontEndMode::preprocessor
+                                      : FrontEndMode::ast;
+
+    if(!prefixPCH && !GetDemacroficationScheme().prefixHeaders.empty())
+    {
+        InitializePrefixPCH();
+    }
+
+    while(frontEnds.size() < std::max<std::size_t>(jobs, 1))
+    {
+        frontEnds.push_back(std::make_unique<FrontEndContext>(
+                pFileManager->GetSearchPaths(), mode, prefixPCH.get()));
+    }
+}
+
+void Overseer::InitializePrefixPCH()
+{
+    namespace fs = std::filesystem;
+
+    auto prefix_pch = std::make_unique<PrefixPCH>();
+
+    // the headers which exist are matched by their path, the others are
+    // taken as system headers included with <>
+    for(const auto& header : GetDemacroficationScheme().prefixHeaders)
+    {
+        std::error_code ec;
+        const bool on_disk = fs::exists(header, ec);
+        prefix_pch->headers.push_back(on_disk ? fs::weakly_canonical(header, ec) : fs::path(header));
+        prefix_pch->isSystemHeader.push_back(!on_disk);
+    }
+
+    // unique per run, several instances may share the temp directory
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::error_code temp_ec;
+    const fs::path temp_dir = fs::temp_directory_path(temp_ec);
+    if(temp_ec)
+    {
+        fmt::print(GetLogFile(), "  - log: no temp directory for the prefix PCH ({}), the prefix headers are parsed with every file\n",
+                temp_ec.message());
+        return;
+    }
+    prefix_pch->prefixFile = temp_dir / fmt::format("cpp2cxx-prefix-{}.h", stamp);
+    prefix_pch->pchFile = temp_dir / fmt::format("cpp2cxx-prefix-{}.pch", stamp);
+
+    const auto build_start = std::chrono::steady_clock::now();
+    const bool built = BuildPrefixPCH(pFileManager->GetSearchPaths(), *prefix_pch);
+    pchBuildTime = std::chrono::steady_clock::now() - build_start;
+
+    if(!built)
+    {
+        fmt::print(GetLogFile(), "  - log: building the prefix PCH failed, the prefix headers are parsed with every file\n");
+        std::error_code ec;
+        fs::remove(prefix_pch->pchFile, ec);
+        fs::remove(prefix_pch->prefixFile, ec);
+        return;
+    }
+
+    prefixPCH = std::move(prefix_pch);
+}
+
+std::unique_ptr<FileSession> Overseer::MakeSession(std::size_t file_index, FrontEndContext* front_end)
+{
+    return std::make_unique<FileSession>(file_index, GetInputFiles()[file_index],
+            GetDemacroficationScheme(), pParser->GetGlobalMacros(), front_end);
+}
+
+bool Overseer::MergeSession(FileSession const& session)
+{
     try
     {
-        for(auto&& aFile : GetInputFiles())
+        GetLogFile() << session.GetLog();
+
+        if(session.IsParsed())
         {
-            GenerateExternalASTHandler(aFile.string());
-            //GetInformationFromExternalSource(*v_iter);
-            RunParser(aFile.string());
+            macroCount += session.GetMacroCount();
+            functionLikeCount += session.GetFunctionLikeCount();
+            objectLikeCount += session.GetObjectLikeCount();
+
+            fmt::print(GetMacroStatFile(),
+                    "- Total_Macros: {}\n"
+                    "- Total_Function_Like_Macros: {}\n"
+                    "- Total_Object_Like_Macros: {}\n",
+                    macroCount, functionLikeCount, objectLikeCount);
+            PrintMacroStats(GetMacroStatFile(), session.GetMacroStats());
+
+            sourceBytes += session.GetSourceBytes();
+            skippedSourceBytes += session.GetSkippedSourceBytes();
+            peakAnalysisArenaBytes = std::max(peakAnalysisArenaBytes, session.GetAnalysisArenaBytes());
+        }
 
-            if(demacrofy)
-            {
-                RunDemacrofier();
-                RunDependencyAnalyzer();
-            }
+        GetStatFile() << session.GetStat();
+
+        clangParsedFiles += session.IsClangParsed() ? 1 : 0;
+        clangSkippedFiles += session.IsClangSkipped() ? 1 : 0;
+        clangTime += session.GetClangTime();
+        preScanTime += session.GetPreScanTime();
+        prefixPCHFiles += session.UsedPrefixPCH() ? 1 : 0;
+        scopeAgreement += session.GetScopeAgreement();
+
+        if(session.IsDemacrofied())
+        {
+            pFileManager->UpdateFile(session);
         }
+
+        session.RethrowError();
     }
     catch(ExceptionHandler& e)
     {
         //std::cout<<"There was some error in start processing";
         fmt::print(GetLogFile(), "Error: {}\n", e.GetExMessage());
+        return false;
     }
-}
 
-const std::vector<std::filesystem::path>& Overseer::GetInputFiles()
-{
-    return pFileManager->GetInputFiles();
+    return true;
 }
 
-void Overseer::RunParser(const std::filesystem::path& log_file_name)
+void Overseer::PrintFrontEndStats()
 {
-    /// pass the data collected from clang front end
-    pParser->Parse(log_file_name, &ASTMacroStat, nullptr);
-    //pMacTree = pParser->GetMacTree();
-}
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+    // the time saved is estimated from the average time clang took for
+    // the files it had to parse
+    const milliseconds clang_time = clangTime;
+    const double saved_time = clangParsedFiles == 0
+                                      ? 0.0
+                                      : clang_time.count() / clangParsedFiles * clangSkippedFiles;
+
+    fmt::print(GetMacroStatFile(),
+            "- Clang_Parsed_Files: {}\n"
+            "- Clang_Skipped_Files: {}\n"
+            "- Clang_Time_ms: {:.1f}\n"
+            "- Pre_Scan_Time_ms: {:.1f}\n"
+            "- Estimated_Clang_Time_Saved_ms: {:.1f}\n",
+            clangParsedFiles, clangSkippedFiles, clang_time.count(),
+            milliseconds(preScanTime).count(), saved_time);
+
+    fmt::print(GetMacroStatFile(),
+            "- Lexer_Input_Bytes: {}\n"
+            "- Lexer_Skipped_Bytes: {}\n",
+            sourceBytes, skippedSourceBytes);
+
+    // the trees are released with their sessions, so the peak stays
+    // bounded by the largest files and the parallel jobs, not the file count
+    fmt::print(GetMacroStatFile(),
+            "- Peak_Analysis_Arena_Bytes: {}\n"
+            "- Peak_RSS_Bytes: {}\n",
+            peakAnalysisArenaBytes, general_utilities::peakResidentBytes());
+
+    // how far the scopes classified from the tokens can be trusted,
+    // compared against the files which went through clang
+    if(scopeAgreement.macros != 0)
+    {
+        fmt::print(GetMacroStatFile(),
+                "- Lexer_Scope_Macros_Compared: {}\n"
+                "- Lexer_Scope_Agreement: {}\n"
+                "- Lexer_Invocation_Agreement: {}\n",
+                scopeAgreement.macros, scopeAgreement.scopeMatches,
+                scopeAgreement.invocationMatches);
+    }
 
-void Overseer::RunDependencyAnalyzer()
-{
-    //pass the tree pointer
-    //pass the log_file pointer
-    //pass a call_back function(observer) which will give the
-    //return the relevant error message to the dependency analyser
-    //or may be it can only take the relevant error message and put that into
-    //log file
-    //
-    pParser->PPAnalyzeMacroDependency(GetLogFile());
-    //
-    //dependency analyzer should do the analysis and then put the analysis
-    //result into the log_file
+    // every file loading the PCH would otherwise have parsed the prefix
+    // headers, which is estimated to take as long as building the PCH
+    if(!GetDemacroficationScheme().prefixHeaders.empty() && GetDemacroficationScheme().frontEndMode != "lexer")
+    {
+        const milliseconds build_time = pchBuildTime;
+        const double saved_pch_time = prefixPCHFiles == 0 ? 0.0 : build_time.count() * (prefixPCHFiles - 1);
+        fmt::print(GetMacroStatFile(),
+                "- PCH_Build_Time_ms: {:.1f}\n"
+                "- PCH_Files: {}\n"
+                "- Estimated_PCH_Time_Saved_ms: {:.1f} # assumes parsing the prefix headers takes PCH_Build_Time_ms per PCH file\n",
+                build_time.count(), prefixPCHFiles, saved_pch_time);
+    }
 }
 
-void Overseer::PrintTotalOrder()
+void Overseer::ProcessSerially(bool demacrofy)
 {
-    //call the dep_analyzer to print the total order
-    //to the file_pointer passed to the dependency_analyzer
+    for(std::size_t i = 0; i < GetInputFiles().size(); ++i)
+    {
+        auto session = MakeSession(i, frontEnds.empty() ? nullptr : frontEnds.front().get());
+        session->Run(demacrofy);
+
+        if(!MergeSession(*session))
+        {
+            break;
+        }
+    }
 }
 
-void Overseer::RunDemacrofier()
+/// the workers pick the files in order and hand the finished sessions to the
+/// calling thread, which merges them in the same order. To bound the memory
+/// held by finished sessions, a worker does not start a file which is more
+/// than 2 * jobs files ahead of the next one to be merged.
+void Overseer::ProcessInParallel(bool demacrofy, std::size_t jobs)
 {
-    //if(one_file_at_a_time)
-    //std::string demac_string = demacrofy(tree_ptr,input_file_ptr)
-    //else if(one_macro_at_a_time)
-    //std::string demac_string = demacrofy(mac_ptr)
-    //else invalid option
-    pParser->Demacrofy(GetStatFile(), configScheme.GetDemacroficationScheme().multipleDefinitions);
-    UpdateFileManager();
+    const std::size_t num_files = GetInputFiles().size();
+    const std::size_t window = 2 * jobs;
+
+    std::vector<std::promise<std::unique_ptr<FileSession>>> finished(num_files);
+    std::vector<std::future<std::unique_ptr<FileSession>>> results;
+    results.reserve(num_files);
+    std::transform(finished.begin(), finished.end(), std::back_inserter(results),
+            [](auto& promise) { return promise.get_future(); });
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::size_t next_file = 0;
+    std::size_t merged_files = 0;
+    bool stop = false;
+
+    auto worker = [&](FrontEndContext* front_end) {
+        while(true)
+        {
+            std::size_t file_index = 0;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [&]() {
+                    return stop || next_file == num_files || next_file < merged_files + window;
+                });
+
+                if(stop || next_file == num_files)
+                {
+                    return;
+                }
+
+                file_index = next_file++;
+            }
+
+            try
+            {
+                auto session = MakeSession(file_index, front_end);
+                session->Run(demacrofy);
+                finished[file_index].set_value(std::move(session));
+            }
+            catch(...)
+            {
+                finished[file_index].set_exception(std::current_exception());
+            }
+        }
+    };
+
+    auto stop_workers = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        queue_cv.notify_all();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(jobs);
+
+    for(std::size_t i = 0; i < jobs; ++i)
+    {
+        workers.emplace_back(worker, frontEnds.empty() ? nullptr : frontEnds[i].get());
+    }
+
+    try
+    {
+        for(auto& result : results)
+        {
+            auto session = result.get();
+            const bool keep_going = MergeSession(*session);
+
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                ++merged_files;
+            }
+            queue_cv.notify_all();
+
+            if(!keep_going)
+            {
+                break;
+            }
+        }
+    }
+    catch(...)
+    {
+        stop_workers();
+        std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+        throw;
+    }
+
+    stop_workers();
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
 }
 
-void Overseer::UpdateFileManager()
+const std::vector<std::filesystem::path>& Overseer::GetInputFiles()
 {
-    //std::cout<<output_file;
-    pFileManager->UpdateFile(*this);
+    return pFileManager->GetInputFiles();
 }
 
-/// @brief called by the FileManager class to update the file
-void Overseer::WriteOutputFile(std::ostream& os) const
+void Overseer::PrintTotalOrder()
 {
-    pParser->GetDemacrofiedFile(os);
+    //call the dep_analyzer to print the total order
+    //to the file_pointer passed to the dependency_analyzer
 }
 
 std::ostream& Overseer::GetLogFile()
@@ -169,45 +442,3 @@ FileManagerScheme& Overseer::GetFileManagerScheme()
 {
     return configScheme.GetFileManagerScheme();
 }
-
-void Overseer::GenerateExternalASTHandler(const std::string& filename)
-{
-    /// generally the function definitions are not in header files. This has been done to make things faster and minimize
-    /// clang errors. As there are cases where header files are not self contained e.g. poco-1.4.3p1/XML$ vi src/xmlrole.h
-    ///
-    if(general_utilities::isHeaderFile(filename))
-    {
-        return;
-    }
-
-    clang::CompilerInstance ci(std::make_shared<clang::PCHContainerOperations>(), nullptr);
-
-    //InvocationStat_t inv_stat;
-
-    pASTConsumer.InitializeCI(ci, pFileManager->GetSearchPaths());
-
-    pASTConsumer.DumpContent(filename);
-
-    //ASTConsumer.PrintStats();
-    pASTConsumer.VerifyMacroScope(true);
-    ASTMacroStat = pASTConsumer.GetMacroStat();
-    //inv_stat = ASTConsumer.GetInvocationStat();
-}
-
-/*
-void Overseer::GenerateExternalASTHandler()
-{
-  clang::CompilerInstance *pci = new clang::CompilerInstance;
-  pASTConsumer = new MyASTConsumer;
-  pASTConsumer->Initialize(*pci);
-}
-
-void Overseer::GetInformationFromExternalSource(const std::string& filename)
-{
-  pASTConsumer->DumpContent(filename);
-  pASTConsumer->PrintStats();
-  pASTConsumer->VerifyMacroScope();
-  delete pASTConsumer;
-  pASTConsumer = NULL;
-}
-*/
@@ -0,0 +1,329 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/ParallelLexer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace
+{
+std::size_t ThreadCount(std::size_t threads)
+{
+    return threads == 0 ? std::max<std::size_t>(std::thread::hardware_concurrency(), 1) : threads;
+}
+
+/// @brief a line start at or after target which most likely begins a token:
+/// it does not continue a line ending with a backslash and it is not a line
+/// of a block comment starting with a '*'. The stitching does not rely on it.
+std::size_t FindSplitPoint(std::string_view contents, std::size_t target)
+{
+    while(true)
+    {
+        const std::size_t newline = contents.find('\n', target);
+        if(newline == std::string_view::npos)
+        {
+            return contents.size();
+        }
+        const std::size_t start = newline + 1;
+
+        std::size_t line_end = newline;
+        if(line_end > 0 && contents[line_end - 1] == '\r')
+        {
+            --line_end;
+        }
+        const bool continued = line_end > 0 && contents[line_end - 1] == '\\';
+        const std::size_t first = contents.find_first_not_of(" \t", start);
+        const bool comment_line = first != std::string_view::npos && contents[first] == '*';
+
+        if(!continued && !comment_line)
+        {
+            return start;
+        }
+        target = start;
+    }
+}
+
+/// the offset of a token into the contents
+std::size_t Offset(token_type const& token, position_type const& base)
+{
+    return token.get_position().get_offset() - base.get_offset();
+}
+
+/**
+ * @struct Chunk
+ * @brief the tokens starting in [begin, end), lexed as if a token started at
+ * begin. The lexer runs up to the end of the file and is paused at the first
+ * token from end on, so the stitching can follow it into the next chunk.
+ */
+struct Chunk
+{
+    std::size_t begin{ 0 };
+    std::size_t end{ 0 };
+    std::vector<token_type> tokens;
+    std::unique_ptr<lexer_interface> lexer;
+    token_type next;
+    /// thrown by the lexer after the tokens
+    std::exception_ptr error;
+
+    /// set by the stitching: the tokens from first on are taken, followed
+    /// by the ones the lexer returned past the end of the chunk
+    bool taken{ false };
+    std::size_t first{ 0 };
+    std::vector<token_type> followed;
+};
+
+void LexChunk(Chunk& chunk, LexerBackend backend, std::string_view contents, position_type const& base,
+        boost::wave::language_support language)
+{
+    try
+    {
+        chunk.lexer.reset(NewLexer(backend, contents.data() + chunk.begin, contents.data() + contents.size(),
+                base.at_offset(base.get_offset() + static_cast<std::uint32_t>(chunk.begin)), language));
+
+        token_type token;
+        while(!chunk.lexer->get(token).is_eoi() && Offset(token, base) < chunk.end)
+        {
+            chunk.tokens.push_back(std::move(token));
+        }
+        chunk.next = std::move(token);
+    }
+    catch(...)
+    {
+        chunk.error = std::current_exception();
+    }
+}
+
+/// @brief takes the first chunk, then follows its lexer until it starts a
+/// token at the same offset as one of the next chunk. From there on both
+/// return the same tokens, so the rest of that chunk is taken and its lexer
+/// is followed. A chunk the lexer passes without such an offset started
+/// inside a token and is dropped.
+void Stitch(std::vector<Chunk>& chunks, position_type const& base)
+{
+    Chunk* current = &chunks.front();
+    current->taken = true;
+
+    const auto follow = [&](std::size_t until, Chunk* chunk) {
+        while(true)
+        {
+            // the lexer which is followed runs over the same tokens as the
+            // sequential one, its errors are real
+            if(current->error)
+            {
+                std::rethrow_exception(current->error);
+            }
+            if(current->next.is_eoi())
+            {
+                return;
+            }
+
+            const std::size_t offset = Offset(current->next, base);
+            if(offset >= until)
+            {
+                return;
+            }
+            if(chunk != nullptr)
+            {
+                const auto found = std::lower_bound(chunk->tokens.begin(), chunk->tokens.end(), offset,
+                        [&base](token_type const& token, std::size_t at) { return Offset(token, base) < at; });
+                if(found != chunk->tokens.end() && Offset(*found, base) == offset)
+                {
+                    current = chunk;
+                    current->taken = true;
+                    current->first = static_cast<std::size_t>(found - chunk->tokens.begin());
+                    return;
+                }
+            }
+
+            current->followed.push_back(std::move(current->next));
+            current->lexer->get(current->next);
+        }
+    };
+
+    for(auto chunk = chunks.begin() + 1; chunk != chunks.end(); ++chunk)
+    {
+        follow(chunk->end, &*chunk);
+    }
+    follow(std::numeric_limits<std::size_t>::max(), nullptr);
+}
+
+/// @brief moves the taken tokens into one array, a thread per chunk
+std::vector<token_type> Concatenate(std::vector<Chunk>& chunks)
+{
+    std::size_t total = 0;
+    for(const Chunk& chunk : chunks)
+    {
+        if(chunk.taken)
+        {
+            total += chunk.tokens.size() - chunk.first + chunk.followed.size();
+        }
+    }
+
+    // with room for the eoi token the TokenArena adds
+    std::vector<token_type> result;
+    result.reserve(total + 1);
+    result.resize(total);
+
+    const auto move_chunk = [&result](Chunk& chunk, std::size_t at) {
+        auto out = std::move(chunk.tokens.begin() + static_cast<std::ptrdiff_t>(chunk.first), chunk.tokens.end(),
+                result.begin() + static_cast<std::ptrdiff_t>(at));
+        std::move(chunk.followed.begin(), chunk.followed.end(), out);
+        std::vector<token_type>().swap(chunk.tokens);
+        std::vector<token_type>().swap(chunk.followed);
+    };
+
+    std::vector<std::thread> workers;
+    std::size_t at = chunks.front().tokens.size() + chunks.front().followed.size();
+    for(auto chunk = chunks.begin() + 1; chunk != chunks.end(); ++chunk)
+    {
+        if(chunk->taken)
+        {
+            const std::size_t size = chunk->tokens.size() - chunk->first + chunk->followed.size();
+            workers.emplace_back(move_chunk, std::ref(*chunk), at);
+            at += size;
+        }
+    }
+    move_chunk(chunks.front(), 0);
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+
+    return result;
+}
+} // namespace
+
+std::vector<token_type> LexInParallel(LexerBackend backend, std::string_view contents,
+        position_type const& pos, boost::wave::language_support language, std::size_t threads,
+        std::size_t min_chunk)
+{
+    // the chunks share the line index of the contents
+    const position_type base = pos.indexed(contents.data(), contents.data() + contents.size());
+
+    // the stock Wave lexer keeps a state from one token to the next
+    std::size_t count = 1;
+    if(backend != LexerBackend::wave)
+    {
+        count = std::clamp<std::size_t>(contents.size() / std::max<std::size_t>(min_chunk, 1), 1,
+                ThreadCount(threads));
+    }
+
+    std::vector<Chunk> chunks(1);
+    for(std::size_t i = 1; i < count; ++i)
+    {
+        const std::size_t split = FindSplitPoint(contents, contents.size() / count * i);
+        if(split > chunks.back().begin && split < contents.size())
+        {
+            chunks.back().end = split;
+            chunks.emplace_back().begin = split;
+        }
+    }
+    // the last one takes the T_EOF
+    chunks.back().end = std::numeric_limits<std::size_t>::max();
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size() - 1);
+    for(auto chunk = chunks.begin() + 1; chunk != chunks.end(); ++chunk)
+    {
+        workers.emplace_back(LexChunk, std::ref(*chunk), backend, contents, std::cref(base), language);
+    }
+    LexChunk(chunks.front(), backend, contents, base, language);
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+
+    if(chunks.size() == 1)
+    {
+        if(chunks.front().error)
+        {
+            std::rethrow_exception(chunks.front().error);
+        }
+        return std::move(chunks.front().tokens);
+    }
+
+    Stitch(chunks, base);
+    return Concatenate(chunks);
+}
+
+std::vector<token_type> LexSpansInParallel(LexerBackend backend, std::string_view contents,
+        SourceSpans const& spans, position_type const& pos, boost::wave::language_support language,
+        std::size_t threads, std::size_t min_chunk)
+{
+    const position_type base = pos.indexed(contents.data(), contents.data() + contents.size());
+
+    const std::size_t count = std::clamp<std::size_t>(
+            contents.size() / std::max<std::size_t>(min_chunk, 1), 1, ThreadCount(threads));
+
+    // whole spans of about the same size, each ending the group with a T_EOF
+    std::vector<SourceSpans> groups(1);
+    for(const SourceSpan& span : spans.spans)
+    {
+        if(!groups.back().spans.empty() && span.begin >= contents.size() / count * groups.size())
+        {
+            groups.emplace_back();
+        }
+        groups.back().spans.push_back(span);
+        groups.back().usable = true;
+    }
+
+    std::vector<std::vector<token_type>> parts(groups.size());
+    std::vector<std::exception_ptr> errors(groups.size());
+    const auto lex_group = [&](std::size_t i) {
+        try
+        {
+            lexer_iterator it = MakeSpanTokenIterator(contents, groups[i], base, language, backend);
+            for(const lexer_iterator end; it != end; ++it)
+            {
+                parts[i].push_back(*it);
+            }
+        }
+        catch(...)
+        {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(groups.size() - 1);
+    for(std::size_t i = 1; i < groups.size(); ++i)
+    {
+        workers.emplace_back(lex_group, i);
+    }
+    lex_group(0);
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+
+    std::vector<token_type> result;
+    for(std::size_t i = 0; i < parts.size(); ++i)
+    {
+        if(errors[i])
+        {
+            std::rethrow_exception(errors[i]);
+        }
+        // only the T_EOF of the last group is kept
+        const auto last = i + 1 == parts.size() || parts[i].empty() ? parts[i].end() : parts[i].end() - 1;
+        result.insert(result.end(), std::make_move_iterator(parts[i].begin()), std::make_move_iterator(last));
+    }
+    return result;
+}
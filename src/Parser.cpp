@@ -26,11 +26,17 @@ limitations under the License.
 #include "cpp2cxx/DemacroficationScheme.h"
 #include "cpp2cxx/Demacrofier.h"
 #include "cpp2cxx/DepAnalyzer.h"
+#include "cpp2cxx/LexerScopeClassifier.h"
 #include "cpp2cxx/Macro.h"
 #include "cpp2cxx/MacroStat.h"
+#include "cpp2cxx/ParallelLexer.h"
 #include "cpp2cxx/RlParser.h"
+#include "cpp2cxx/SourceBuffer.h"
+#include "cpp2cxx/SourceSpanScanner.h"
 #include "cpp2cxx/ValidatorMap.h"
 
+#include "clang_interface/FrontEndContext.hpp"
+
 #include "general_utilities/vector_utils.hpp"
 
 // Read the file name and then look for macros.
@@ -38,20 +44,26 @@ limitations under the License.
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <fmt/ostream.h>
 #include <fstream>
+#include <system_error>
+#include <utility>
 
-Parser::Parser(const DemacroficationScheme& demacrofication_scheme, std::ostream& log_file,
-        std::ostream& macro_list_file)
+Parser::Parser(const DemacroficationScheme& demacrofication_scheme, std::ostream& log_file)
         : pDemacroficationScheme(&demacrofication_scheme),
+          lexerBackend(ParseLexerBackend(demacrofication_scheme.lexerBackend)),
           rp(std::make_unique<RlParser>(demacrofication_scheme, log_file)),
           demac(std::make_unique<Demacrofier>()),
-          logFile(log_file),
-          mlFile(macro_list_file)
+          logFile(log_file)
 {
     /// TODO: dispatch components of demacrofication_scheme to relevant
     /// classes.
-    if(!pDemacroficationScheme->globalMacrosFormatted.empty())
+    if(pDemacroficationScheme->predefinedMacros == "clang")
+    {
+        LoadClangPredefinedMacros();
+    }
+    else if(!pDemacroficationScheme->globalMacrosFormatted.empty())
     {
         fileGlobalMacros = pDemacroficationScheme->globalMacrosFormatted;
         ReadGlobalMacros(fileGlobalMacros);
@@ -64,31 +76,47 @@ Parser::Parser(const DemacroficationScheme& demacrofication_scheme, std::ostream
         fileGlobalMacros = "gConditions.h";
         ParseNewGlobalMacros(pDemacroficationScheme->globalMacrosRaw);
     }
-    // passing the file containing global macros so that it can make a list
-    // which is useful in determining if a conditional macro uses global macros
-    // FIXME: We're reading the global macros twice by doing this.
-    cp = std::make_unique<CondParser>(fileGlobalMacros);
+    // passing the list of global macros so that it can be used
+    // in determining if a conditional macro uses global macros
+    cp = std::make_unique<CondParser>(globalMacros);
 }
 
-void Parser::Parse(const std::filesystem::path& file_name, ASTMacroStat_t* p, InvocationStat_t* is)
+Parser::Parser(const DemacroficationScheme& demacrofication_scheme, std::ostream& log_file,
+        GlobalMacros_t global_macros, AnalysisArena* analysis_arena)
+        : pDemacroficationScheme(&demacrofication_scheme),
+          lexerBackend(ParseLexerBackend(demacrofication_scheme.lexerBackend)),
+          rp(std::make_unique<RlParser>(demacrofication_scheme, log_file)),
+          demac(std::make_unique<Demacrofier>()),
+          logFile(log_file),
+          globalMacros(std::move(global_macros))
+{
+    if(analysis_arena != nullptr)
+    {
+        pArena = analysis_arena;
+    }
+    assert(globalMacros && "the global macros are loaded by the first Parser");
+    cp = std::make_unique<CondParser>(globalMacros);
+}
+
+void Parser::Parse(const std::filesystem::path& file_name, SourceBuffer const& source,
+        ASTMacroStat_t* p, InvocationStat_t* is)
 {
     assert(p && "AST does not give any information");
     pASTMacroStat = p;
     pInvocationStat = is;
-    Parse(file_name);
+    Parse(file_name, source);
+}
 
-    //after parsing localMacros contains all the macros parsed
-    //putting all the macros in this file
-    fmt::print(mlFile,
-            "- Total_Macros: {}\n"
-            "- Total_Function_Like_Macros: {}\n"
-            "- Total_Object_Like_Macros: {}\n",
-            macro_count, function_like_count, object_like_count);
-    PrintMacroStats(mlFile, vec_macro_stat);
+void Parser::Parse(const std::filesystem::path& file_name)
+{
+    // kept for Demacrofy, which splices the output from the source
+    auto source = std::make_shared<SourceBuffer const>(file_name);
+    ownedSource = source;
+    Parse(file_name, *source);
 }
 
 /// @todo complete this function
-void Parser::Parse(const std::filesystem::path& file_name)
+void Parser::Parse(const std::filesystem::path& file_name, SourceBuffer const& source)
 {
     logFile << file_name << ":\n";
     /// TODO: not clearing the list of local macros for a file
@@ -96,28 +124,19 @@ void Parser::Parse(const std::filesystem::path& file_name)
     /// to find the macros in a header file included by the the current file
     localMacros.clear();
 
-    std::ifstream instream(file_name, std::ios_base::in);
-
-    if(!instream.is_open())
+    if(!source.IsOpen())
     {
         logFile << "  - error: " << file_name << " couldn't be opened\n";
         throw ExceptionHandler("Input file could not be opened");
     }
 
-    /// NOTE: the following part is not to be taken into ParseLocalMacros
-    /// because the position_type requires the file name
-    instream.unsetf(std::ios::skipws);
-
-    ifileStr = std::string(
-            std::istreambuf_iterator<char>(instream.rdbuf()), std::istreambuf_iterator<char>());
-    //just in case the file has only macros and the
-    //replacement list of last macro doesn't find a newline
-    // FIXME: Is this necessary?
-    ifileStr += "\n";
-
-    position_type pos(file_name.string(), 1Ui64, 1Ui64);
+    /// the source is indexed once, with the file name, for all its lexers
+    ParseLocalMacros(source.GetContents(), source.GetPosition());
+}
 
-    ParseLocalMacros(ifileStr, pos);
+void Parser::SetScopeClassifier(LexerScopeClassifier* scope_classifier)
+{
+    pScopeClassifier = scope_classifier;
 }
 
 //when we don't need to parse the global macros, just read the globalMacros
@@ -130,7 +149,19 @@ void Parser::ReadGlobalMacros(const std::filesystem::path& global_macro_file_nam
     //conditional parser for looking up the list of global macros
     try
     {
-        globalMacros.clear();
+        if(MacroSnapshot::IsSnapshotFile(global_macro_file_name))
+        {
+            globalMacros = MacroSnapshot::Map(global_macro_file_name);
+            return;
+        }
+
+        // the text is only read again when it changed since its snapshot
+        const auto snapshot_file = MacroSnapshot::GetCacheFile(global_macro_file_name);
+        if(MacroSnapshot::IsCacheFresh(snapshot_file, global_macro_file_name))
+        {
+            globalMacros = MacroSnapshot::Map(snapshot_file);
+            return;
+        }
 
         std::ifstream gMacros(global_macro_file_name, std::ios_base::in);
 
@@ -145,12 +176,19 @@ void Parser::ReadGlobalMacros(const std::filesystem::path& global_macro_file_nam
         gMacros.seekg(0, std::ios::beg);
 
         //to ignore the newline at the end of the file
+        MacroList_t macros;
         for(std::string fc, sc; std::getline(gMacros, fc), std::getline(gMacros, sc);)
         {
-            globalMacros.insert({ fc, sc });
+            macros.insert({ fc, sc });
         }
 
         gMacros.close();
+
+        globalMacros = MacroSnapshot::Build(macros);
+        if(!MacroSnapshot::Write(snapshot_file, macros))
+        {
+            fmt::print(logFile, "  - log: the snapshot {} could not be written.\n", snapshot_file.string());
+        }
     }
     catch(ExceptionHandler& e)
     {
@@ -169,8 +207,6 @@ void Parser::ReadGlobalMacros(const std::filesystem::path& global_macro_file_nam
 void Parser::ParseNewGlobalMacros(const std::string& raw_global_macro_file_name)
 {
     //  const char* infile = "gConditions.h";
-    globalMacros.clear();
-
     std::ifstream gmstream(raw_global_macro_file_name, std::ios_base::in);
 
     if(!gmstream.is_open())
@@ -186,22 +222,12 @@ void Parser::ParseNewGlobalMacros(const std::string& raw_global_macro_file_name)
     //replacement list of last macro doesn't find a newline
     instr += "\n";
 
-    position_type pos(raw_global_macro_file_name, 1Ui64, 1Ui64);
-
-    it = token_iterator(instr.begin(), instr.end(), pos,
-            boost::wave::language_support(
-                    boost::wave::support_cpp | boost::wave::support_option_long_long));
-
-    it_begin = it;
-
-    it_end = token_iterator();
-
     //first parse the global macros and put into a file which can be used by
     //conditional parser for looking up the list of global macros
     try
     {
         //writing into fileGlobalMacros
-        ParseMacros(globalMacros);
+        const MacroList_t macros = ParseGlobalMacroSource(instr, raw_global_macro_file_name);
 
         std::ofstream gMacros(fileGlobalMacros, std::ios_base::out);
 
@@ -210,12 +236,20 @@ void Parser::ParseNewGlobalMacros(const std::string& raw_global_macro_file_name)
             throw ExceptionHandler("file: " + fileGlobalMacros.string() + " couldn't be opened\n");
         }
 
-        std::for_each(globalMacros.begin(), globalMacros.end(),
+        std::for_each(macros.begin(), macros.end(),
                 [&gMacros](const std::pair<std::string, std::string>& gm) {
                     gMacros << gm.first << "\n" << gm.second << "\n";
                 });
 
         gMacros.close();
+
+        // the next run can pass the formatted file and map its snapshot
+        globalMacros = MacroSnapshot::Build(macros);
+        const auto snapshot_file = MacroSnapshot::GetCacheFile(fileGlobalMacros);
+        if(!MacroSnapshot::Write(snapshot_file, macros))
+        {
+            fmt::print(logFile, "  - log: the snapshot {} could not be written.\n", snapshot_file.string());
+        }
     }
     catch(ExceptionHandler& e)
     {
@@ -224,6 +258,85 @@ void Parser::ParseNewGlobalMacros(const std::string& raw_global_macro_file_name)
     }
 }
 
+//the predefined macros of the clang front end, the snapshot is cached by
+//the configuration of the front end so that clang is asked only once
+void Parser::LoadClangPredefinedMacros()
+{
+    ClangPredefinedMacros clang_predefined;
+    const std::string configuration = clang_predefined.GetConfiguration();
+
+    // FNV-1a, the name must be the same in every run
+    std::uint64_t key = 14695981039346656037ull;
+    for(const char c : configuration)
+    {
+        key = (key ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+
+    std::error_code ec;
+    const std::filesystem::path cache_directory = pDemacroficationScheme->predefinedMacroCache.empty()
+                                                          ? std::filesystem::temp_directory_path(ec)
+                                                          : std::filesystem::path(pDemacroficationScheme->predefinedMacroCache);
+    // without a temp directory the macros are parsed in memory, the snapshot
+    // is not written to the working directory
+    const bool cached = !ec;
+    if(cached)
+    {
+        fileGlobalMacros = cache_directory / fmt::format("cpp2cxx-predefined-{:016x}.snapshot", key);
+    }
+    else
+    {
+        fmt::print(logFile, "  - log: no temp directory for the predefined macro snapshot ({}), clang is asked in every run\n",
+                ec.message());
+    }
+
+    try
+    {
+        if(cached && MacroSnapshot::IsSnapshotFile(fileGlobalMacros))
+        {
+            globalMacros = MacroSnapshot::Map(fileGlobalMacros);
+            fmt::print(logFile, "  - log: {} predefined macros of {} read from {}\n", globalMacros->size(),
+                    configuration, fileGlobalMacros.string());
+            return;
+        }
+
+        const MacroList_t macros = ParseGlobalMacroSource(clang_predefined.GetDefines(), "<clang predefines>");
+        globalMacros = MacroSnapshot::Build(macros);
+        fmt::print(logFile, "  - log: {} predefined macros of {} taken from clang\n", macros.size(), configuration);
+
+        if(cached && !MacroSnapshot::Write(fileGlobalMacros, macros))
+        {
+            fmt::print(logFile, "  - log: the snapshot {} could not be written.\n", fileGlobalMacros.string());
+        }
+    }
+    catch(ExceptionHandler& e)
+    {
+        fmt::print(logFile, "  - error: {}\n", e.GetExMessage());
+        throw;
+    }
+}
+
+MacroList_t Parser::ParseGlobalMacroSource(std::string_view source, std::string const& source_name)
+{
+    // empty while the global macros themselves are parsed
+    globalMacros = MacroSnapshot::Build({});
+
+    globalSourceIndex = boost::wave::cpplexer::source_index(
+            source_name, source.data(), source.data() + source.size());
+
+    tokens.Lex(MakeLexerIterator(lexerBackend, source, globalSourceIndex.position(),
+                       boost::wave::language_support(
+                               boost::wave::support_cpp | boost::wave::support_option_long_long)),
+            lexer_iterator());
+
+    it = it_begin = tokens.begin();
+
+    it_end = tokens.end();
+
+    MacroList_t macros;
+    ParseMacros(macros);
+    return macros;
+}
+
 void Parser::ParseMacros(MacroList_t& macro_list)
 {
     InitializeMacTree();
@@ -232,12 +345,21 @@ void Parser::ParseMacros(MacroList_t& macro_list)
     bool PPDEFINED = true;
     bool PPNOTDEFINED = false;
 
+    // the tree keeps the conditions as spans of the tokens, a handler leaves
+    // it at the last token of its directive (the CondParser may skip e.g. a
+    // comment without putting it into condStmt), the loop goes past it
+    Node tempNode;
+    const auto condition = [this](token_iterator cond_begin) {
+        return TokenSpan{ cond_begin, it == it_end ? it_end : it + 1 };
+    };
     while(it != it_end)
     {
-        //so that we get a new tempNode and macro everytime
-        Node tempNode;
+        //so that we get a new macro everytime
         PPMacro mac;
         condStmt.clear();
+        tempNode.condStmt.clear();
+        tempNode.condCat = CondCategory::local;
+        const token_iterator cond_begin = it;
 
         // FIXME: What happens if there is no endif after the ifs?
         switch(auto id = boost::wave::token_id(*it); id)
@@ -252,24 +374,24 @@ void Parser::ParseMacros(MacroList_t& macro_list)
             ++nesting_level;
             tempNode.key = *it;
             PPIfHandler(tempNode);
-            pTree->MakeChild(tempNode);
+            pTree->MakeChild(tempNode, condition(cond_begin));
             break;
         case boost::wave::T_PP_IFDEF:
             ++nesting_level;
             tempNode.key = *it;
             PPIfHandler(tempNode, PPDEFINED);
-            pTree->MakeChild(tempNode);
+            pTree->MakeChild(tempNode, condition(cond_begin));
             break;
         case boost::wave::T_PP_IFNDEF:
             ++nesting_level;
             tempNode.key = *it;
             PPIfHandler(tempNode, PPNOTDEFINED);
-            pTree->MakeChild(tempNode);
+            pTree->MakeChild(tempNode, condition(cond_begin));
             break;
         case boost::wave::T_PP_ELIF:
             tempNode.key = *it;
             PPIfHandler(tempNode);
-            pTree->MakeSibling(tempNode);
+            pTree->MakeSibling(tempNode, condition(cond_begin));
             break;
         case boost::wave::T_PP_ELSE:
             tempNode.key = *it;
@@ -277,7 +399,7 @@ void Parser::ParseMacros(MacroList_t& macro_list)
             condStmt.push_back(*it);
             tempNode.condStmt = condStmt;
             tempNode.condCat = condCat; //same as of immediate IF block
-            pTree->MakeSibling(tempNode);
+            pTree->MakeSibling(tempNode, condition(cond_begin));
             break;
         case boost::wave::T_PP_ENDIF:
             tempNode.key = *it;
@@ -285,7 +407,7 @@ void Parser::ParseMacros(MacroList_t& macro_list)
             condStmt.push_back(*it);
             tempNode.condStmt = condStmt;
             tempNode.condCat = condCat; //same as of immediate IF block
-            pTree->MakeSibling(tempNode);
+            pTree->MakeSibling(tempNode, condition(cond_begin));
             --nesting_level;
             //logFile<<"nesting level = "<<nesting_level<<"\n";
             if(nesting_level < 0)
@@ -312,7 +434,15 @@ void Parser::ParseMacros(MacroList_t& macro_list)
             break;
         default:
             //logFile<<"  - log: checking token: "<<it->get_value()<<"\n";
-            pTree->CheckToken(it);
+            //the tree has the same #defines as macro_list, looked up by symbol
+            if(const bool is_macro = pTree->CheckToken(it); pScopeClassifier != nullptr)
+            {
+                pScopeClassifier->PutToken(*it);
+                if(id == boost::wave::T_IDENTIFIER && is_macro)
+                {
+                    pScopeClassifier->MacroInvoked(*it);
+                }
+            }
             break; //goto next line of the code
         }
 
@@ -323,7 +453,7 @@ void Parser::ParseMacros(MacroList_t& macro_list)
 bool Parser::PPCheckIdentifier(std::string const& id_value) const
 {
     return (localMacros.find(id_value) != localMacros.end())
-           || (globalMacros.find(id_value) != localMacros.end());
+           || globalMacros->Contains(id_value);
 }
 
 bool Parser::PPCheckIdentifier(std::string const& id_str, MacroList_t const& macro_list) const
@@ -437,7 +567,7 @@ void Parser::PPDefineHandler(MacroList_t& macro_list, PPMacro& macro_ref)
 
     try
     {
-        if(macro_list == localMacros && pDemacroficationScheme->enableWarningFlag)
+        if(&macro_list == &localMacros && pDemacroficationScheme->enableWarningFlag)
         {
             AnalyzeIdentifier(macro_ref);
         }
@@ -519,6 +649,11 @@ void Parser::PPDefineHandler(MacroList_t& macro_list, PPMacro& macro_ref)
     }
     /** **********************************************************************/
 
+    if(pScopeClassifier != nullptr)
+    {
+        pScopeClassifier->MacroDefined(macro_ref.identifier);
+    }
+
     // set the scope category of macro as found from the clang front end
     //const std::string iden_token_str = macro_ref.get_identifier().get_value();
     //using the operator [] to read the value may insert a new entry
@@ -589,7 +724,7 @@ void Parser::PPIfHandler(Node& node, bool def)
 
     condStmt.push_back(*it);
     // FIXME: Why don't we just use this function to return a condcat?
-    if(PPCheckIdentifier(it->get_value(), globalMacros))
+    if(globalMacros->Contains(it->get_value()))
     {
         condCat = CondCategory::config;
     }
@@ -608,18 +743,65 @@ void Parser::PPIfHandler(Node& node, bool def)
     }
 }
 
-void Parser::ParseLocalMacros(std::string ifileStr, const position_type& pos)
+void Parser::ParseLocalMacros(std::string_view source, const position_type& pos)
 {
-    it = token_iterator(ifileStr.begin(), ifileStr.end(), pos,
-            boost::wave::language_support(boost::wave::support_cpp
-                                          | boost::wave::support_option_long_long
-                                          | boost::wave::support_option_emit_contnewlines));
-    it_begin = it;
-    it_end = token_iterator();
-
+    LexLocalMacros(source, pos);
     ParseMacros(localMacros);
 }
 
+void Parser::LexLocalMacros(std::string_view source, const position_type& pos)
+{
+    const auto language = boost::wave::language_support(boost::wave::support_cpp
+                                                        | boost::wave::support_option_long_long
+                                                        | boost::wave::support_option_emit_contnewlines);
+
+    // the scope classifier follows every brace, otherwise only the spans with
+    // directives, uses of the local macros and the lines where the postponed
+    // translations go (first invocation reported by clang) are lexed
+    SourceSpans spans;
+    if(pScopeClassifier == nullptr)
+    {
+        std::vector<std::size_t> keep_lines;
+        if(pASTMacroStat != nullptr)
+        {
+            for(auto const& [name, info] : *pASTMacroStat)
+            {
+                if(!info.invoked_lines.empty())
+                {
+                    keep_lines.push_back(info.invoked_lines.front());
+                }
+            }
+        }
+        spans = ScanSourceSpans(source, keep_lines);
+    }
+
+    if(spans.usable)
+    {
+        skipped_source_bytes = spans.skippedBytes;
+        if(pDemacroficationScheme->lexerThreads == 1)
+        {
+            tokens.Lex(MakeSpanTokenIterator(source, spans, pos, language, lexerBackend), lexer_iterator());
+        }
+        else
+        {
+            tokens.Assign(LexSpansInParallel(
+                    lexerBackend, source, spans, pos, language, pDemacroficationScheme->lexerThreads));
+        }
+    }
+    else if(pDemacroficationScheme->lexerThreads == 1)
+    {
+        // lexed in place, the contents end with the newline added by SourceBuffer
+        tokens.Lex(MakeLexerIterator(lexerBackend, source, pos, language), lexer_iterator());
+    }
+    else
+    {
+        tokens.Assign(LexInParallel(lexerBackend, source, pos, language, pDemacroficationScheme->lexerThreads));
+    }
+    it = it_begin = tokens.begin();
+    it_end = tokens.end();
+    sourceText = source;
+}
+
 void Parser::PPAnalyzeMacroDependency(std::ostream& os)
 {
     PPBuildMacroDependencyList(os);
@@ -651,8 +833,13 @@ void Parser::PPBuildMacroDependencyList(std::ostream& os)
 
 void Parser::GetDemacrofiedFile(std::ostream& os)
 {
-    os << outStream.str();
-    outStream.str(std::string());
+    splicePlan.Write(os, sourceText);
+    splicePlan.Clear();
+}
+
+SplicePlan Parser::TakeSplicePlan()
+{
+    return std::exchange(splicePlan, SplicePlan());
 }
 
 /// @todo when the multiple_definitions variable is already
@@ -668,37 +855,26 @@ void Parser::Demacrofy(std::ostream& stat, bool multiple_definitions_allowed)
     demac->SetMacroInvocationStat(pInvocationStat);
     demac->SetValidator(&pDemacroficationScheme->validatorMap.GetValidMacros());
 
+    // the output is the source with each #define replaced by its
+    // translation, the tokens in between are not copied
+    splicePlan.Clear();
+    demac->readyQueue.clear();
     it = it_begin;
 
-    using TokenMacroMap_t = std::multimap<token_type, PPMacro*>;
-    using PairMacroIter_t = std::pair<TokenMacroMap_t::iterator, TokenMacroMap_t::iterator>;
-
     while(it != it_end)
     {
-        std::size_t defn_counter = 0;
-
         if(auto id = boost::wave::token_id(*it); id == boost::wave::T_PP_DEFINE)
         {
+            const std::size_t define_begin = SourceOffset(it);
             it++;
             it++; //one for #define and the other for space
-            /// find the macro associated with this token and then pass the macro
-            /// find the macro corresponding to this identifier from the tree
-            /// since the tree returns entries from multimap, we have to
-            /// find the exact match by matching the location(position)
+            /// the tree records every definition at the position of its
+            /// identifier, so the exact macro is found without looking
+            /// at the other definitions of the same identifier
             /// FIXME: check if works for object_like macro only
             //  modify for function_like macro--check
-            auto pm_iter = pTree->GetMacro(*it);
-            /// to be looked for exact macro
-            PPMacro* m_ptr = nullptr;
-
-            std::for_each(pm_iter.first, pm_iter.second,
-                    [this, &m_ptr, &defn_counter](const std::pair<token_type, PPMacro*>& tm_pair) {
-                        ++defn_counter;
-                        if(tm_pair.first.get_position() == this->it->get_position())
-                        {
-                            m_ptr = tm_pair.second;
-                        }
-                    });
+            PPMacro* m_ptr = pTree->GetDefinition(*it);
+            const std::size_t defn_counter = pTree->GetMacro(*it).size();
 
             // if there was no match then throw error, although it is unlikely
             // FIXME: How unlikely?
@@ -730,32 +906,39 @@ void Parser::Demacrofy(std::ostream& stat, bool multiple_definitions_allowed)
                         demac->Translate(m_ptr, stat, pDemacroficationScheme->performCleanup, true);
             }
 
-            outStream << demacrofied_string;
-
             /// @todo call the observer class here for the compilation
             it = GoPastMacro(it);
+
+            // up to and with the newline (or comment) GoPastMacro stopped at
+            const std::size_t define_end = SourceOffset(it + 1);
+            splicePlan.Replace(define_begin, define_end, std::move(demacrofied_string));
+            SplicePostponedTranslations(define_end);
         }
-        else
-        {
-            //search if there is a postponed demacrofication for this line number
 
-            auto post_demac_iter = demac->readyQueue.find(it->get_position().get_line());
+        it++;
+    }
+}
 
-            if(post_demac_iter != demac->readyQueue.end())
-            {
-                //std::cout<<"\nline number:"<<it->get_position().get_line();
-                outStream << post_demac_iter->second;
+std::size_t Parser::SourceOffset(token_iterator tok_iter) const
+{
+    // the whole source is indexed once by the lexers, so the offsets of
+    // the positions are offsets into sourceText
+    return tok_iter == it_end ? sourceText.size() : tok_iter->get_position().get_offset();
+}
 
-                // remove that postponed demac string from the readyQueue
-                demac->readyQueue.erase(post_demac_iter);
-            }
-            /// handle postponed demacrofication here
-            outStream << it->get_value();
-            //std::cout<<"\nPrinting the demacrofied string::\n"<<demacrofied_string<<"\n\n";
+void Parser::SplicePostponedTranslations(std::size_t from)
+{
+    for(auto& [line, postponed] : demac->readyQueue)
+    {
+        // a line past the end resolves to the last line
+        const position_type line_start = it_begin->get_position().at_line_column(line, 1);
+        if(line_start.get_line() == line && line_start.get_offset() >= from)
+        {
+            splicePlan.Insert(line_start.get_offset(), std::move(postponed));
         }
-
-        it++;
     }
+    // the lines already passed are not revisited, as before
+    demac->readyQueue.clear();
 }
 
 token_iterator Parser::GoPastMacro(token_iterator it)
@@ -775,19 +958,46 @@ token_iterator Parser::GoPastMacro(token_iterator it)
     return it; //go back to point to the end of macro
 }
 
-MacTree const* Parser::GetMacTree()
+MacTree* Parser::GetMacTree()
 {
     assert(pTree);
     return pTree;
 }
 
-// FIXME: Memory leak.
+GlobalMacros_t const& Parser::GetGlobalMacros() const
+{
+    return globalMacros;
+}
+
+std::size_t Parser::GetMacroCount() const
+{
+    return macro_count;
+}
+
+std::size_t Parser::GetFunctionLikeCount() const
+{
+    return function_like_count;
+}
+
+std::size_t Parser::GetObjectLikeCount() const
+{
+    return object_like_count;
+}
+
+std::size_t Parser::GetSkippedSourceBytes() const
+{
+    return skipped_source_bytes;
+}
+
+std::vector<MacroStat> const& Parser::GetMacroStats() const
+{
+    return vec_macro_stat;
+}
+
 void Parser::InitializeMacTree()
 {
-    if(pTree != nullptr)
-    {
-        //delete pTree;
-        //pTree = NULL;
-    }
-    pTree = new MacTree;
+    // the previous tree goes with everything allocated along with it
+    pTree = nullptr;
+    pArena->Release();
+    pTree = pArena->Create<MacTree>(*pArena);
 }
\ No newline at end of file
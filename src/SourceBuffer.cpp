@@ -0,0 +1,81 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/SourceBuffer.h"
+
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+SourceBuffer::SourceBuffer(const std::filesystem::path& file_name)
+{
+    std::ifstream instream(file_name, std::ios_base::in);
+
+    if(!instream.is_open())
+    {
+        return;
+    }
+    isOpen = true;
+
+    // the size on disk is an upper bound of what a text mode read returns,
+    // the room for the newline avoids growing the buffer afterwards
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(file_name, ec);
+
+    if(ec)
+    {
+        contents.assign(std::istreambuf_iterator<char>(instream.rdbuf()), std::istreambuf_iterator<char>());
+    }
+    else
+    {
+        const auto size = static_cast<std::size_t>(file_size);
+        contents.reserve(size + 1);
+        contents.resize(size);
+        instream.read(contents.data(), static_cast<std::streamsize>(size));
+        contents.resize(static_cast<std::size_t>(instream.gcount()));
+    }
+    contents += '\n';
+
+    lineIndex = boost::wave::cpplexer::source_index(
+            file_name.string(), contents.data(), contents.data() + contents.size());
+}
+
+bool SourceBuffer::IsOpen() const
+{
+    return isOpen;
+}
+
+std::string_view SourceBuffer::GetContents() const
+{
+    return contents;
+}
+
+boost::wave::cpplexer::slex_position SourceBuffer::GetPosition() const
+{
+    return lineIndex.position();
+}
+
+void SourceBuffer::ReleaseLineIndex()
+{
+    lineIndex.release();
+}
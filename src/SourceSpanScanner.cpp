@@ -0,0 +1,727 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/SourceSpanScanner.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CPP2CXX_SPAN_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPP2CXX_SPAN_SCAN_SSE2 1
+#endif
+
+namespace
+{
+bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool IsHexDigit(char c)
+{
+    return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+/// characters of an identifier as the Wave lexer (non strict) sees them
+bool IsIdentChar(char c)
+{
+    return IsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$';
+}
+
+/**
+ * @class ByteSet
+ * @brief a set of bytes and of the ranges A-Z and a-z, searched 32 or 16
+ * bytes at a time when AVX2 or SSE2 is available
+ */
+class ByteSet
+{
+public:
+    void Add(char c)
+    {
+        needles[needleCount++] = c;
+        table[static_cast<unsigned char>(c)] = true;
+    }
+
+    void AddRange(char first, char last)
+    {
+        ranges[rangeCount++] = { first, last };
+        for(char c = first; c <= last; ++c)
+        {
+            table[static_cast<unsigned char>(c)] = true;
+        }
+    }
+
+    bool Contains(char c) const
+    {
+        return table[static_cast<unsigned char>(c)];
+    }
+
+    /// @brief the first byte in [p, end) which is in the set, or end
+    char const* Find(char const* p, char const* end) const
+    {
+#if defined(CPP2CXX_SPAN_SCAN_AVX2)
+        for(; end - p >= 32; p += 32)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+            __m256i hits = _mm256_setzero_si256();
+            for(std::size_t i = 0; i < needleCount; ++i)
+            {
+                hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(needles[i])));
+            }
+            for(std::size_t i = 0; i < rangeCount; ++i)
+            {
+                // signed compares, the bytes >= 0x80 are below any ascii range
+                hits = _mm256_or_si256(hits,
+                        _mm256_and_si256(
+                                _mm256_cmpgt_epi8(block, _mm256_set1_epi8(ranges[i].first - 1)),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(ranges[i].second + 1), block)));
+            }
+            if(const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)); mask != 0)
+            {
+                return p + std::countr_zero(mask);
+            }
+        }
+#elif defined(CPP2CXX_SPAN_SCAN_SSE2)
+        for(; end - p >= 16; p += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+            __m128i hits = _mm_setzero_si128();
+            for(std::size_t i = 0; i < needleCount; ++i)
+            {
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(needles[i])));
+            }
+            for(std::size_t i = 0; i < rangeCount; ++i)
+            {
+                // signed compares, the bytes >= 0x80 are below any ascii range
+                hits = _mm_or_si128(hits,
+                        _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(ranges[i].first - 1)),
+                                _mm_cmplt_epi8(block, _mm_set1_epi8(ranges[i].second + 1))));
+            }
+            if(const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits)); mask != 0)
+            {
+                return p + std::countr_zero(mask);
+            }
+        }
+#endif
+        while(p != end && !Contains(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+private:
+    std::array<bool, 256> table{};
+    std::array<char, 16> needles{};
+    std::size_t needleCount{ 0 };
+    std::array<std::pair<char, char>, 2> ranges{};
+    std::size_t rangeCount{ 0 };
+};
+
+/// @brief matches the escape sequences of the CHARLIT and STRINGLIT
+/// patterns of the lexer, p points to the backslash
+char const* MatchEscape(char const* p, char const* end)
+{
+    if(end - p < 2)
+    {
+        return nullptr;
+    }
+
+    const auto hex_digits = [p, end](std::ptrdiff_t count) -> char const* {
+        if(end - p < count + 2 || !std::all_of(p + 2, p + 2 + count, IsHexDigit))
+        {
+            return nullptr;
+        }
+        return p + 2 + count;
+    };
+
+    switch(p[1])
+    {
+    case 'a':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+    case 'v':
+    case '?':
+    case '\'':
+    case '"':
+    case '\\':
+        return p + 2;
+    case 'x':
+        return hex_digits(1);
+    case 'u':
+        return hex_digits(4);
+    case 'U':
+        return hex_digits(8);
+    default:
+        // the octal digits after the first one also match as plain characters
+        return p[1] >= '0' && p[1] <= '7' ? p + 2 : nullptr;
+    }
+}
+
+/// @brief one past the closing quote of the literal starting at p, null when
+/// the lexer doesn't match a literal there (the quote becomes a T_ANY then)
+char const* MatchLiteral(char const* p, char const* end)
+{
+    const char quote = *p;
+    std::size_t elements = 0;
+
+    for(++p; p != end; ++elements)
+    {
+        switch(*p)
+        {
+        case '\n':
+        case '\r':
+            return nullptr;
+        case '\\':
+            p = MatchEscape(p, end);
+            if(p == nullptr)
+            {
+                return nullptr;
+            }
+            break;
+        default:
+            if(*p == quote)
+            {
+                // a character literal has at least one character
+                return quote == '\'' && elements == 0 ? nullptr : p + 1;
+            }
+            ++p;
+            break;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @class SpanScanner
+ * @brief splits the contents at the newlines which are outside any token
+ * into units (a line with its continuation lines and the lines of the
+ * block comments starting on it), consecutive units of the same relevance
+ * are merged into one span
+ */
+class SpanScanner
+{
+public:
+    SpanScanner(std::string_view contents, std::vector<std::size_t> const& keep_lines)
+            : begin(contents.data()),
+              end(contents.data() + contents.size()),
+              keepLines(keep_lines)
+    {
+        std::sort(keepLines.begin(), keepLines.end());
+        BuildSets();
+    }
+
+    SourceSpans Scan()
+    {
+        // trigraphs may hide a backslash and a lone carriage return is a line
+        // break to the lexer, neither is worth modeling here
+        const std::string_view contents(begin, end - begin);
+        if(contents.find("??") != std::string_view::npos)
+        {
+            return std::move(result);
+        }
+        for(auto cr = contents.find('\r'); cr != std::string_view::npos; cr = contents.find('\r', cr + 1))
+        {
+            if(cr + 1 == contents.size() || contents[cr + 1] != '\n')
+            {
+                return std::move(result);
+            }
+        }
+
+        char const* p = begin;
+        while(p != end && !failed)
+        {
+            p = Step(tracking ? codeParensSet.Find(p, end) : codeSet.Find(p, end));
+        }
+
+        if(failed)
+        {
+            return SourceSpans();
+        }
+
+        if(unitBegin != end)
+        {
+            CloseUnit(end);
+        }
+        result.usable = true;
+        return std::move(result);
+    }
+
+private:
+    void BuildSets()
+    {
+        codeSet = ByteSet();
+        for(char c : { '\n', '"', '\'', '/', '\\', '#', '%' })
+        {
+            codeSet.Add(c);
+        }
+        // the identifier characters are only interesting when a macro name
+        // may start with them, digits are reached through the letters
+        for(char c : { '_', '$' })
+        {
+            if(otherCandidates.find(c) != std::string_view::npos)
+            {
+                codeSet.Add(c);
+            }
+        }
+        if(upperCandidates)
+        {
+            codeSet.AddRange('A', 'Z');
+        }
+        if(lowerCandidates)
+        {
+            codeSet.AddRange('a', 'z');
+        }
+
+        codeParensSet = codeSet;
+        codeParensSet.Add('(');
+        codeParensSet.Add(')');
+    }
+
+    /// @brief handles the byte at p, returns where the search goes on
+    char const* Step(char const* p)
+    {
+        if(p == end)
+        {
+            return end;
+        }
+
+        switch(*p)
+        {
+        case '\n':
+            ++line;
+            CloseUnit(p + 1);
+            return p + 1;
+        case '\\':
+            // a continuation line belongs to the same unit
+            if(p + 1 != end && p[1] == '\n')
+            {
+                ++line;
+                return p + 2;
+            }
+            if(end - p > 2 && p[1] == '\r' && p[2] == '\n')
+            {
+                ++line;
+                return p + 3;
+            }
+            return p + 1;
+        case '"':
+        case '\'':
+        {
+            char const* literal_end = MatchLiteral(p, end);
+            return literal_end != nullptr ? literal_end : p + 1;
+        }
+        case '/':
+            return SkipComment(p);
+        case '#':
+            relevant = true;
+            return ScanDirective(p + 1);
+        case '%':
+            if(p + 1 != end && p[1] == ':')
+            {
+                relevant = true;
+                return ScanDirective(p + 2);
+            }
+            return p + 1;
+        case '(':
+            ++parens;
+            return p + 1;
+        case ')':
+            --parens;
+            return p + 1;
+        default:
+            return ScanIdentifier(p);
+        }
+    }
+
+    char const* SkipComment(char const* p)
+    {
+        if(p + 1 == end)
+        {
+            return end;
+        }
+
+        if(p[1] == '/')
+        {
+            // the newline is part of the comment, but still ends the unit
+            return std::find(p + 2, end, '\n');
+        }
+
+        if(p[1] == '*')
+        {
+            // an unterminated comment is lexed as a '/' followed by a '*'
+            const std::string_view rest(p + 2, end - p - 2);
+            const auto close = rest.find("*/");
+            if(close == std::string_view::npos)
+            {
+                return p + 1;
+            }
+            char const* comment_end = p + 2 + close + 2;
+            line += std::count(p, comment_end, '\n');
+            return comment_end;
+        }
+
+        return p + 1;
+    }
+
+    /// @brief the blanks and block comments the lexer allows between
+    /// the '#' and the name of a directive
+    char const* SkipPPSpace(char const* p) const
+    {
+        while(p != end)
+        {
+            if(*p == ' ' || *p == '\t')
+            {
+                ++p;
+            }
+            else if(end - p > 1 && p[0] == '/' && p[1] == '*')
+            {
+                const std::string_view rest(p + 2, end - p - 2);
+                const auto close = rest.find("*/");
+                if(close == std::string_view::npos)
+                {
+                    return p;
+                }
+                p += close + 4;
+            }
+            else
+            {
+                return p;
+            }
+        }
+        return p;
+    }
+
+    bool StartsWith(char const* p, std::string_view word) const
+    {
+        return static_cast<std::size_t>(end - p) >= word.size()
+               && std::string_view(p, word.size()) == word;
+    }
+
+    /// @brief p is just past the '#', the names of the #define and #undef
+    /// become candidates, the header names are skipped as the lexer matches
+    /// them as a whole
+    char const* ScanDirective(char const* p)
+    {
+        char const* name = SkipPPSpace(p);
+        if(name != p)
+        {
+            line += std::count(p, name, '\n');
+        }
+
+        if(StartsWith(name, "define") || StartsWith(name, "undef"))
+        {
+            char const* id = name + (*name == 'd' ? 6 : 5);
+            while(id != end && (*id == ' ' || *id == '\t'))
+            {
+                ++id;
+            }
+            char const* id_end = id;
+            while(id_end != end && IsIdentChar(*id_end))
+            {
+                ++id_end;
+            }
+            if(id == id_end)
+            {
+                // e.g. a comment before the name, the parser might pick any
+                // token as the name of the macro
+                failed = true;
+                return end;
+            }
+            AddCandidate(std::string_view(id, id_end - id));
+            return id_end;
+        }
+
+        if(StartsWith(name, "include"))
+        {
+            char const* header = name + 7;
+            if(StartsWith(header, "_next"))
+            {
+                header += 5;
+            }
+            char const* header_begin = SkipPPSpace(header);
+            if(header_begin != end && (*header_begin == '"' || *header_begin == '<'))
+            {
+                const char close = *header_begin == '"' ? '"' : '>';
+                char const* header_end = header_begin + 1;
+                while(header_end != end && *header_end != close && *header_end != '\n'
+                        && *header_end != '\r')
+                {
+                    ++header_end;
+                }
+                if(header_end != end && *header_end == close && header_end != header_begin + 1)
+                {
+                    line += std::count(header, header_begin, '\n');
+                    return header_end + 1;
+                }
+            }
+        }
+
+        return name;
+    }
+
+    void AddCandidate(std::string_view name)
+    {
+        if(!candidates.insert(name).second)
+        {
+            return;
+        }
+
+        const char first = name.front();
+        if(first >= 'A' && first <= 'Z')
+        {
+            if(!std::exchange(upperCandidates, true))
+            {
+                BuildSets();
+            }
+        }
+        else if(first >= 'a' && first <= 'z')
+        {
+            if(!std::exchange(lowerCandidates, true))
+            {
+                BuildSets();
+            }
+        }
+        else if(otherCandidates.find(first) == std::string::npos)
+        {
+            otherCandidates += first;
+            BuildSets();
+        }
+    }
+
+    bool IsCandidate(char const* first, char const* last) const
+    {
+        return candidates.find(std::string_view(first, last - first)) != candidates.end();
+    }
+
+    /// @brief p is anywhere inside a run of identifier characters which
+    /// started after the last stop of the search
+    char const* ScanIdentifier(char const* p)
+    {
+        char const* first = p;
+        while(first != begin && IsIdentChar(first[-1]))
+        {
+            --first;
+        }
+        char const* last = p;
+        while(last != end && IsIdentChar(*last))
+        {
+            ++last;
+        }
+
+        bool found = IsCandidate(first, last);
+        // the lexer ends a number before a letter it can't take as a suffix
+        // (e.g. 1FOO), any identifier in the run may follow the number then
+        for(char const* c = first; !found && IsDigit(*first) && c != last; ++c)
+        {
+            found = !IsDigit(*c) && IsCandidate(c, last);
+        }
+
+        if(found)
+        {
+            // the use case of a function like macro is collected up to the
+            // closing paren, which may be several lines further
+            relevant = true;
+            tracking = true;
+        }
+        return last;
+    }
+
+    void CloseUnit(char const* unit_end)
+    {
+        const std::size_t last_line = line - 1;
+        while(nextKeepLine != keepLines.size() && keepLines[nextKeepLine] < unitLine)
+        {
+            ++nextKeepLine;
+        }
+        if(nextKeepLine != keepLines.size() && keepLines[nextKeepLine] <= last_line)
+        {
+            relevant = true;
+        }
+        relevant = relevant || tracking;
+        if(tracking && parens <= 0)
+        {
+            tracking = false;
+            parens = 0;
+        }
+
+        const auto unit_begin = static_cast<std::size_t>(unitBegin - begin);
+        const auto unit_size = static_cast<std::size_t>(unit_end - unitBegin);
+        if(!result.spans.empty() && result.spans.back().relevant == relevant)
+        {
+            result.spans.back().end = unit_begin + unit_size;
+        }
+        else
+        {
+            result.spans.push_back({ unit_begin, unit_begin + unit_size, unitLine, relevant });
+        }
+        if(!relevant)
+        {
+            result.skippedBytes += unit_size;
+        }
+
+        unitBegin = unit_end;
+        unitLine = line;
+        relevant = false;
+    }
+
+private:
+    char const* begin;
+    char const* end;
+    std::vector<std::size_t> keepLines;
+    std::size_t nextKeepLine{ 0 };
+
+    ByteSet codeSet;
+    ByteSet codeParensSet;
+    std::unordered_set<std::string_view> candidates;
+    bool upperCandidates{ false };
+    bool lowerCandidates{ false };
+    /// '_' and '$', digits can't start a name
+    std::string otherCandidates;
+
+    char const* unitBegin{ begin };
+    std::size_t unitLine{ 1 };
+    std::size_t line{ 1 };
+    bool relevant{ false };
+    bool tracking{ false };
+    int parens{ 0 };
+    bool failed{ false };
+
+    SourceSpans result;
+};
+
+/**
+ * @class SpanLexer
+ * @brief runs the lexer backend over each relevant span, the tokens look as if
+ * the whole file was lexed except for the skipped spans
+ */
+class SpanLexer : public lexer_interface
+{
+public:
+    SpanLexer(std::string_view contents, std::vector<SourceSpan> spans, position_type const& pos,
+            boost::wave::language_support language, LexerBackend backend)
+            : contents(contents),
+              spans(std::move(spans)),
+              base(pos.indexed(contents.data(), contents.data() + contents.size())),
+              language(language),
+              backend(backend)
+    {
+    }
+
+    token_type& get(token_type& result) override
+    {
+        using namespace boost::wave;
+
+        while(true)
+        {
+            if(lexer)
+            {
+                // the end of a span is not the end of the file
+                if(const auto id = token_id(lexer->get(result)); id != T_EOF && id != T_EOI)
+                {
+                    return result;
+                }
+                lexer.reset();
+            }
+
+            if(nextSpan == spans.size())
+            {
+                if(atEof)
+                {
+                    return result = token_type(); // T_EOI
+                }
+                // positioned after the last newline, as by the lexer
+                atEof = true;
+                return result = token_type(T_EOF, token_type::string_type(),
+                               Position(spans.empty() ? 0 : spans.back().end));
+            }
+
+            // the lexers of the spans share the line index of the contents
+            const SourceSpan& span = spans[nextSpan++];
+            char const* first = contents.data() + span.begin;
+            char const* last = contents.data() + span.end;
+            if(!span.relevant)
+            {
+                return result = token_type(T_ANY, token_type::string_type(first, last), Position(span.begin));
+            }
+
+            lexer.reset(NewLexer(backend, first, last, Position(span.begin), language));
+        }
+    }
+
+    void set_position(position_type const& new_pos) override
+    {
+        if(lexer)
+        {
+            lexer->set_position(new_pos);
+        }
+    }
+
+#if BOOST_WAVE_SUPPORT_PRAGMA_ONCE != 0
+    bool has_include_guards(std::string&) const override
+    {
+        return false;
+    }
+#endif
+
+private:
+    position_type Position(std::size_t offset) const
+    {
+        return base.at_offset(base.get_offset() + static_cast<std::uint32_t>(offset));
+    }
+
+    std::string_view contents;
+    std::vector<SourceSpan> spans;
+    std::size_t nextSpan{ 0 };
+    /// the start of the contents
+    position_type base;
+    boost::wave::language_support language;
+    LexerBackend backend;
+    std::unique_ptr<lexer_interface> lexer;
+    bool atEof{ false };
+};
+} // namespace
+
+SourceSpans ScanSourceSpans(std::string_view contents, std::vector<std::size_t> const& keep_lines)
+{
+    return SpanScanner(contents, keep_lines).Scan();
+}
+
+lexer_iterator MakeSpanTokenIterator(std::string_view contents, SourceSpans const& spans,
+        position_type const& pos, boost::wave::language_support language, LexerBackend backend)
+{
+    return lexer_iterator(new SpanLexer(contents, spans.spans, pos, language, backend));
+}
@@ -0,0 +1,175 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "cpp2cxx/SplicePlan.h"
+
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <utility>
+
+#if defined(_WIN32)
+// WriteFileGather only takes unbuffered writes of whole pages, the slices
+// are written one after the other into the stream buffer instead
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#endif
+
+void SplicePlan::Replace(std::size_t begin, std::size_t end, std::string fragment)
+{
+    edits.push_back({ begin, std::max(begin, end), std::move(fragment) });
+}
+
+void SplicePlan::Insert(std::size_t offset, std::string fragment)
+{
+    edits.push_back({ offset, offset, std::move(fragment) });
+}
+
+void SplicePlan::Clear()
+{
+    edits.clear();
+}
+
+std::size_t SplicePlan::GetEditCount() const
+{
+    return edits.size();
+}
+
+std::vector<std::string_view> SplicePlan::GetSlices(std::string_view source) const
+{
+    // an insertion sorts before a replacement at the same offset as its
+    // range is empty, the stable sort keeps the insertions in order
+    std::vector<Edit const*> sorted;
+    sorted.reserve(edits.size());
+    for(auto const& edit : edits)
+    {
+        sorted.push_back(&edit);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](Edit const* e1, Edit const* e2) {
+        return e1->begin != e2->begin ? e1->begin < e2->begin : e1->end < e2->end;
+    });
+
+    std::vector<std::string_view> slices;
+    slices.reserve(2 * sorted.size() + 1);
+    std::size_t cursor = 0;
+    for(Edit const* edit : sorted)
+    {
+        const std::size_t begin = std::clamp(edit->begin, cursor, source.size());
+        if(begin > cursor)
+        {
+            slices.push_back(source.substr(cursor, begin - cursor));
+        }
+        if(!edit->fragment.empty())
+        {
+            slices.push_back(edit->fragment);
+        }
+        cursor = std::clamp(edit->end, begin, source.size());
+    }
+    if(cursor < source.size())
+    {
+        slices.push_back(source.substr(cursor));
+    }
+
+    return slices;
+}
+
+void SplicePlan::Write(std::ostream& os, std::string_view source) const
+{
+    for(const auto slice : GetSlices(source))
+    {
+        os.write(slice.data(), static_cast<std::streamsize>(slice.size()));
+    }
+}
+
+bool SplicePlan::WriteFile(const std::filesystem::path& file_name, std::string_view source) const
+{
+    const auto slices = GetSlices(source);
+
+#if defined(_WIN32)
+    std::ofstream out(file_name, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if(!out.is_open())
+    {
+        return false;
+    }
+    for(const auto slice : slices)
+    {
+        out.write(slice.data(), static_cast<std::streamsize>(slice.size()));
+    }
+    return out.good();
+#else
+    const int fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    std::vector<iovec> iov;
+    iov.reserve(slices.size());
+    for(const auto slice : slices)
+    {
+        iov.push_back({ const_cast<char*>(slice.data()), slice.size() });
+    }
+
+    // at most IOV_MAX slices per call, a short write continues in the
+    // middle of a slice
+    bool written = true;
+    for(std::size_t next = 0; next < iov.size();)
+    {
+        const int count = static_cast<int>(std::min<std::size_t>(iov.size() - next, IOV_MAX));
+        const ssize_t result = ::writev(fd, iov.data() + next, count);
+        if(result < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            written = false;
+            break;
+        }
+        for(auto bytes = static_cast<std::size_t>(result); bytes != 0;)
+        {
+            const std::size_t step = std::min(bytes, iov[next].iov_len);
+            iov[next].iov_base = static_cast<char*>(iov[next].iov_base) + step;
+            iov[next].iov_len -= step;
+            bytes -= step;
+            if(iov[next].iov_len == 0)
+            {
+                ++next;
+            }
+        }
+        // the empty slices left after a short write
+        while(next < iov.size() && iov[next].iov_len == 0)
+        {
+            ++next;
+        }
+    }
+
+    return ::close(fd) == 0 && written;
+#endif
+}
@@ -0,0 +1,66 @@
+/**
+cpp2cxx is an open source software distributed under terms of the
+Apache2.0 licence.
+
+Copyrights remain with the original copyright holders.
+Use of this material is by permission and/or license.
+
+Copyright [2012] Aditya Kumar, Andrew Sutton, Bjarne Stroustrup
+          [2020] Thomas Figueroa
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpp2cxx/TokenArena.h"
+
+#include <utility>
+
+TokenArena::TokenArena()
+        : tokens(1)
+{
+}
+
+void TokenArena::Lex(lexer_iterator first, const lexer_iterator& last)
+{
+    // lexed aside so a throwing lexer leaves the previous tokens intact
+    std::vector<token_type> lexed;
+
+    for(; first != last; ++first)
+    {
+        lexed.push_back(*first);
+    }
+    // the eoi token after the last one
+    lexed.emplace_back();
+    tokens.swap(lexed);
+}
+
+void TokenArena::Assign(std::vector<token_type> lexed)
+{
+    tokens = std::move(lexed);
+    tokens.emplace_back();
+}
+
+token_iterator TokenArena::begin() const
+{
+    return tokens.data();
+}
+
+token_iterator TokenArena::end() const
+{
+    return tokens.data() + size();
+}
+
+std::size_t TokenArena::size() const
+{
+    return tokens.size() - 1;
+}
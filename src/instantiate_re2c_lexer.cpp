@@ -0,0 +1,37 @@
+/*=============================================================================
+    Boost.Wave: A Standard compliant C++ preprocessor library
+
+    Explicit instantiation of the re2c lexer generation function, used by
+    the wave lexer backend
+
+    http://www.boost.org/
+
+    Copyright (c) 2001-2012 Hartmut Kaiser. Distributed under the Boost 
+    Software License, Version 1.0. (See accompanying file 
+    LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "cpp_tokens.hpp"          // config data
+
+#if BOOST_WAVE_SEPARATE_LEXER_INSTANTIATION != 0
+
+#include <boost/wave/token_ids.hpp>
+#include <boost/wave/cpplexer/cpp_lex_token.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+//  The following file needs to be included only once throughout the whole
+//  program.
+#include <boost/wave/cpplexer/re2clex/cpp_re2c_lexer.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The Boost.Wave library instantiates the re2c lexer for the iterators of
+//  its string type only, the input files are lexed in place from their
+//  SourceBuffer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template struct boost::wave::cpplexer::new_lexer_gen<
+    char const*>;
+
+#endif // BOOST_WAVE_SEPARATE_LEXER_INSTANTIATION != 0
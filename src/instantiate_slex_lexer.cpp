@@ -44,4 +44,8 @@
 template struct boost::wave::cpplexer::slex::new_lexer_gen<
     std::string::iterator>;
 
+// the input files are lexed in place from their SourceBuffer
+template struct boost::wave::cpplexer::slex::new_lexer_gen<
+    char const*>;
+
 #endif // BOOST_WAVE_SEPARATE_LEXER_INSTANTIATION != 0
@@ -0,0 +1,130 @@
+/*=============================================================================
+    cpp2cxx: build time generator of the slex C++ lexer tables
+
+    Compiles the token regular expressions of cpp_slex_lexer.hpp into a dfa
+    and writes it as C++ tables (slex_dfa_tables.cpp), both with full rows
+    and compressed into byte classes, so the lexer doesn't have to compile
+    the regular expressions when the program starts.
+=============================================================================*/
+
+#include "cpp_tokens.hpp"          // config data
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <boost/wave/language_support.hpp>
+
+#include "slex/cpp_slex_lexer.hpp"
+
+namespace
+{
+using boost::spirit::classic::class_cell_t;
+using boost::spirit::classic::node_id_t;
+using boost::spirit::classic::uchar;
+
+// the entries equal to T(-1) are written as invalid_name, if there is one
+template <typename T>
+void write_table(std::ostream& out, char const* type, std::string const& name,
+    std::vector<T> const& table, char const* invalid_name)
+{
+    out << "constexpr " << type << " " << name << "[] = {";
+    for (std::size_t i = 0; i < table.size(); ++i)
+    {
+        out << (i % 16 == 0 ? "\n    " : " ");
+        if (invalid_name && table[i] == T(-1))
+            out << invalid_name << ",";
+        else
+            out << unsigned(table[i]) << ",";
+    }
+    out << "\n};\n\n";
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace boost::wave;
+
+    if (argc != 2)
+    {
+        std::cerr << "usage: slex_dfa_generator <output file>\n";
+        return 1;
+    }
+
+    // the language used by the Parser and the pre-scan
+    const language_support language = language_support(support_cpp
+        | support_option_long_long | support_option_emit_contnewlines);
+
+    cpplexer::slex::lexer::lexer<char const*, util::file_position_type> lexer(
+        boost::spirit::classic::dfa_layout::full_rows);
+    lexer.init_dfa(language);
+    lexer.create_dfa();
+
+    const auto& dfa = lexer.get_dfa();
+
+    std::ofstream out(argv[1], std::ios::out | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "slex_dfa_generator: could not open " << argv[1] << "\n";
+        return 1;
+    }
+
+    out << "// generated by slex_dfa_generator, do not edit\n\n"
+        << "#include \"slex/slex_dfa_tables.hpp\"\n\n"
+        << "namespace boost {\nnamespace wave {\nnamespace cpplexer {\nnamespace slex {\n\n"
+        << "namespace\n{\n"
+        << "using boost::spirit::classic::class_cell_t;\n"
+        << "using boost::spirit::classic::node_id_t;\n"
+        << "using boost::spirit::classic::uchar;\n"
+        << "constexpr node_id_t X = boost::spirit::classic::invalid_node;\n"
+        << "constexpr class_cell_t XC = boost::spirit::classic::invalid_cell;\n\n";
+
+    std::vector<unsigned int> row_shift(dfa.size());
+    for (std::size_t state = 0; state < dfa.size(); ++state)
+    {
+        auto const suffix = std::to_string(state);
+
+        // the transition table is flattened, 256 entries per dfa node
+        std::vector<node_id_t> transitions;
+        for (auto const& row : dfa[state].transition_table)
+            transitions.insert(transitions.end(), row.begin(), row.end());
+
+        write_table(out, "node_id_t", "transitions_" + suffix, transitions, "X");
+        write_table(out, "node_id_t", "acceptance_" + suffix, dfa[state].acceptance_index, "X");
+
+        // and compressed into byte classes
+        std::vector<uchar> byte_class;
+        std::vector<class_cell_t> cells;
+        if (!boost::spirit::classic::lexerimpl::compress_transition_table(
+                dfa[state].transition_table, byte_class, cells, row_shift[state]))
+        {
+            std::cerr << "slex_dfa_generator: too many dfa nodes for the byte class tables\n";
+            return 1;
+        }
+
+        write_table(out, "class_cell_t", "class_transitions_" + suffix, cells, "XC");
+        write_table(out, "uchar", "byte_class_" + suffix, byte_class, nullptr);
+    }
+
+    out << "} // namespace\n\n"
+        << "extern const boost::spirit::classic::lexer_static_dfa static_dfa_tables[] = {\n";
+    for (std::size_t state = 0; state < dfa.size(); ++state)
+    {
+        out << "    { { transitions_" << state << " }, acceptance_" << state << " },\n";
+    }
+    out << "};\n\n"
+        << "extern const boost::spirit::classic::lexer_class_dfa static_class_dfa_tables[] = {\n";
+    for (std::size_t state = 0; state < dfa.size(); ++state)
+    {
+        out << "    { { class_transitions_" << state << ", byte_class_" << state << ", "
+            << row_shift[state] << " }, acceptance_" << state << " },\n";
+    }
+    out << "};\n\n"
+        << "extern const unsigned int static_dfa_num_states = " << dfa.size() << ";\n"
+        << "extern const unsigned int static_dfa_language = "
+        << cpplexer::slex::dfa_language(language) << ";\n\n"
+        << "}   // namespace slex\n}   // namespace cpplexer\n}   // namespace wave\n}   // namespace boost\n";
+
+    return out.good() ? 0 : 1;
+}